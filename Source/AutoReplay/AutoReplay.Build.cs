@@ -38,7 +38,11 @@ public class AutoReplay : ModuleRules
 				"DeveloperSettings",
 				"InputCore",
 				"Json",
-				"JsonUtilities"
+				"JsonUtilities",
+				"Networking",
+				"RenderCore",
+				"RHI",
+				"Sockets"
 			}
 		);
 	}
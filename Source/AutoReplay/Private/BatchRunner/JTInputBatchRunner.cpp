@@ -0,0 +1,554 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "BatchRunner/JTInputBatchRunner.h"
+
+#include "JTAutoReplayCommonTypes.h"
+#include "JTAutoReplayProfiling.h"
+#include "InputPlayer/JTInputPlayer.h"
+#include "ReplayFarm/JTReplayFarmConnection.h"
+
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformTime.h"
+#include "JsonObjectConverter.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+DEFINE_LOG_CATEGORY(LogJTInputBatchRunner);
+
+void UJTInputBatchRunner::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UJTInputBatchRunner::OnPostLoadMap);
+	if (GEngine)
+	{
+		TravelFailureHandle = GEngine->OnTravelFailure().AddUObject(this, &UJTInputBatchRunner::OnTravelFailure);
+	}
+
+	// There is no world to play in yet, so command line batches (and farm workers) are started on the first tick
+	if (FParse::Value(FCommandLine::Get(), TEXT("JTReplayWorker="), ReplayFarmAddress))
+	{
+		FParse::Value(FCommandLine::Get(), TEXT("JTReplayWorkerId="), ReplayFarmWorkerId);
+	}
+	else if (FParse::Value(FCommandLine::Get(), TEXT("JTReplayBatch="), PendingCommandLineRequestParams.Source))
+	{
+		FParse::Value(FCommandLine::Get(), TEXT("JTReplayMap="), PendingCommandLineRequestParams.DefaultMap);
+		FParse::Value(FCommandLine::Get(), TEXT("JTReplaySummary="), PendingCommandLineRequestParams.SummaryFilePath);
+		PendingCommandLineRequestParams.bExitWhenFinished = true;
+		bHasPendingCommandLineBatch = true;
+	}
+}
+
+void UJTInputBatchRunner::Deinitialize()
+{
+	Super::Deinitialize();
+
+	if (IsRunningBatch())
+	{
+		CancelBatch();
+	}
+
+	ReplayFarmConnection.Reset();
+
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	if (GEngine)
+	{
+		GEngine->OnTravelFailure().Remove(TravelFailureHandle);
+	}
+}
+
+void UJTInputBatchRunner::Tick(float DeltaTime)
+{
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	if (bHasPendingCommandLineBatch && GetWorld())
+	{
+		bHasPendingCommandLineBatch = false;
+		if (!RunBatch(PendingCommandLineRequestParams))
+		{
+			FPlatformMisc::RequestExitWithStatus(false, 1);
+		}
+
+		return;
+	}
+
+	if (IsReplayFarmWorker() && GetWorld())
+	{
+		TickReplayFarmWorker();
+	}
+
+	if (State == EState::PendingPlay)
+	{
+		StartPlayingCurrentSession();
+	}
+	else if (State == EState::Playing)
+	{
+		TickCurrentSession();
+	}
+}
+
+TStatId UJTInputBatchRunner::GetStatId() const
+{
+	return GET_STATID(STAT_JTInputBatchRunner_Tick);
+}
+
+bool UJTInputBatchRunner::RunBatch(const FJTInputBatchRequestParams RequestParams)
+{
+	if (IsRunningBatch())
+	{
+		CancelBatch();
+	}
+
+	FJTInputBatchManifest Manifest;
+	if (!LoadManifest(RequestParams.Source, Manifest))
+	{
+		UE_LOG(LogJTInputBatchRunner, Error, TEXT("Cannot run batch. Unable to read any sessions from %s"), *RequestParams.Source);
+		return false;
+	}
+
+	if (!RequestParams.DefaultMap.IsEmpty())
+	{
+		Manifest.DefaultMap = RequestParams.DefaultMap;
+	}
+
+	CachedCurrentRequestParams = RequestParams;
+	CurrentManifest = MoveTemp(Manifest);
+	CurrentSummary = FJTInputBatchSummary();
+	CurrentEntryIndex = INDEX_NONE;
+	BatchStartTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogJTInputBatchRunner, Log, TEXT("Batch Started with %d sessions"), CurrentManifest.Sessions.Num());
+
+	StartNextSession();
+	return true;
+}
+
+void UJTInputBatchRunner::CancelBatch()
+{
+	if (!IsRunningBatch())
+	{
+		return;
+	}
+
+	UE_LOG(LogJTInputBatchRunner, Log, TEXT("Batch Cancelled"));
+
+	if (UJTInputPlayer* InputPlayer = CurrentInputPlayer.Get())
+	{
+		InputPlayer->StopPlaying();
+	}
+
+	FinishCurrentSession(false, TEXT("Batch was cancelled"));
+
+	// Skip all remaining sessions
+	CurrentEntryIndex = CurrentManifest.Sessions.Num();
+	FinishBatch();
+}
+
+bool UJTInputBatchRunner::LoadManifest(const FString& InSource, FJTInputBatchManifest& OutManifest)
+{
+	FString SourcePath = InSource;
+	if (FPaths::IsRelative(SourcePath) && !FPaths::FileExists(SourcePath) && !FPaths::DirectoryExists(SourcePath))
+	{
+		SourcePath = FPaths::Combine(UJTAutoReplaySettings::GetSettings()->RecordingSessionExportDirectory, InSource);
+	}
+
+	if (FPaths::DirectoryExists(SourcePath))
+	{
+		TArray<FString> SessionFileNames;
+		IFileManager::Get().FindFiles(SessionFileNames, *FPaths::Combine(SourcePath, TEXT("*.json")), true, false);
+		IFileManager::Get().FindFiles(SessionFileNames, *FPaths::Combine(SourcePath, TEXT("*.jtirs")), true, false);
+		SessionFileNames.Sort();
+
+		for (const FString& SessionFileName : SessionFileNames)
+		{
+			// Later segments of a segmented session (Name_001.jtirs etc.) are played through their first segment
+			const FString BaseFileName = FPaths::GetBaseFilename(SessionFileName);
+			int32 SegmentSeparatorIndex = INDEX_NONE;
+			if (BaseFileName.FindLastChar(TEXT('_'), SegmentSeparatorIndex) && BaseFileName.RightChop(SegmentSeparatorIndex + 1).IsNumeric())
+			{
+				const FString FirstSegmentFileName = (BaseFileName.Left(SegmentSeparatorIndex) + TEXT(".") + FPaths::GetExtension(SessionFileName));
+				if (SessionFileNames.Contains(FirstSegmentFileName))
+				{
+					continue;
+				}
+			}
+
+			FJTInputBatchEntry& Entry = OutManifest.Sessions.AddDefaulted_GetRef();
+			Entry.SessionFile = FPaths::Combine(SourcePath, SessionFileName);
+		}
+	}
+	else
+	{
+		FString ManifestJsonString;
+		if (!FFileHelper::LoadFileToString(ManifestJsonString, *SourcePath))
+		{
+			return false;
+		}
+
+		if (!FJsonObjectConverter::JsonObjectStringToUStruct<FJTInputBatchManifest>(ManifestJsonString, &OutManifest))
+		{
+			return false;
+		}
+	}
+
+	return !OutManifest.Sessions.IsEmpty();
+}
+
+bool UJTInputBatchRunner::SaveSummary(const FJTInputBatchSummary& InSummary, const FString& InFilePath)
+{
+	FString SummaryJsonString;
+	if (!FJsonObjectConverter::UStructToJsonObjectString<FJTInputBatchSummary>(InSummary, SummaryJsonString))
+	{
+		return false;
+	}
+
+	return FFileHelper::SaveStringToFile(SummaryJsonString, *InFilePath);
+}
+
+void UJTInputBatchRunner::StartNextSession()
+{
+	++CurrentEntryIndex;
+	if (!CurrentManifest.Sessions.IsValidIndex(CurrentEntryIndex))
+	{
+		// Farm workers never finish, they idle until the orchestrator hands out another session
+		if (IsReplayFarmWorker())
+		{
+			--CurrentEntryIndex;
+			State = EState::Idle;
+			return;
+		}
+
+		FinishBatch();
+		return;
+	}
+
+	const FJTInputBatchEntry& Entry = CurrentManifest.Sessions[CurrentEntryIndex];
+	const FString& Map = (Entry.Map.IsEmpty() ? CurrentManifest.DefaultMap : Entry.Map);
+
+	FJTInputBatchResult& Result = CurrentSummary.Results.AddDefaulted_GetRef();
+	Result.SessionFile = Entry.SessionFile;
+	Result.Map = Map;
+	Result.WorkerId = ReplayFarmWorkerId;
+
+	bHasCurrentSessionStopped = false;
+	bHasCurrentSessionFailedToLoad = false;
+	bHasCurrentSessionFailedToStart = false;
+	SessionStartTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogJTInputBatchRunner, Log, TEXT("Batch session %d/%d: %s"), (CurrentEntryIndex + 1), CurrentManifest.Sessions.Num(), *Entry.SessionFile);
+	TRACE_BOOKMARK(TEXT("AutoReplay Batch Session %d: %s"), (CurrentEntryIndex + 1), *Entry.SessionFile);
+
+	if (Map.IsEmpty())
+	{
+		State = EState::PendingPlay;
+		return;
+	}
+
+	// Every session gets a freshly opened map, so that no state leaks over from the previous one
+	State = EState::LoadingMap;
+	UGameplayStatics::OpenLevel(GetWorld(), FName(*Map));
+}
+
+void UJTInputBatchRunner::StartPlayingCurrentSession()
+{
+	UWorld* World = GetWorld();
+	UJTInputPlayer* InputPlayer = (World ? World->GetSubsystem<UJTInputPlayer>() : nullptr);
+	if (!IsValid(InputPlayer))
+	{
+		FinishCurrentSession(false, TEXT("No input player in the current world"));
+		StartNextSession();
+		return;
+	}
+
+	const FJTInputBatchEntry& Entry = CurrentManifest.Sessions[CurrentEntryIndex];
+
+	FJTInputPlayerRequestParams PlayerRequestParams;
+	PlayerRequestParams.RecordingFilePath.FilePath = Entry.SessionFile;
+	PlayerRequestParams.StartFrame = Entry.StartFrame;
+	PlayerRequestParams.NumTimesToPlay = FMath::Max(Entry.NumTimesToPlay, 1);
+	PlayerRequestParams.bRestorePlayerSpatialDataOnStart = Entry.bRestorePlayerSpatialDataOnStart;
+	PlayerRequestParams.bCapturePerformance = Entry.bCapturePerformance;
+	PlayerRequestParams.bStopOnDivergence = Entry.bFailOnDivergence;
+	PlayerRequestParams.TimeStep = Entry.TimeStep;
+	PlayerRequestParams.bTurbo = Entry.bTurbo;
+
+	CurrentInputPlayer = InputPlayer;
+	InputPlayer->OnStartedPlaying.AddDynamic(this, &UJTInputBatchRunner::OnInputPlayerStarted);
+	InputPlayer->OnStoppedPlaying.AddDynamic(this, &UJTInputBatchRunner::OnInputPlayerStopped);
+	InputPlayer->OnFailedToLoadSession.AddDynamic(this, &UJTInputBatchRunner::OnInputPlayerFailedToLoadSession);
+	InputPlayer->OnFailedToStartPlaying.AddDynamic(this, &UJTInputBatchRunner::OnInputPlayerFailedToStart);
+	InputPlayer->OnPlaybackDiverged.AddDynamic(this, &UJTInputBatchRunner::OnInputPlayerDiverged);
+
+	SessionStartFrame = GFrameCounter;
+	State = EState::Playing;
+
+	InputPlayer->RequestPlay(PlayerRequestParams);
+}
+
+void UJTInputBatchRunner::TickCurrentSession()
+{
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputBatchRunner_TickCurrentSession);
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	UJTInputPlayer* InputPlayer = CurrentInputPlayer.Get();
+	if (!InputPlayer)
+	{
+		FinishCurrentSession(false, TEXT("The world was torn down while playing"));
+		StartNextSession();
+		return;
+	}
+
+	if (bHasCurrentSessionFailedToLoad)
+	{
+		FinishCurrentSession(false, TEXT("Unable to load session"));
+		StartNextSession();
+		return;
+	}
+
+	// Also reported when a later loop could not be started, after earlier loops stopped successfully
+	if (bHasCurrentSessionFailedToStart)
+	{
+		FinishCurrentSession(false, TEXT("Play could not be started (e.g. spatial data could not be restored)"));
+		StartNextSession();
+		return;
+	}
+
+	const float TimeoutSeconds = CurrentManifest.Sessions[CurrentEntryIndex].TimeoutSeconds;
+	if (TimeoutSeconds > 0.f && (FPlatformTime::Seconds() - SessionStartTime) >= TimeoutSeconds)
+	{
+		InputPlayer->StopPlaying();
+		FinishCurrentSession(false, TEXT("Timed out"));
+		StartNextSession();
+		return;
+	}
+
+	// Stopping is also broadcast between loops, so the session is only done once nothing is left to play. Starting
+	// a loop clears the stopped flag, so only a stop of the last loop that started counts as success
+	if (!InputPlayer->IsPlaying())
+	{
+		const FJTInputBatchResult& Result = CurrentSummary.Results[CurrentEntryIndex];
+		if (Result.bDiverged && CurrentManifest.Sessions[CurrentEntryIndex].bFailOnDivergence)
+		{
+			FinishCurrentSession(false, FString::Printf(TEXT("Diverged from the recording at frame %d"), Result.Divergence.Frame));
+		}
+		else if (bHasCurrentSessionStopped)
+		{
+			FinishCurrentSession(true, FString());
+		}
+		else
+		{
+			FinishCurrentSession(false, TEXT("Play could not be started (e.g. spatial data could not be restored)"));
+		}
+
+		StartNextSession();
+	}
+}
+
+void UJTInputBatchRunner::FinishCurrentSession(bool bSucceeded, const FString& InFailureReason)
+{
+	if (!CurrentSummary.Results.IsValidIndex(CurrentEntryIndex))
+	{
+		return;
+	}
+
+	FJTInputBatchResult& Result = CurrentSummary.Results[CurrentEntryIndex];
+	Result.bSucceeded = bSucceeded;
+	Result.FailureReason = InFailureReason;
+	Result.WallTimeSeconds = (FPlatformTime::Seconds() - SessionStartTime);
+
+	if (State == EState::Playing)
+	{
+		Result.NumFrames = static_cast<int64>(GFrameCounter - SessionStartFrame);
+		if (const UJTInputPlayer* InputPlayer = CurrentInputPlayer.Get())
+		{
+			Result.NumEvents = InputPlayer->GetNumInjectedEvents();
+			Result.PerfCaptureFile = InputPlayer->GetPerfCaptureFilePath();
+		}
+	}
+
+	if (bSucceeded)
+	{
+		++CurrentSummary.NumSucceeded;
+		UE_LOG(LogJTInputBatchRunner, Log, TEXT("Batch session %s succeeded (%.2fs)"), *Result.SessionFile, Result.WallTimeSeconds);
+	}
+	else
+	{
+		++CurrentSummary.NumFailed;
+		UE_LOG(LogJTInputBatchRunner, Error, TEXT("Batch session %s failed: %s"), *Result.SessionFile, *InFailureReason);
+	}
+
+	if (ReplayFarmConnection.IsValid())
+	{
+		FString ResultJsonString;
+		FJsonObjectConverter::UStructToJsonObjectString<FJTInputBatchResult>(Result, ResultJsonString, 0, 0, 0, nullptr, false);
+		if (!ReplayFarmConnection->Send(JT::AutoReplay::ReplayFarm::ResultMessage, ResultJsonString))
+		{
+			// The worker notices the lost connection (and exits) the next time it ticks
+			UE_LOG(LogJTInputBatchRunner, Error, TEXT("Replay farm worker %d unable to report the result of %s"), ReplayFarmWorkerId, *Result.SessionFile);
+		}
+	}
+
+	UnbindInputPlayer();
+	State = EState::Idle;
+}
+
+void UJTInputBatchRunner::FinishBatch()
+{
+	State = EState::Idle;
+	CurrentSummary.TotalWallTimeSeconds = (FPlatformTime::Seconds() - BatchStartTime);
+
+	FString SummaryFilePath = CachedCurrentRequestParams.SummaryFilePath;
+	if (SummaryFilePath.IsEmpty())
+	{
+		SummaryFilePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("AutoReplay"),
+			FString::Printf(TEXT("BatchSummary_%s.json"), *FDateTime::Now().ToString()));
+	}
+
+	if (SaveSummary(CurrentSummary, SummaryFilePath))
+	{
+		UE_LOG(LogJTInputBatchRunner, Log, TEXT("Batch summary written to %s"), *SummaryFilePath);
+	}
+	else
+	{
+		UE_LOG(LogJTInputBatchRunner, Error, TEXT("Batch summary could not be written to %s"), *SummaryFilePath);
+	}
+
+	UE_LOG(LogJTInputBatchRunner, Log, TEXT("Batch Finished. %d succeeded, %d failed"), CurrentSummary.NumSucceeded, CurrentSummary.NumFailed);
+
+	if (CachedCurrentRequestParams.bExitWhenFinished)
+	{
+		FPlatformMisc::RequestExitWithStatus(false, (CurrentSummary.NumFailed > 0 ? 1 : 0));
+	}
+}
+
+void UJTInputBatchRunner::TickReplayFarmWorker()
+{
+	using namespace JT::AutoReplay::ReplayFarm;
+
+	if (!ReplayFarmConnection.IsValid())
+	{
+		ReplayFarmConnection = MakeShareable(FConnection::Connect(ReplayFarmAddress).Release());
+		if (!ReplayFarmConnection.IsValid() || !ReplayFarmConnection->Send(HelloMessage, FString::FromInt(ReplayFarmWorkerId)))
+		{
+			UE_LOG(LogJTInputBatchRunner, Error, TEXT("Replay farm worker %d unable to connect to %s"), ReplayFarmWorkerId, *ReplayFarmAddress);
+			ReplayFarmAddress.Empty();
+			ReplayFarmConnection.Reset();
+			FPlatformMisc::RequestExitWithStatus(false, 1);
+			return;
+		}
+
+		BatchStartTime = FPlatformTime::Seconds();
+		UE_LOG(LogJTInputBatchRunner, Log, TEXT("Replay farm worker %d connected to %s"), ReplayFarmWorkerId, *ReplayFarmAddress);
+	}
+
+	TArray<FMessage> Messages;
+	if (!ReplayFarmConnection->Receive(Messages))
+	{
+		// Without an orchestrator there is nobody left to report to
+		UE_LOG(LogJTInputBatchRunner, Error, TEXT("Replay farm worker %d lost its connection"), ReplayFarmWorkerId);
+		ReplayFarmAddress.Empty();
+		ReplayFarmConnection.Reset();
+		FPlatformMisc::RequestExitWithStatus(false, 1);
+		return;
+	}
+
+	for (const FMessage& Message : Messages)
+	{
+		if (Message.Type == RunMessage)
+		{
+			FJTInputBatchEntry Entry;
+			if (!FJsonObjectConverter::JsonObjectStringToUStruct<FJTInputBatchEntry>(Message.Payload, &Entry))
+			{
+				UE_LOG(LogJTInputBatchRunner, Error, TEXT("Replay farm worker %d received an invalid session: %s"), ReplayFarmWorkerId, *Message.Payload);
+				continue;
+			}
+
+			CurrentManifest.Sessions.Emplace(MoveTemp(Entry));
+			if (State == EState::Idle)
+			{
+				StartNextSession();
+			}
+		}
+		else if (Message.Type == ExitMessage)
+		{
+			UE_LOG(LogJTInputBatchRunner, Log, TEXT("Replay farm worker %d exiting. %d succeeded, %d failed"),
+				ReplayFarmWorkerId, CurrentSummary.NumSucceeded, CurrentSummary.NumFailed);
+
+			ReplayFarmAddress.Empty();
+			ReplayFarmConnection.Reset();
+			FPlatformMisc::RequestExitWithStatus(false, 0);
+			return;
+		}
+	}
+}
+
+void UJTInputBatchRunner::UnbindInputPlayer()
+{
+	if (UJTInputPlayer* InputPlayer = CurrentInputPlayer.Get())
+	{
+		InputPlayer->OnStartedPlaying.RemoveAll(this);
+		InputPlayer->OnStoppedPlaying.RemoveAll(this);
+		InputPlayer->OnFailedToLoadSession.RemoveAll(this);
+		InputPlayer->OnFailedToStartPlaying.RemoveAll(this);
+		InputPlayer->OnPlaybackDiverged.RemoveAll(this);
+	}
+
+	CurrentInputPlayer.Reset();
+}
+
+void UJTInputBatchRunner::OnPostLoadMap(UWorld* InLoadedWorld)
+{
+	if (State == EState::LoadingMap)
+	{
+		State = EState::PendingPlay;
+	}
+}
+
+void UJTInputBatchRunner::OnTravelFailure(UWorld* InWorld, ETravelFailure::Type InFailureType, const FString& InErrorString)
+{
+	if (State == EState::LoadingMap)
+	{
+		FinishCurrentSession(false, FString::Printf(TEXT("Unable to open map: %s"), *InErrorString));
+		StartNextSession();
+	}
+}
+
+void UJTInputBatchRunner::OnInputPlayerStarted()
+{
+	bHasCurrentSessionStopped = false;
+}
+
+void UJTInputBatchRunner::OnInputPlayerStopped()
+{
+	bHasCurrentSessionStopped = true;
+}
+
+void UJTInputBatchRunner::OnInputPlayerFailedToLoadSession(const FString& FilePath)
+{
+	bHasCurrentSessionFailedToLoad = true;
+}
+
+void UJTInputBatchRunner::OnInputPlayerFailedToStart(const FString& FilePath)
+{
+	bHasCurrentSessionFailedToStart = true;
+}
+
+void UJTInputBatchRunner::OnInputPlayerDiverged(const FJTInputPlaybackDivergence& Divergence)
+{
+	// Only the first divergence is kept, since anything after it is likely fallout from it
+	FJTInputBatchResult& Result = CurrentSummary.Results[CurrentEntryIndex];
+	if (!Result.bDiverged)
+	{
+		Result.bDiverged = true;
+		Result.Divergence = Divergence;
+	}
+}
@@ -0,0 +1,660 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "Benchmark/JTInputBenchmark.h"
+
+#include "InputSerializer/JTInputSerializer.h"
+#include "JTAutoReplayCommonTypes.h"
+
+#include "Algo/Compare.h"
+#include "Algo/Sort.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "InputCoreTypes.h"
+#include "JsonObjectConverter.h"
+#include "Math/RandomStream.h"
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY(LogJTInputBenchmark);
+
+namespace
+{
+	struct FSyntheticEvent
+	{
+		FJTFrameDelta FrameDelta = 0;
+		bool bIsAxis = false;
+		FJTInputKeyEventArgs KeyEventArgs;
+		FJTInputAxisEventArgs AxisEventArgs;
+	};
+
+	const TArray<FKey>& GetSyntheticKeys()
+	{
+		static const TArray<FKey> SyntheticKeys = {
+			EKeys::W, EKeys::A, EKeys::S, EKeys::D, EKeys::SpaceBar, EKeys::LeftShift, EKeys::E, EKeys::R,
+			EKeys::LeftMouseButton, EKeys::RightMouseButton, EKeys::Gamepad_FaceButton_Bottom, EKeys::Gamepad_FaceButton_Right };
+		return SyntheticKeys;
+	}
+
+	/** Matches the input recorder's default SpatialCheckpointIntervalFrames */
+	static constexpr int32 SyntheticCheckpointIntervalFrames = 60;
+
+	/** The precision the binary format quantizes each part of the spatial data and delta times to (see JTInputBinaryFormat.cpp) */
+	static constexpr double LocationTolerance = 0.01;
+	static constexpr double QuatTolerance = 0.00001;
+	static constexpr double ScaleTolerance = 0.0001;
+	static constexpr double ControlRotationTolerance = 0.0001;
+	static constexpr double VelocityTolerance = 0.01;
+	static constexpr float DeltaSecondsTolerance = 0.000002f;
+
+	/** Event payloads are stored as is, so this only absorbs float to text conversions */
+	static constexpr float PayloadTolerance = 0.000001f;
+
+	const TArray<FKey>& GetSyntheticAxes()
+	{
+		static const TArray<FKey> SyntheticAxes = {
+			EKeys::MouseX, EKeys::MouseY, EKeys::Gamepad_LeftX, EKeys::Gamepad_LeftY, EKeys::Gamepad_RightX, EKeys::Gamepad_RightY };
+		return SyntheticAxes;
+	}
+
+	void GenerateEvents(const FJTInputBenchmarkParams& InParams, TArray<FSyntheticEvent>& OutEvents)
+	{
+		const TArray<FKey>& SyntheticKeys = GetSyntheticKeys();
+		const TArray<FKey>& SyntheticAxes = GetSyntheticAxes();
+
+		FRandomStream RandomStream(InParams.Seed);
+
+		// Keys are released if they are held, and pressed if they aren't, so that the session looks like real play
+		TArray<TBitArray<>> PlayersHeldKeys;
+		PlayersHeldKeys.Init(TBitArray<>(false, SyntheticKeys.Num()), InParams.NumPlayers);
+
+		// Fractional events per frame are carried over, and staggered per player
+		TArray<float> PlayersEventCarry;
+		for (int32 PlayerIndex = 0; PlayerIndex < InParams.NumPlayers; ++PlayerIndex)
+		{
+			PlayersEventCarry.Add(RandomStream.FRand());
+		}
+
+		OutEvents.Reset();
+		OutEvents.Reserve(FMath::CeilToInt32(InParams.DurationFrames * InParams.EventsPerFrame * InParams.NumPlayers));
+
+		for (int32 Frame = 0; Frame < InParams.DurationFrames; ++Frame)
+		{
+			for (int32 PlayerIndex = 0; PlayerIndex < InParams.NumPlayers; ++PlayerIndex)
+			{
+				PlayersEventCarry[PlayerIndex] += InParams.EventsPerFrame;
+				while (PlayersEventCarry[PlayerIndex] >= 1.f)
+				{
+					PlayersEventCarry[PlayerIndex] -= 1.f;
+
+					FSyntheticEvent& Event = OutEvents.AddDefaulted_GetRef();
+					Event.FrameDelta = static_cast<FJTFrameDelta>(Frame);
+					Event.bIsAxis = (RandomStream.FRand() < InParams.AxisEventRatio);
+
+					if (Event.bIsAxis)
+					{
+						const FKey& AxisKey = SyntheticAxes[RandomStream.RandHelper(SyntheticAxes.Num())];
+						// Mouse movement is often accumulated over several samples in a frame
+						const int32 NumSamples = (AxisKey.IsGamepadKey() ? 1 : (1 + RandomStream.RandHelper(3)));
+						Event.AxisEventArgs = FJTInputAxisEventArgs(
+							AxisKey, RandomStream.FRandRange(-1.f, 1.f), (1.f / 60.f), PlayerIndex, NumSamples, AxisKey.IsGamepadKey());
+					}
+					else
+					{
+						const int32 KeyIndex = RandomStream.RandHelper(SyntheticKeys.Num());
+						const bool bIsPressed = !PlayersHeldKeys[PlayerIndex][KeyIndex];
+						PlayersHeldKeys[PlayerIndex][KeyIndex] = bIsPressed;
+
+						Event.KeyEventArgs.Key = SyntheticKeys[KeyIndex];
+						Event.KeyEventArgs.InputDevice = FInputDeviceId::CreateFromInternalId(PlayerIndex);
+						Event.KeyEventArgs.ControllerId = PlayerIndex;
+						// Gamepad buttons can be partially depressed
+						const bool bIsPartiallyDepressed = (bIsPressed && SyntheticKeys[KeyIndex].IsGamepadKey());
+						Event.KeyEventArgs.AmountDepressed = (bIsPressed ? (bIsPartiallyDepressed ? RandomStream.FRandRange(0.1f, 1.f) : 1.f) : 0.f);
+						Event.KeyEventArgs.Event = (bIsPressed ? EInputEvent::IE_Pressed : EInputEvent::IE_Released);
+					}
+				}
+			}
+		}
+	}
+
+	FJTPlayerSpatialData MakeSyntheticSpatialData(FRandomStream& InRandomStream)
+	{
+		FJTPlayerSpatialData SpatialData;
+		SpatialData.PawnTransform = FTransform(
+			FRotator(InRandomStream.FRandRange(-90.f, 90.f), InRandomStream.FRandRange(-180.f, 180.f), 0.f),
+			(InRandomStream.GetUnitVector() * InRandomStream.FRandRange(0.f, 100000.f)));
+		SpatialData.ControlRotation = FRotator(InRandomStream.FRandRange(-89.f, 89.f), InRandomStream.FRandRange(-180.f, 180.f), 0.f);
+		SpatialData.Velocity = (InRandomStream.GetUnitVector() * InRandomStream.FRandRange(0.f, 1200.f));
+		return SpatialData;
+	}
+
+	/** Fills in the start data, spatial checkpoints, delta times and random seeds recorded next to the input timeline */
+	void RecordSyntheticTracks(const FJTInputBenchmarkParams& InParams, FJTInputRecordingSession& OutSession)
+	{
+		// Seeded apart from the events, so that the same seed still generates the same events
+		FRandomStream RandomStream(InParams.Seed + 1);
+
+		FJTPlayersSpatialDataCollection PlayersSpatialData;
+		for (int32 PlayerIndex = 0; PlayerIndex < InParams.NumPlayers; ++PlayerIndex)
+		{
+			PlayersSpatialData.Add(MakeSyntheticSpatialData(RandomStream));
+		}
+
+		OutSession.PlayersSpatialDataCollection = PlayersSpatialData;
+
+		OutSession.DeltaTimes.Reserve(InParams.DurationFrames);
+		OutSession.SpatialCheckpoints.Reserve((InParams.DurationFrames / SyntheticCheckpointIntervalFrames) + 1,
+			(((InParams.DurationFrames / SyntheticCheckpointIntervalFrames) + 1) * InParams.NumPlayers));
+
+		for (int32 Frame = 0; Frame < InParams.DurationFrames; ++Frame)
+		{
+			OutSession.DeltaTimes.AddFrame(static_cast<FJTFrameDelta>(Frame), ((1.f / 60.f) + RandomStream.FRandRange(-0.002f, 0.002f)));
+
+			if ((Frame % SyntheticCheckpointIntervalFrames) == 0)
+			{
+				for (FJTPlayerSpatialData& PlayerSpatialData : PlayersSpatialData)
+				{
+					PlayerSpatialData = MakeSyntheticSpatialData(RandomStream);
+				}
+
+				OutSession.SpatialCheckpoints.AddCheckpoint(static_cast<FJTFrameDelta>(Frame), PlayersSpatialData);
+			}
+		}
+
+		OutSession.bHasRandomSeeds = true;
+		OutSession.RandomSeed = RandomStream.RandHelper(MAX_int32);
+		for (const TCHAR* StreamName : { TEXT("Benchmark.Loot"), TEXT("Benchmark.AI") })
+		{
+			FJTRandomStreamSeed& StreamSeed = OutSession.RandomStreamSeeds.AddDefaulted_GetRef();
+			StreamSeed.Name = StreamName;
+			StreamSeed.Seed = RandomStream.RandHelper(MAX_int32);
+		}
+	}
+
+	bool AreSpatialDataEqual(const FJTPlayerSpatialData& InExpected, const FJTPlayerSpatialData& InActual)
+	{
+		return InExpected.PawnTransform.GetLocation().Equals(InActual.PawnTransform.GetLocation(), LocationTolerance)
+			&& InExpected.PawnTransform.GetRotation().Equals(InActual.PawnTransform.GetRotation(), QuatTolerance)
+			&& InExpected.PawnTransform.GetScale3D().Equals(InActual.PawnTransform.GetScale3D(), ScaleTolerance)
+			&& InExpected.ControlRotation.Equals(InActual.ControlRotation, ControlRotationTolerance)
+			&& InExpected.Velocity.Equals(InActual.Velocity, VelocityTolerance);
+	}
+
+	bool AreEventsEqual(const FJTInputTimeline& InExpectedTimeline, const FJTInputTimelineEvent& InExpected,
+		const FJTInputTimeline& InActualTimeline, const FJTInputTimelineEvent& InActual)
+	{
+		if (InExpectedTimeline.GetKey(InExpected.KeyIndex) != InActualTimeline.GetKey(InActual.KeyIndex)
+			|| InExpected.EventType != InActual.EventType
+			|| InExpected.Flags != InActual.Flags
+			|| InExpected.ControllerId != InActual.ControllerId)
+		{
+			return false;
+		}
+
+		if (InExpected.EventType == EJTInputEventType::Key)
+		{
+			return (InExpected.Payload.Key.InputDeviceId == InActual.Payload.Key.InputDeviceId)
+				&& FMath::IsNearlyEqual(InExpected.Payload.Key.AmountDepressed, InActual.Payload.Key.AmountDepressed, PayloadTolerance);
+		}
+
+		return FMath::IsNearlyEqual(InExpected.Payload.Axis.Delta, InActual.Payload.Axis.Delta, PayloadTolerance)
+			&& FMath::IsNearlyEqual(InExpected.Payload.Axis.DeltaTime, InActual.Payload.Axis.DeltaTime, PayloadTolerance)
+			&& (InExpected.Payload.Axis.NumSamples == InActual.Payload.Axis.NumSamples);
+	}
+
+	/** @return the number of seconds it took to record the given events into the session */
+	double RecordEvents(const FJTInputBenchmarkParams& InParams, const TArray<FSyntheticEvent>& InEvents, FJTInputRecordingSession& OutSession)
+	{
+		FJTPlayersSpatialDataCollection PlayersSpatialDataCollection;
+		PlayersSpatialDataCollection.SetNum(InParams.NumPlayers);
+		OutSession.StartSession(PlayersSpatialDataCollection);
+
+		// Events are stamped with the frame GFrameCounter is on relative to the start of the session, so the start
+		// of the session is moved back to each event's frame rather than advancing the engine's frame counter
+		const uint64 SessionStartFrameCounter = OutSession.StartFrameCounter;
+
+		const double StartSeconds = FPlatformTime::Seconds();
+		for (const FSyntheticEvent& Event : InEvents)
+		{
+			OutSession.StartFrameCounter = (GFrameCounter - Event.FrameDelta);
+			if (Event.bIsAxis)
+			{
+				OutSession.RecordAxis(Event.AxisEventArgs);
+			}
+			else
+			{
+				OutSession.RecordKey(Event.KeyEventArgs);
+			}
+		}
+		const double ElapsedSeconds = (FPlatformTime::Seconds() - StartSeconds);
+
+		OutSession.StopSession();
+		OutSession.StartFrameCounter = SessionStartFrameCounter;
+		OutSession.StopFrameCounter = (SessionStartFrameCounter + InParams.DurationFrames);
+
+		RecordSyntheticTracks(InParams, OutSession);
+
+		return ElapsedSeconds;
+	}
+
+	double GetMedian(TArray<double> InValues)
+	{
+		if (InValues.IsEmpty())
+		{
+			return 0.0;
+		}
+
+		Algo::Sort(InValues);
+		return InValues[InValues.Num() / 2];
+	}
+
+	double GetPerSecond(double InAmount, double InSeconds)
+	{
+		return ((InSeconds > 0.0) ? (InAmount / InSeconds) : 0.0);
+	}
+
+	/** @return how much worse (in percent) the candidate is than the baseline, where higher values are better */
+	double GetLossPercent(double InBaseline, double InCandidate)
+	{
+		return ((InBaseline > 0.0) ? (((InBaseline - InCandidate) / InBaseline) * 100.0) : 0.0);
+	}
+
+	int64 GetUsedPhysicalBytes()
+	{
+		return static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical);
+	}
+
+	/** Adds a regression to the given report if the given allocated size grew by more than the given percentage */
+	void CompareAllocatedBytes(const TCHAR* InName, int64 InBaselineBytes, int64 InCandidateBytes, float InMaxRegressionPercent, FJTInputBenchmarkReport& InOutReport)
+	{
+		// Allocated size is a cost rather than a throughput, so lower is better
+		const double GrowthPercent = -GetLossPercent(static_cast<double>(InBaselineBytes), static_cast<double>(InCandidateBytes));
+		if (GrowthPercent > InMaxRegressionPercent)
+		{
+			InOutReport.Regressions.Add(FString::Printf(TEXT("%s went from %.2f MB to %.2f MB (+%.1f%%)"),
+				InName, (InBaselineBytes / (1024.0 * 1024.0)), (InCandidateBytes / (1024.0 * 1024.0)), GrowthPercent));
+		}
+	}
+} // namespace
+
+void FJTInputBenchmark::GenerateSession(const FJTInputBenchmarkParams& InParams, FJTInputRecordingSession& OutSession)
+{
+	TArray<FSyntheticEvent> Events;
+	GenerateEvents(InParams, Events);
+	RecordEvents(InParams, Events, OutSession);
+}
+
+bool FJTInputBenchmark::CompareSessions(const FJTInputRecordingSession& InExpected, const FJTInputRecordingSession& InActual, FString& OutMismatch)
+{
+	if (InActual.RecordingFormatVersion != InExpected.RecordingFormatVersion
+		|| InActual.StartFrameCounter != InExpected.StartFrameCounter
+		|| InActual.StopFrameCounter != InExpected.StopFrameCounter
+		|| InActual.StartTime != InExpected.StartTime
+		|| InActual.StopTime != InExpected.StopTime)
+	{
+		OutMismatch = TEXT("The session's version, start or stop data differs");
+		return false;
+	}
+
+	const int32 NumStartPlayers = InExpected.PlayersSpatialDataCollection.Num();
+	if (InActual.PlayersSpatialDataCollection.Num() != NumStartPlayers)
+	{
+		OutMismatch = FString::Printf(TEXT("%d players at the start instead of %d"), InActual.PlayersSpatialDataCollection.Num(), NumStartPlayers);
+		return false;
+	}
+
+	for (int32 PlayerIndex = 0; PlayerIndex < NumStartPlayers; ++PlayerIndex)
+	{
+		if (!AreSpatialDataEqual(InExpected.PlayersSpatialDataCollection[PlayerIndex], InActual.PlayersSpatialDataCollection[PlayerIndex]))
+		{
+			OutMismatch = FString::Printf(TEXT("The start spatial data of player %d differs"), PlayerIndex);
+			return false;
+		}
+	}
+
+	const FJTInputTimeline& ExpectedTimeline = InExpected.InputTimeline;
+	const FJTInputTimeline& ActualTimeline = InActual.InputTimeline;
+	if (ActualTimeline.Num() != ExpectedTimeline.Num())
+	{
+		OutMismatch = FString::Printf(TEXT("%d timeline frames instead of %d"), ActualTimeline.Num(), ExpectedTimeline.Num());
+		return false;
+	}
+
+	for (int32 FrameIndex = 0; FrameIndex < ExpectedTimeline.Num(); ++FrameIndex)
+	{
+		const FJTFrameDelta FrameDelta = ExpectedTimeline[FrameIndex].FrameDelta;
+		if (ActualTimeline[FrameIndex].FrameDelta != FrameDelta)
+		{
+			OutMismatch = FString::Printf(TEXT("Timeline frame %d is at frame %u instead of %u"), FrameIndex, ActualTimeline[FrameIndex].FrameDelta, FrameDelta);
+			return false;
+		}
+
+		const TArrayView<const FJTInputTimelineEvent> ExpectedEvents = ExpectedTimeline.GetFrameEvents(FrameIndex);
+		const TArrayView<const FJTInputTimelineEvent> ActualEvents = ActualTimeline.GetFrameEvents(FrameIndex);
+		if (ActualEvents.Num() != ExpectedEvents.Num())
+		{
+			OutMismatch = FString::Printf(TEXT("Frame %u has %d events instead of %d"), FrameDelta, ActualEvents.Num(), ExpectedEvents.Num());
+			return false;
+		}
+
+		for (int32 EventIndex = 0; EventIndex < ExpectedEvents.Num(); ++EventIndex)
+		{
+			if (!AreEventsEqual(ExpectedTimeline, ExpectedEvents[EventIndex], ActualTimeline, ActualEvents[EventIndex]))
+			{
+				OutMismatch = FString::Printf(TEXT("Event %d of frame %u (%s) differs"),
+					EventIndex, FrameDelta, *ExpectedTimeline.GetKey(ExpectedEvents[EventIndex].KeyIndex).ToString());
+				return false;
+			}
+		}
+	}
+
+	const FJTSpatialCheckpointTrack& ExpectedCheckpoints = InExpected.SpatialCheckpoints;
+	const FJTSpatialCheckpointTrack& ActualCheckpoints = InActual.SpatialCheckpoints;
+	if (ActualCheckpoints.Num() != ExpectedCheckpoints.Num())
+	{
+		OutMismatch = FString::Printf(TEXT("%d spatial checkpoints instead of %d"), ActualCheckpoints.Num(), ExpectedCheckpoints.Num());
+		return false;
+	}
+
+	for (int32 CheckpointIndex = 0; CheckpointIndex < ExpectedCheckpoints.Num(); ++CheckpointIndex)
+	{
+		const FJTFrameDelta FrameDelta = ExpectedCheckpoints[CheckpointIndex].FrameDelta;
+		const TArrayView<const FJTPlayerSpatialData> ExpectedPlayers = ExpectedCheckpoints.GetPlayers(CheckpointIndex);
+		const TArrayView<const FJTPlayerSpatialData> ActualPlayers = ActualCheckpoints.GetPlayers(CheckpointIndex);
+		if (ActualCheckpoints[CheckpointIndex].FrameDelta != FrameDelta || ActualPlayers.Num() != ExpectedPlayers.Num())
+		{
+			OutMismatch = FString::Printf(TEXT("Spatial checkpoint %d is not at frame %u with %d players"), CheckpointIndex, FrameDelta, ExpectedPlayers.Num());
+			return false;
+		}
+
+		for (int32 PlayerIndex = 0; PlayerIndex < ExpectedPlayers.Num(); ++PlayerIndex)
+		{
+			if (!AreSpatialDataEqual(ExpectedPlayers[PlayerIndex], ActualPlayers[PlayerIndex]))
+			{
+				OutMismatch = FString::Printf(TEXT("The spatial data of player %d at the checkpoint on frame %u differs"), PlayerIndex, FrameDelta);
+				return false;
+			}
+		}
+	}
+
+	const FJTDeltaTimeTrack& ExpectedDeltaTimes = InExpected.DeltaTimes;
+	const FJTDeltaTimeTrack& ActualDeltaTimes = InActual.DeltaTimes;
+	if (ActualDeltaTimes.GetFirstFrameDelta() != ExpectedDeltaTimes.GetFirstFrameDelta() || ActualDeltaTimes.Num() != ExpectedDeltaTimes.Num())
+	{
+		OutMismatch = FString::Printf(TEXT("Delta times cover frames %u to %u instead of %u to %u"),
+			ActualDeltaTimes.GetFirstFrameDelta(), ActualDeltaTimes.GetEndFrameDelta(), ExpectedDeltaTimes.GetFirstFrameDelta(), ExpectedDeltaTimes.GetEndFrameDelta());
+		return false;
+	}
+
+	for (FJTFrameDelta FrameDelta = ExpectedDeltaTimes.GetFirstFrameDelta(); FrameDelta < ExpectedDeltaTimes.GetEndFrameDelta(); ++FrameDelta)
+	{
+		if (!FMath::IsNearlyEqual(ActualDeltaTimes.GetDeltaSeconds(FrameDelta), ExpectedDeltaTimes.GetDeltaSeconds(FrameDelta), DeltaSecondsTolerance))
+		{
+			OutMismatch = FString::Printf(TEXT("The delta time of frame %u is %fs instead of %fs"),
+				FrameDelta, ActualDeltaTimes.GetDeltaSeconds(FrameDelta), ExpectedDeltaTimes.GetDeltaSeconds(FrameDelta));
+			return false;
+		}
+	}
+
+	const bool bHaveSameStreamSeeds = (InActual.RandomStreamSeeds.Num() == InExpected.RandomStreamSeeds.Num())
+		&& Algo::CompareByPredicate(InExpected.RandomStreamSeeds, InActual.RandomStreamSeeds, [](const FJTRandomStreamSeed& Expected, const FJTRandomStreamSeed& Actual)
+			{
+				return (Expected.Name == Actual.Name) && (Expected.Seed == Actual.Seed);
+			});
+
+	if (InActual.bHasRandomSeeds != InExpected.bHasRandomSeeds || InActual.RandomSeed != InExpected.RandomSeed || !bHaveSameStreamSeeds)
+	{
+		OutMismatch = TEXT("The random seeds differ");
+		return false;
+	}
+
+	OutMismatch.Empty();
+	return true;
+}
+
+bool FJTInputBenchmark::Run(const FJTInputBenchmarkParams& InParams, FJTInputBenchmarkReport& OutReport)
+{
+	OutReport = FJTInputBenchmarkReport();
+	OutReport.Timestamp = FDateTime::UtcNow().ToIso8601();
+	OutReport.BuildVersion = FApp::GetBuildVersion();
+	OutReport.Platform = FPlatformProperties::IniPlatformName();
+	OutReport.Params = InParams;
+
+	const int32 NumIterations = FMath::Max(InParams.NumIterations, 1);
+
+	TArray<FSyntheticEvent> Events;
+	GenerateEvents(InParams, Events);
+
+	UE_LOG(LogJTInputBenchmark, Log, TEXT("Benchmarking a session of %d frames, %d events and %d players over %d iterations"),
+		InParams.DurationFrames, Events.Num(), InParams.NumPlayers, NumIterations);
+
+	// Recording. Every iteration records into a fresh session, so storage growth is part of the cost as it is in a real recording
+	FJTInputRecordingSession Session;
+	TArray<double> RecordSeconds;
+	for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+	{
+		Session = FJTInputRecordingSession();
+
+		// Measured from after the previous session was freed, so only this stage's growth is counted. Allocators hold
+		// on to freed memory, so later iterations can grow less than the first, which is why the largest is kept
+		const int64 StartUsedPhysicalBytes = GetUsedPhysicalBytes();
+		const uint64 StartNumTimelineAllocations = FJTInputTimeline::GetNumAllocations();
+		RecordSeconds.Add(RecordEvents(InParams, Events, Session));
+		OutReport.RecordTimelineAllocations = static_cast<int64>(FJTInputTimeline::GetNumAllocations() - StartNumTimelineAllocations);
+		OutReport.RecordUsedPhysicalBytes = FMath::Max(OutReport.RecordUsedPhysicalBytes, (GetUsedPhysicalBytes() - StartUsedPhysicalBytes));
+	}
+
+	Events.Empty();
+
+	OutReport.NumFrames = Session.InputTimeline.Num();
+	OutReport.NumEvents = Session.InputTimeline.NumEvents();
+	OutReport.RecordNanosecondsPerEvent = ((OutReport.NumEvents > 0) ? ((GetMedian(RecordSeconds) * 1e9) / OutReport.NumEvents) : 0.0);
+	OutReport.SessionAllocatedBytes = static_cast<int64>(Session.GetAllocatedSize());
+
+	// Serialization
+	bool bAllFormatsRoundTripped = true;
+	for (const EJTInputRecordingFileFormat FileFormat : { EJTInputRecordingFileFormat::Json, EJTInputRecordingFileFormat::Binary })
+	{
+		const FString& FileExtension = FJTInputSerializer::GetFileExtensionForFormat(FileFormat);
+
+		FFilePath FilePath;
+		FilePath.FilePath = FString::Printf(TEXT("Benchmark/JTInputBenchmark.%s"), *FileExtension);
+
+		FFilePath FinalPath;
+		FJTInputSerializer::TryResolveFilePath(FilePath, FinalPath);
+
+		FJTInputBenchmarkFormatResult& Result = OutReport.Formats.AddDefaulted_GetRef();
+		Result.Format = FileExtension;
+		Result.bRoundTripped = true;
+
+		TArray<double> ExportSeconds;
+		TArray<double> ImportSeconds;
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			const double ExportStartSeconds = FPlatformTime::Seconds();
+			const bool bExported = FJTInputSerializer::ExportSession(FilePath, Session);
+			ExportSeconds.Add(FPlatformTime::Seconds() - ExportStartSeconds);
+
+			FJTInputRecordingSession ImportedSession;
+			const int64 ImportStartUsedPhysicalBytes = GetUsedPhysicalBytes();
+			const double ImportStartSeconds = FPlatformTime::Seconds();
+			const bool bImported = bExported && FJTInputSerializer::ImportSession(FilePath, ImportedSession);
+			ImportSeconds.Add(FPlatformTime::Seconds() - ImportStartSeconds);
+
+			Result.ImportUsedPhysicalBytes = FMath::Max(Result.ImportUsedPhysicalBytes, (GetUsedPhysicalBytes() - ImportStartUsedPhysicalBytes));
+			Result.ImportedSessionAllocatedBytes = FMath::Max(Result.ImportedSessionAllocatedBytes, static_cast<int64>(ImportedSession.GetAllocatedSize()));
+
+			if (!bImported)
+			{
+				Result.bRoundTripped = false;
+				Result.RoundTripMismatch = TEXT("The session could not be exported or imported");
+			}
+			else if (Result.bRoundTripped && !CompareSessions(Session, ImportedSession, Result.RoundTripMismatch))
+			{
+				Result.bRoundTripped = false;
+			}
+		}
+
+		Result.FileBytes = IFileManager::Get().FileSize(*FinalPath.FilePath);
+		Result.ExportSeconds = GetMedian(ExportSeconds);
+		Result.ImportSeconds = GetMedian(ImportSeconds);
+
+		const double FileMegabytes = (FMath::Max<int64>(Result.FileBytes, 0) / (1024.0 * 1024.0));
+		Result.ExportMegabytesPerSecond = GetPerSecond(FileMegabytes, Result.ExportSeconds);
+		Result.ImportMegabytesPerSecond = GetPerSecond(FileMegabytes, Result.ImportSeconds);
+		Result.ExportEventsPerSecond = GetPerSecond(OutReport.NumEvents, Result.ExportSeconds);
+		Result.ImportEventsPerSecond = GetPerSecond(OutReport.NumEvents, Result.ImportSeconds);
+
+		if (!Result.bRoundTripped)
+		{
+			UE_LOG(LogJTInputBenchmark, Error, TEXT("Session did not round trip through %s: %s"), *FinalPath.FilePath, *Result.RoundTripMismatch);
+			bAllFormatsRoundTripped = false;
+		}
+
+		IFileManager::Get().Delete(*FinalPath.FilePath);
+	}
+
+	return bAllFormatsRoundTripped;
+}
+
+bool FJTInputBenchmark::CompareToBaseline(const FJTInputBenchmarkReport& InBaselineReport, float InMaxRegressionPercent, FJTInputBenchmarkReport& InOutReport)
+{
+	if (!FJTInputBenchmarkParams::StaticStruct()->CompareScriptStruct(&InBaselineReport.Params, &InOutReport.Params, 0))
+	{
+		UE_LOG(LogJTInputBenchmark, Warning, TEXT("Baseline was run against a differently shaped session, so it can't be compared to"));
+		return false;
+	}
+
+	const int32 NumRegressionsBefore = InOutReport.Regressions.Num();
+
+	// Record cost is a cost rather than a throughput, so lower is better
+	const double RecordLossPercent = -GetLossPercent(InBaselineReport.RecordNanosecondsPerEvent, InOutReport.RecordNanosecondsPerEvent);
+	if (RecordLossPercent > InMaxRegressionPercent)
+	{
+		InOutReport.Regressions.Add(FString::Printf(TEXT("Record cost went from %.1fns to %.1fns per event (+%.1f%%)"),
+			InBaselineReport.RecordNanosecondsPerEvent, InOutReport.RecordNanosecondsPerEvent, RecordLossPercent));
+	}
+
+	// Used physical memory depends on what the allocators happen to hold on to, so only allocated sizes are compared
+	CompareAllocatedBytes(TEXT("Recorded session memory"), InBaselineReport.SessionAllocatedBytes, InOutReport.SessionAllocatedBytes, InMaxRegressionPercent, InOutReport);
+
+	for (const FJTInputBenchmarkFormatResult& Result : InOutReport.Formats)
+	{
+		const FJTInputBenchmarkFormatResult* BaselineResult = InBaselineReport.Formats.FindByPredicate(
+			[&Result](const FJTInputBenchmarkFormatResult& InBaselineResult)
+			{
+				return (InBaselineResult.Format == Result.Format);
+			});
+
+		if (!BaselineResult)
+		{
+			continue;
+		}
+
+		const double ExportLossPercent = GetLossPercent(BaselineResult->ExportEventsPerSecond, Result.ExportEventsPerSecond);
+		if (ExportLossPercent > InMaxRegressionPercent)
+		{
+			InOutReport.Regressions.Add(FString::Printf(TEXT("%s export went from %.0f to %.0f events/s (-%.1f%%)"),
+				*Result.Format, BaselineResult->ExportEventsPerSecond, Result.ExportEventsPerSecond, ExportLossPercent));
+		}
+
+		const double ImportLossPercent = GetLossPercent(BaselineResult->ImportEventsPerSecond, Result.ImportEventsPerSecond);
+		if (ImportLossPercent > InMaxRegressionPercent)
+		{
+			InOutReport.Regressions.Add(FString::Printf(TEXT("%s import went from %.0f to %.0f events/s (-%.1f%%)"),
+				*Result.Format, BaselineResult->ImportEventsPerSecond, Result.ImportEventsPerSecond, ImportLossPercent));
+		}
+
+		const FString ImportedSessionName = FString::Printf(TEXT("%s imported session memory"), *Result.Format);
+		CompareAllocatedBytes(*ImportedSessionName, BaselineResult->ImportedSessionAllocatedBytes, Result.ImportedSessionAllocatedBytes, InMaxRegressionPercent, InOutReport);
+	}
+
+	return (InOutReport.Regressions.Num() > NumRegressionsBefore);
+}
+
+bool FJTInputBenchmark::SaveReport(const FJTInputBenchmarkReport& InReport, const FString& InFilePath)
+{
+	FString ReportJsonString;
+	if (!FJsonObjectConverter::UStructToJsonObjectString<FJTInputBenchmarkReport>(InReport, ReportJsonString))
+	{
+		return false;
+	}
+
+	return FFileHelper::SaveStringToFile(ReportJsonString, *InFilePath);
+}
+
+bool FJTInputBenchmark::LoadReport(const FString& InFilePath, FJTInputBenchmarkReport& OutReport)
+{
+	FString ReportJsonString;
+	if (!FFileHelper::LoadFileToString(ReportJsonString, *InFilePath))
+	{
+		return false;
+	}
+
+	return FJsonObjectConverter::JsonObjectStringToUStruct<FJTInputBenchmarkReport>(ReportJsonString, &OutReport);
+}
+
+void FJTInputBenchmark::LogReport(const FJTInputBenchmarkReport& InReport)
+{
+	UE_LOG(LogJTInputBenchmark, Log, TEXT("Recorded %d events over %d frames at %.1fns per event (%lld timeline allocations, %.2f MB allocated, %.2f MB physical)"),
+		InReport.NumEvents, InReport.NumFrames, InReport.RecordNanosecondsPerEvent, InReport.RecordTimelineAllocations,
+		(InReport.SessionAllocatedBytes / (1024.0 * 1024.0)), (InReport.RecordUsedPhysicalBytes / (1024.0 * 1024.0)));
+
+	for (const FJTInputBenchmarkFormatResult& Result : InReport.Formats)
+	{
+		UE_LOG(LogJTInputBenchmark, Log, TEXT("  %s (%.2f MB): export %.1f MB/s (%.0f events/s), import %.1f MB/s (%.0f events/s, %.2f MB allocated, %.2f MB physical)%s"),
+			*Result.Format, (Result.FileBytes / (1024.0 * 1024.0)),
+			Result.ExportMegabytesPerSecond, Result.ExportEventsPerSecond,
+			Result.ImportMegabytesPerSecond, Result.ImportEventsPerSecond,
+			(Result.ImportedSessionAllocatedBytes / (1024.0 * 1024.0)), (Result.ImportUsedPhysicalBytes / (1024.0 * 1024.0)),
+			(Result.bRoundTripped ? TEXT("") : TEXT(" - DID NOT ROUND TRIP")));
+	}
+
+	for (const FString& Regression : InReport.Regressions)
+	{
+		UE_LOG(LogJTInputBenchmark, Warning, TEXT("  Regression: %s"), *Regression);
+	}
+}
+
+bool FJTInputBenchmark::RunAndReport(const FJTInputBenchmarkParams& InParams, const FString& InBaselineFilePath, float InMaxRegressionPercent,
+	const FString& InReportFilePath, FJTInputBenchmarkReport& OutReport)
+{
+	const bool bRoundTripped = Run(InParams, OutReport);
+
+	bool bHasRegression = false;
+	if (!InBaselineFilePath.IsEmpty())
+	{
+		FJTInputBenchmarkReport BaselineReport;
+		if (LoadReport(InBaselineFilePath, BaselineReport))
+		{
+			bHasRegression = CompareToBaseline(BaselineReport, InMaxRegressionPercent, OutReport);
+		}
+		else
+		{
+			UE_LOG(LogJTInputBenchmark, Error, TEXT("Unable to load baseline report %s"), *InBaselineFilePath);
+		}
+	}
+
+	LogReport(OutReport);
+
+	const FString ReportFilePath = (InReportFilePath.IsEmpty() ? MakeDefaultReportFilePath() : InReportFilePath);
+	if (SaveReport(OutReport, ReportFilePath))
+	{
+		UE_LOG(LogJTInputBenchmark, Log, TEXT("Benchmark report written to %s"), *ReportFilePath);
+	}
+	else
+	{
+		UE_LOG(LogJTInputBenchmark, Error, TEXT("Benchmark report could not be written to %s"), *ReportFilePath);
+	}
+
+	return (bRoundTripped && !bHasRegression);
+}
+
+FString FJTInputBenchmark::MakeDefaultReportFilePath()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("AutoReplay"), TEXT("Benchmarks"),
+		FString::Printf(TEXT("Benchmark_%s.json"), *FDateTime::Now().ToString()));
+}
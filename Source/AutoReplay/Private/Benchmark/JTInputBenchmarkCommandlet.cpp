@@ -0,0 +1,43 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "Benchmark/JTInputBenchmarkCommandlet.h"
+
+#include "Benchmark/JTInputBenchmark.h"
+
+#include "Misc/Parse.h"
+
+UJTInputBenchmarkCommandlet::UJTInputBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UJTInputBenchmarkCommandlet::Main(const FString& Params)
+{
+	FJTInputBenchmarkParams BenchmarkParams;
+	FParse::Value(*Params, TEXT("Frames="), BenchmarkParams.DurationFrames);
+	FParse::Value(*Params, TEXT("EventsPerFrame="), BenchmarkParams.EventsPerFrame);
+	FParse::Value(*Params, TEXT("AxisRatio="), BenchmarkParams.AxisEventRatio);
+	FParse::Value(*Params, TEXT("Players="), BenchmarkParams.NumPlayers);
+	FParse::Value(*Params, TEXT("Seed="), BenchmarkParams.Seed);
+	FParse::Value(*Params, TEXT("Iterations="), BenchmarkParams.NumIterations);
+
+	BenchmarkParams.DurationFrames = FMath::Max(BenchmarkParams.DurationFrames, 1);
+	BenchmarkParams.EventsPerFrame = FMath::Max(BenchmarkParams.EventsPerFrame, 0.f);
+	BenchmarkParams.AxisEventRatio = FMath::Clamp(BenchmarkParams.AxisEventRatio, 0.f, 1.f);
+	BenchmarkParams.NumPlayers = FMath::Max(BenchmarkParams.NumPlayers, 1);
+
+	FString BaselineFilePath;
+	FParse::Value(*Params, TEXT("Baseline="), BaselineFilePath);
+
+	float MaxRegressionPercent = 10.f;
+	FParse::Value(*Params, TEXT("MaxRegressionPercent="), MaxRegressionPercent);
+
+	FString ReportFilePath;
+	FParse::Value(*Params, TEXT("Report="), ReportFilePath);
+
+	FJTInputBenchmarkReport Report;
+	return (FJTInputBenchmark::RunAndReport(BenchmarkParams, BaselineFilePath, MaxRegressionPercent, ReportFilePath, Report) ? 0 : 1);
+}
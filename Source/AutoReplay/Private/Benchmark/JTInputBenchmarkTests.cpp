@@ -0,0 +1,88 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "Benchmark/JTInputBenchmark.h"
+
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace JTInputBenchmarkTests
+{
+	/** Adds the headline numbers of the given report to the test's output */
+	void AddReportInfo(FAutomationTestBase& InTest, const FJTInputBenchmarkReport& InReport)
+	{
+		InTest.AddInfo(FString::Printf(TEXT("Recorded %d events at %.1fns per event (%.2f MB allocated, %.2f MB physical)"),
+			InReport.NumEvents, InReport.RecordNanosecondsPerEvent,
+			(InReport.SessionAllocatedBytes / (1024.0 * 1024.0)), (InReport.RecordUsedPhysicalBytes / (1024.0 * 1024.0))));
+
+		for (const FJTInputBenchmarkFormatResult& Result : InReport.Formats)
+		{
+			InTest.AddInfo(FString::Printf(TEXT("%s: export %.0f events/s, import %.0f events/s (%.2f MB allocated, %.2f MB physical)"),
+				*Result.Format, Result.ExportEventsPerSecond, Result.ImportEventsPerSecond,
+				(Result.ImportedSessionAllocatedBytes / (1024.0 * 1024.0)), (Result.ImportUsedPhysicalBytes / (1024.0 * 1024.0))));
+
+			if (!Result.bRoundTripped)
+			{
+				InTest.AddError(FString::Printf(TEXT("%s did not round trip: %s"), *Result.Format, *Result.RoundTripMismatch));
+			}
+		}
+
+		for (const FString& Regression : InReport.Regressions)
+		{
+			InTest.AddError(FString::Printf(TEXT("Regression: %s"), *Regression));
+		}
+	}
+}
+
+/** Checks that a small synthetic session records and round trips through every file format with all of its content intact */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJTInputBenchmarkRoundTripTest, "AutoReplay.Benchmark.RoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FJTInputBenchmarkRoundTripTest::RunTest(const FString& Parameters)
+{
+	FJTInputBenchmarkParams Params;
+	Params.DurationFrames = 600;
+	Params.NumIterations = 1;
+
+	FJTInputBenchmarkReport Report;
+	if (!FJTInputBenchmark::Run(Params, Report))
+	{
+		AddError(TEXT("The benchmark session did not round trip through every file format"));
+	}
+
+	TestTrue(TEXT("The benchmark session has events"), (Report.NumEvents > 0));
+	JTInputBenchmarkTests::AddReportInfo(*this, Report);
+
+	return true;
+}
+
+/**
+ * Runs the full benchmark and writes its report, failing on any regression against the baseline report passed with
+ * -JTBenchmarkBaseline= (and optionally -JTBenchmarkMaxRegressionPercent=, 10 by default)
+ */
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJTInputBenchmarkSessionTest, "AutoReplay.Benchmark.Session",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FJTInputBenchmarkSessionTest::RunTest(const FString& Parameters)
+{
+	FString BaselineFilePath;
+	FParse::Value(FCommandLine::Get(), TEXT("JTBenchmarkBaseline="), BaselineFilePath);
+
+	float MaxRegressionPercent = 10.f;
+	FParse::Value(FCommandLine::Get(), TEXT("JTBenchmarkMaxRegressionPercent="), MaxRegressionPercent);
+
+	FJTInputBenchmarkReport Report;
+	if (!FJTInputBenchmark::RunAndReport(FJTInputBenchmarkParams(), BaselineFilePath, MaxRegressionPercent, FString(), Report)
+		&& Report.Regressions.IsEmpty())
+	{
+		AddError(TEXT("The benchmark session did not round trip through every file format"));
+	}
+
+	JTInputBenchmarkTests::AddReportInfo(*this, Report);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
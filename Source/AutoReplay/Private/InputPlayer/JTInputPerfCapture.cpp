@@ -0,0 +1,137 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "InputPlayer/JTInputPerfCapture.h"
+
+#include "JTAutoReplayProfiling.h"
+
+#include "Async/Async.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RenderCore.h"
+#include "RHI.h"
+
+namespace
+{
+	const TCHAR* PerfCaptureSessionPrefix = TEXT("# Session: ");
+	const TCHAR* PerfCaptureHeader = TEXT("Frame,TimelineFrameIndex,PlayIndex,NumInjectedEvents,FrameTimeMs,GameThreadTimeMs,RenderThreadTimeMs,RHIThreadTimeMs,GPUTimeMs,UsedPhysicalMemory");
+	constexpr int32 NumPerfCaptureColumns = 10;
+}
+
+void FJTInputPerfCapture::Reset(const FString& InSessionFilePath, int32 InExpectedNumFrames)
+{
+	SessionFilePath = InSessionFilePath;
+	Samples.Reset(FMath::Max(InExpectedNumFrames, 0));
+}
+
+void FJTInputPerfCapture::AddSample(FJTFrameDelta InFrame, int32 InTimelineFrameIndex, int32 InPlayIndex, int32 InNumInjectedEvents)
+{
+	FJTInputPerfSample& Sample = Samples.AddDefaulted_GetRef();
+	Sample.Frame = InFrame;
+	Sample.TimelineFrameIndex = InTimelineFrameIndex;
+	Sample.PlayIndex = InPlayIndex;
+	Sample.NumInjectedEvents = InNumInjectedEvents;
+	Sample.FrameTimeMs = static_cast<float>(FApp::GetDeltaTime() * 1000.0);
+	Sample.GameThreadTimeMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	Sample.RenderThreadTimeMs = FPlatformTime::ToMilliseconds(GRenderThreadTime);
+	Sample.RHIThreadTimeMs = FPlatformTime::ToMilliseconds(GRHIThreadTime);
+	Sample.GPUTimeMs = FPlatformTime::ToMilliseconds(RHIGetGPUFrameCycles());
+	Sample.UsedPhysicalMemory = FPlatformMemory::GetStats().UsedPhysical;
+}
+
+bool FJTInputPerfCapture::SaveToCsv(const FString& InFilePath) const
+{
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	// Rows are ~80 characters each
+	TStringBuilder<256> RowBuilder;
+	FString CsvString;
+	CsvString.Reserve((Samples.Num() + 2) * 96);
+
+	CsvString += PerfCaptureSessionPrefix;
+	CsvString += SessionFilePath;
+	CsvString += TEXT("\n");
+	CsvString += PerfCaptureHeader;
+	CsvString += TEXT("\n");
+
+	for (const FJTInputPerfSample& Sample : Samples)
+	{
+		RowBuilder.Reset();
+		RowBuilder.Appendf(TEXT("%u,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%llu\n"),
+			Sample.Frame,
+			Sample.TimelineFrameIndex,
+			Sample.PlayIndex,
+			Sample.NumInjectedEvents,
+			Sample.FrameTimeMs,
+			Sample.GameThreadTimeMs,
+			Sample.RenderThreadTimeMs,
+			Sample.RHIThreadTimeMs,
+			Sample.GPUTimeMs,
+			Sample.UsedPhysicalMemory);
+
+		CsvString.Append(RowBuilder.GetData(), RowBuilder.Len());
+	}
+
+	return FFileHelper::SaveStringToFile(CsvString, *InFilePath);
+}
+
+bool FJTInputPerfCapture::LoadFromCsv(const FString& InFilePath, FJTInputPerfCapture& OutCapture)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *InFilePath))
+	{
+		return false;
+	}
+
+	OutCapture.SessionFilePath.Empty();
+	OutCapture.Samples.Reset(Lines.Num());
+
+	TArray<FString> Columns;
+	for (const FString& Line : Lines)
+	{
+		if (Line.StartsWith(PerfCaptureSessionPrefix))
+		{
+			OutCapture.SessionFilePath = Line.RightChop(FCString::Strlen(PerfCaptureSessionPrefix));
+			continue;
+		}
+
+		Columns.Reset();
+		Line.ParseIntoArray(Columns, TEXT(","), false);
+		if (Columns.Num() != NumPerfCaptureColumns || !Columns[0].IsNumeric())
+		{
+			// The header, or a line this version doesn't understand
+			continue;
+		}
+
+		FJTInputPerfSample& Sample = OutCapture.Samples.AddDefaulted_GetRef();
+		Sample.Frame = static_cast<FJTFrameDelta>(FCString::Strtoui64(*Columns[0], nullptr, 10));
+		Sample.TimelineFrameIndex = FCString::Atoi(*Columns[1]);
+		Sample.PlayIndex = FCString::Atoi(*Columns[2]);
+		Sample.NumInjectedEvents = FCString::Atoi(*Columns[3]);
+		Sample.FrameTimeMs = FCString::Atof(*Columns[4]);
+		Sample.GameThreadTimeMs = FCString::Atof(*Columns[5]);
+		Sample.RenderThreadTimeMs = FCString::Atof(*Columns[6]);
+		Sample.RHIThreadTimeMs = FCString::Atof(*Columns[7]);
+		Sample.GPUTimeMs = FCString::Atof(*Columns[8]);
+		Sample.UsedPhysicalMemory = FCString::Strtoui64(*Columns[9], nullptr, 10);
+	}
+
+	return !OutCapture.Samples.IsEmpty();
+}
+
+TFuture<bool> FJTInputPerfCapture::SaveToCsvAsync(const FString& InFilePath, FJTInputPerfCapture&& InCapture)
+{
+	return Async(EAsyncExecution::ThreadPool, [InFilePath, Capture = MoveTemp(InCapture)]()
+		{
+			return Capture.SaveToCsv(InFilePath);
+		});
+}
+
+FString FJTInputPerfCapture::MakeDefaultFilePath(const FString& InSessionFilePath)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("AutoReplay"), TEXT("PerfCaptures"),
+		FString::Printf(TEXT("%s_%s.csv"), *FPaths::GetBaseFilename(InSessionFilePath), *FDateTime::Now().ToString()));
+}
@@ -0,0 +1,148 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "InputPlayer/JTInputPlaybackProgram.h"
+
+#include "JTAutoReplayProfiling.h"
+
+#include "Algo/BinarySearch.h"
+#include "GenericPlatform/GenericPlatformInputDeviceMapper.h"
+#include "Slate/SceneViewport.h"
+
+TSharedRef<FJTInputPlaybackProgram> FJTInputPlaybackProgram::Compile(const TSharedRef<const FJTInputRecordingSession>& InSession)
+{
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputPlaybackProgram_Compile);
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	TSharedRef<FJTInputPlaybackProgram> Program = MakeShared<FJTInputPlaybackProgram>();
+	Program->Session = InSession;
+
+	const FJTInputTimeline& Timeline = InSession->InputTimeline;
+	Program->Frames.Reserve(Timeline.Num());
+	Program->Ops.Reserve(Timeline.NumEvents());
+
+	for (int32 FrameIndex = 0; FrameIndex < Timeline.Num(); ++FrameIndex)
+	{
+		FFrame& Frame = Program->Frames.AddDefaulted_GetRef();
+		Frame.FrameDelta = Timeline[FrameIndex].FrameDelta;
+		Frame.FirstOpIndex = Program->Ops.Num();
+
+		for (const FJTInputTimelineEvent& TimelineEvent : Timeline.GetFrameEvents(FrameIndex))
+		{
+			if (TimelineEvent.EventType != EJTInputEventType::Key && TimelineEvent.EventType != EJTInputEventType::Axis)
+			{
+				continue;
+			}
+
+			FOp& Op = Program->Ops.AddDefaulted_GetRef();
+			Op.Key = Timeline.GetKey(TimelineEvent.KeyIndex);
+			Op.EventType = TimelineEvent.EventType;
+			Op.ControllerSlot = Program->FindOrAddControllerSlot(TimelineEvent.ControllerId);
+
+			if (TimelineEvent.EventType == EJTInputEventType::Key)
+			{
+				Op.Event = TimelineEvent.GetKeyEvent();
+				Op.AmountDepressed = TimelineEvent.Payload.Key.AmountDepressed;
+				Op.bIsTouchEvent = TimelineEvent.IsTouchEvent();
+			}
+			else
+			{
+				Op.Delta = TimelineEvent.Payload.Axis.Delta;
+				Op.DeltaTime = TimelineEvent.Payload.Axis.DeltaTime;
+				Op.NumSamples = TimelineEvent.Payload.Axis.NumSamples;
+				Op.bGamepad = TimelineEvent.IsGamepad();
+			}
+
+			++Frame.NumOps;
+		}
+	}
+
+	return Program;
+}
+
+void FJTInputPlaybackProgram::Bind(FSceneViewport* InViewport)
+{
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputPlaybackProgram_Bind);
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	check(IsInGameThread());
+
+	// Controller remapping depends on the current platform user/device mapping, so resolve it once per distinct controller
+	TArray<FInputDeviceId, TInlineAllocator<8>> InputDevices;
+	InputDevices.Reserve(ControllerIds.Num());
+
+	IPlatformInputDeviceMapper& DeviceMapper = IPlatformInputDeviceMapper::Get();
+	for (const int32 ControllerId : ControllerIds)
+	{
+		FPlatformUserId UserId = PLATFORMUSERID_NONE;
+		FInputDeviceId DeviceId = INPUTDEVICEID_NONE;
+		DeviceMapper.RemapControllerIdToPlatformUserAndDevice(ControllerId, UserId, DeviceId);
+
+		InputDevices.Emplace(DeviceId);
+	}
+
+	for (FOp& Op : Ops)
+	{
+		Op.InputDevice = InputDevices[Op.ControllerSlot];
+	}
+
+	BoundViewport = InViewport;
+	bIsBound = true;
+}
+
+int32 FJTInputPlaybackProgram::FindFrameIndex(FJTFrameDelta InFrameDelta) const
+{
+	return Algo::LowerBoundBy(Frames, InFrameDelta, &FFrame::FrameDelta);
+}
+
+void FJTInputPlaybackProgram::GatherHeldKeyOps(int32 InFrameIndex, TArray<const FOp*>& OutHeldKeyOps) const
+{
+	OutHeldKeyOps.Reset();
+
+	if (!Frames.IsValidIndex(InFrameIndex - 1))
+	{
+		return;
+	}
+
+	const int32 EndOpIndex = (Frames[InFrameIndex - 1].FirstOpIndex + Frames[InFrameIndex - 1].NumOps);
+	for (int32 OpIndex = 0; OpIndex < EndOpIndex; ++OpIndex)
+	{
+		const FOp& Op = Ops[OpIndex];
+		if (Op.EventType != EJTInputEventType::Key)
+		{
+			continue;
+		}
+
+		const int32 HeldKeyIndex = OutHeldKeyOps.IndexOfByPredicate([&Op](const FOp* HeldKeyOp)
+			{
+				return (HeldKeyOp->Key == Op.Key) && (HeldKeyOp->ControllerSlot == Op.ControllerSlot);
+			});
+
+		if (Op.Event == IE_Pressed || Op.Event == IE_Repeat || Op.Event == IE_DoubleClick)
+		{
+			if (HeldKeyIndex == INDEX_NONE)
+			{
+				OutHeldKeyOps.Emplace(&Op);
+			}
+		}
+		else if (Op.Event == IE_Released && HeldKeyIndex != INDEX_NONE)
+		{
+			OutHeldKeyOps.RemoveAt(HeldKeyIndex);
+		}
+	}
+}
+
+SIZE_T FJTInputPlaybackProgram::GetAllocatedSize() const
+{
+	return Frames.GetAllocatedSize() + Ops.GetAllocatedSize() + ControllerIds.GetAllocatedSize();
+}
+
+int32 FJTInputPlaybackProgram::FindOrAddControllerSlot(int32 InControllerId)
+{
+	const int32 ExistingControllerSlot = ControllerIds.Find(InControllerId);
+	if (ExistingControllerSlot != INDEX_NONE)
+	{
+		return ExistingControllerSlot;
+	}
+
+	return ControllerIds.Emplace(InControllerId);
+}
@@ -3,6 +3,9 @@
 #include "InputPlayer/JTInputPlayer.h"
 
 #include "JTAutoReplayConsoleMenu.h"
+#include "JTAutoReplayProfiling.h"
+#include "InputPlayer/JTInputPlaybackProgram.h"
+#include "InputPlayer/JTInputSessionCache.h"
 #include "InputRecorder/JTInputRecorder.h"
 #include "InputSerializer/JTInputSerializer.h"
 
@@ -11,6 +14,9 @@
 #include "Engine/Engine.h"
 #include "Engine/World.h"
 #include "GameFramework/Pawn.h"
+#include "GameFramework/PawnMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/App.h"
 #include "Slate/SceneViewport.h"
 #include "TimerManager.h"
 
@@ -26,19 +32,49 @@ void UJTInputPlayer::Deinitialize()
 	Super::Deinitialize();
 
 	StopPlaying();
+
+	for (TFuture<bool>& PendingPerfCaptureWrite : PendingPerfCaptureWrites)
+	{
+		PendingPerfCaptureWrite.Wait();
+	}
+
+	PendingPerfCaptureWrites.Reset();
 }
 
 void UJTInputPlayer::Tick(float DeltaTime)
 {
+	JT_AUTOREPLAY_LLM_SCOPE();
+
 	Super::Tick(DeltaTime);
 
+	TickPendingSessionLoad();
 	TickCurrentSession();
+	TickDivergenceDetection();
+	ApplyTimeStep();
+
+	if (bCurrentlyPlayingSession)
+	{
+		const FJTFrameDelta CurrentFrameDelta = static_cast<FJTFrameDelta>(GFrameCounter - SessionStartFrame);
+		if (bIsCapturingPerf)
+		{
+			CurrentPerfCapture.AddSample(CurrentFrameDelta, LastTimelineEventIndex, CurrentRecordingPlayCount, NumFrameInjectedEvents);
+		}
+
+		TRACE_COUNTER_SET(JTAutoReplay_FrameEventsInjected, NumFrameInjectedEvents);
+		TRACE_COUNTER_SET(JTAutoReplay_PlaybackTimelineFrame, LastTimelineEventIndex);
+
+		if (JT::AutoReplay::Profiling::ShouldBookmarkFrame(CurrentFrameDelta))
+		{
+			TRACE_BOOKMARK(TEXT("AutoReplay Playback Frame %u (Timeline Frame %d)"), CurrentFrameDelta, LastTimelineEventIndex);
+		}
+	}
+
 	DrawDebug();
 }
 
 TStatId UJTInputPlayer::GetStatId() const
 {
-	RETURN_QUICK_DECLARE_CYCLE_STAT(UJTInputPlayer, STATGROUP_Tickables);
+	return GET_STATID(STAT_JTInputPlayer_Tick);
 }
 
 bool UJTInputPlayer::DoesSupportWorldType(const EWorldType::Type WorldType) const
@@ -48,6 +84,10 @@ bool UJTInputPlayer::DoesSupportWorldType(const EWorldType::Type WorldType) cons
 
 void UJTInputPlayer::RequestPlay(const FJTInputPlayerRequestParams RequestParams)
 {
+	FinishPerfCapture();
+	CurrentPerfCaptureFilePath.Empty();
+
+	NumInjectedEvents = 0;
 	RequestPlay_Internal(RequestParams, true);
 }
 
@@ -56,27 +96,119 @@ void UJTInputPlayer::StopPlaying()
 	StopPlaying_Internal(true);
 }
 
+bool UJTInputPlayer::SeekToFrame(int32 Frame)
+{
+	if (!bCurrentlyPlayingSession)
+	{
+		UE_LOG(LogJTInputPlayer, Warning, TEXT("Cannot seek to frame %d. No session is playing"), Frame);
+		return false;
+	}
+
+	SeekToFrame_Internal(static_cast<FJTFrameDelta>(FMath::Max(Frame, 0)));
+	return true;
+}
+
+int32 UJTInputPlayer::GetCurrentFrame() const
+{
+	if (!bCurrentlyPlayingSession)
+	{
+		return INDEX_NONE;
+	}
+
+	return static_cast<int32>(static_cast<FJTFrameDelta>(GFrameCounter - SessionStartFrame));
+}
+
+SIZE_T UJTInputPlayer::GetAllocatedSize() const
+{
+	FJTAutoReplayMemoryReport MemoryReport;
+	GetMemoryReport(MemoryReport);
+	return MemoryReport.GetTotal();
+}
+
+void UJTInputPlayer::GetMemoryReport(FJTAutoReplayMemoryReport& OutReport) const
+{
+	if (CurrentProgram)
+	{
+		OutReport.Add(TEXT("Playback Program"), CurrentProgram->GetAllocatedSize());
+	}
+
+	OutReport.Add(TEXT("Perf Capture"), (CurrentPerfCapture.Samples.GetAllocatedSize() + CurrentPerfCaptureFilePath.GetAllocatedSize()));
+	OutReport.Add(TEXT("Player Controllers"), ControllerSlotPlayerControllers.GetAllocatedSize());
+}
+
 void UJTInputPlayer::StartPlaying()
 {
+	JT_AUTOREPLAY_LLM_SCOPE();
+
 	ResetStartTimerHandle();
+	bHasPendingPlayRequest = false;
+
+	if (!TryBindInputTarget())
+	{
+		UE_LOG(LogJTInputPlayer, Error, TEXT("Cannot start playing %s. No game viewport or local player controller to play input into"), *CachedCurrentRequestParams.RecordingFilePath.FilePath);
+		FailPlayRequest(OnFailedToStartPlaying);
+		return;
+	}
 
 	if (CachedCurrentRequestParams.bRestorePlayerSpatialDataOnStart)
 	{
-		const bool bRestoredPlayerSpatialData = TryRestorePlayerSpatialData();
+		const bool bRestoredPlayerSpatialData = TryRestorePlayerSpatialData(CurrentProgram->GetSession().PlayersSpatialDataCollection);
 		if (!bRestoredPlayerSpatialData)
 		{
 			UE_LOG(LogJTInputPlayer,
 				Error,
 				TEXT("Cannot start playing %s. Unable to restore player spatial data on start. Is the player count the same as the recording?"), *CachedCurrentRequestParams.RecordingFilePath.FilePath);
+			FailPlayRequest(OnFailedToStartPlaying);
 			return;
 		}
 	}
 
+	if (CachedCurrentRequestParams.bRestoreRandomSeeds)
+	{
+		const FJTInputRecordingSession& Session = CurrentProgram->GetSession();
+		const int32 NumRestoredStreamSeeds = Session.RestoreRandomSeeds();
+		if (NumRestoredStreamSeeds != INDEX_NONE && NumRestoredStreamSeeds < Session.RandomStreamSeeds.Num())
+		{
+			UE_LOG(LogJTInputPlayer, Warning, TEXT("Only %d of the %d random streams recorded in %s are registered. The rest will draw different values than they did while recording"),
+				NumRestoredStreamSeeds, Session.RandomStreamSeeds.Num(), *CachedCurrentRequestParams.RecordingFilePath.FilePath);
+		}
+	}
+
+	if (!bIsCapturingPerf && (CachedCurrentRequestParams.bCapturePerformance || JT::AutoReplay::InputPlayer::CVarCapturePerformance.GetValueOnGameThread()))
+	{
+		BeginPerfCapture();
+	}
+
 	SessionStartFrame = GFrameCounter;
 	LastTimelineEventIndex = INDEX_NONE;
+	NextDivergenceCheckpointIndex = 0;
+	bHasDiverged = false;
 	bCurrentlyPlayingSession = true;
 
+	if (CachedCurrentRequestParams.StartFrame > 0)
+	{
+		SeekToFrame_Internal(static_cast<FJTFrameDelta>(CachedCurrentRequestParams.StartFrame));
+	}
+
+	if (!bIsInTurbo && (CachedCurrentRequestParams.bTurbo || JT::AutoReplay::InputPlayer::CVarTurbo.GetValueOnGameThread()))
+	{
+		BeginTurbo();
+	}
+
+	if (CachedCurrentRequestParams.TimeStep == EJTInputPlaybackTimeStep::Recorded && CurrentProgram->GetSession().DeltaTimes.IsEmpty())
+	{
+		UE_LOG(LogJTInputPlayer, Warning, TEXT("%s has no recorded delta times. Stepping every frame by %.4fs instead"),
+			*CachedCurrentRequestParams.RecordingFilePath.FilePath, CachedCurrentRequestParams.FixedTimeStepSeconds);
+	}
+
+	ApplyTimeStep();
+
+	const SIZE_T ProgramMemory = CurrentProgram->GetAllocatedSize();
+	SET_MEMORY_STAT(STAT_JTInputPlayer_ProgramMemory, ProgramMemory);
+	TRACE_COUNTER_SET(JTAutoReplay_PlaybackProgramMemory, ProgramMemory);
+
 	UE_LOG(LogJTInputPlayer, Log, TEXT("Play Started"));
+	TRACE_BOOKMARK(TEXT("AutoReplay Play Started (Play %d)"), CurrentRecordingPlayCount);
 
 	OnStartedPlaying.Broadcast();
 }
@@ -85,38 +217,107 @@ void UJTInputPlayer::RequestPlay_Internal(
 	const FJTInputPlayerRequestParams& RequestParams,
 	bool bShouldResetExistingRequest)
 {
-	if (bCurrentlyPlayingSession)
-	{
-		StopPlaying_Internal(bShouldResetExistingRequest);
-	}
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	// Also cancels (and if asked, resets) a request that is still loading or waiting on its start delay
+	StopPlaying_Internal(bShouldResetExistingRequest);
 
 	UE_LOG(LogJTInputPlayer, Log, TEXT("Play Requested"));
 
 	CachedCurrentRequestParams = RequestParams;
 
-	const bool bImportedSession = FJTInputSerializer::ImportSessionFromJson(CachedCurrentRequestParams.RecordingFilePath, CurrentSession);
-	if (!bImportedSession)
-	{
-		UE_LOG(
-			LogJTInputPlayer, Error, TEXT("Cannot complete play request %s. Unable to import session from file"), *CachedCurrentRequestParams.RecordingFilePath.FilePath);
-		return;
-	}
+	// The session is decoded and compiled into a playback program on a worker thread (or reused from the session cache
+	// when looping/replaying), overlapping with the start delay. Play starts once both are done
+	PendingSessionLoad = FJTInputSessionCache::Get().LoadSessionAsync(CachedCurrentRequestParams.RecordingFilePath)
+		.Then([ExistingProgram = CurrentProgram](TFuture<TSharedPtr<const FJTInputRecordingSession>> SessionFuture) -> TSharedPtr<FJTInputPlaybackProgram>
+			{
+				const TSharedPtr<const FJTInputRecordingSession> LoadedSession = SessionFuture.Get();
+				if (!LoadedSession.IsValid())
+				{
+					return nullptr;
+				}
+
+				// Replaying the same cached session (e.g. when looping) can reuse the program that is already compiled
+				if (ExistingProgram.IsValid() && (&ExistingProgram->GetSession() == LoadedSession.Get()))
+				{
+					return ExistingProgram;
+				}
+
+				return FJTInputPlaybackProgram::Compile(LoadedSession.ToSharedRef());
+			});
+	bHasPendingPlayRequest = true;
+	bIsLoadingSession = true;
+	bIsStartDelayElapsed = false;
 
 	if (CachedCurrentRequestParams.TimeDelayBeforePlaying > 0.f)
 	{
 		GetWorld()->GetTimerManager().SetTimer(
-			CurrentSessionStartTimerHandle, this, &UJTInputPlayer::StartPlaying, CachedCurrentRequestParams.TimeDelayBeforePlaying);
+			CurrentSessionStartTimerHandle, this, &UJTInputPlayer::OnStartDelayElapsed, CachedCurrentRequestParams.TimeDelayBeforePlaying);
 	}
 	else
+	{
+		bIsStartDelayElapsed = true;
+	}
+}
+
+void UJTInputPlayer::TryStartPlaying()
+{
+	if (bHasPendingPlayRequest && !bIsLoadingSession && bIsStartDelayElapsed)
 	{
 		StartPlaying();
 	}
 }
 
+void UJTInputPlayer::OnStartDelayElapsed()
+{
+	bIsStartDelayElapsed = true;
+	TryStartPlaying();
+}
+
+void UJTInputPlayer::TickPendingSessionLoad()
+{
+	if (!bIsLoadingSession || !PendingSessionLoad.IsReady())
+	{
+		return;
+	}
+
+	TSharedPtr<FJTInputPlaybackProgram> LoadedProgram = PendingSessionLoad.Get();
+	PendingSessionLoad.Reset();
+	bIsLoadingSession = false;
+
+	if (!LoadedProgram.IsValid())
+	{
+		UE_LOG(LogJTInputPlayer, Error, TEXT("Cannot complete play request %s. Unable to import session from file"), *CachedCurrentRequestParams.RecordingFilePath.FilePath);
+		FailPlayRequest(OnFailedToLoadSession);
+		return;
+	}
+
+	CurrentProgram = LoadedProgram;
+	TryStartPlaying();
+}
+
+void UJTInputPlayer::CancelPendingPlayRequest()
+{
+	ResetStartTimerHandle();
+
+	PendingSessionLoad.Reset();
+	bHasPendingPlayRequest = false;
+	bIsLoadingSession = false;
+	bIsStartDelayElapsed = false;
+}
+
 void UJTInputPlayer::StopPlaying_Internal(bool bShouldResetExistingRequest)
 {
 	if (!bCurrentlyPlayingSession)
 	{
+		CancelPendingPlayRequest();
+
+		// A loop of the request may be pending, with its playback settings still applied
+		if (bShouldResetExistingRequest)
+		{
+			ResetPlayRequest();
+		}
+
 		return;
 	}
 
@@ -124,40 +325,79 @@ void UJTInputPlayer::StopPlaying_Internal(bool bShouldResetExistingRequest)
 
 	StopOngoingInput();
 
-	CurrentSession.ClearSessionData();
 	SessionStopFrame = GFrameCounter;
 	LastTimelineEventIndex = INDEX_NONE;
 	bCurrentlyPlayingSession = false;
 	if (bShouldResetExistingRequest)
 	{
-		CachedCurrentRequestParams = FJTInputPlayerRequestParams();
-		CurrentRecordingPlayCount = 0;
+		ResetPlayRequest();
 	}
 
 	UE_LOG(LogJTInputPlayer, Log, TEXT("Play Stopped"));
+	TRACE_BOOKMARK(TEXT("AutoReplay Play Stopped"));
 
 	OnStoppedPlaying.Broadcast();
 }
 
+void UJTInputPlayer::ResetPlayRequest()
+{
+	FinishPerfCapture();
+	RestoreTimeStep();
+	EndTurbo();
+
+	// Kept around between loops, so that the next loop of the same session can reuse them
+	CurrentProgram.Reset();
+	CachedGameViewportClient.Reset();
+	CachedGameViewport = nullptr;
+	ControllerSlotPlayerControllers.Reset();
+	bIsInjectingIntoPlayerControllers = false;
+
+	CachedCurrentRequestParams = FJTInputPlayerRequestParams();
+	CurrentRecordingPlayCount = 0;
+
+	SET_MEMORY_STAT(STAT_JTInputPlayer_ProgramMemory, 0);
+	TRACE_COUNTER_SET(JTAutoReplay_PlaybackProgramMemory, 0);
+}
+
+void UJTInputPlayer::FailPlayRequest(const FJTInputPlayerFailedDelegate& InFailureDelegate)
+{
+	const FString FailedFilePath = CachedCurrentRequestParams.RecordingFilePath.FilePath;
+
+	// Later loops of a request fail with the settings applied by its first play (time step, turbo, perf capture) still in place
+	CancelPendingPlayRequest();
+	ResetPlayRequest();
+
+	TRACE_BOOKMARK(TEXT("AutoReplay Play Failed"));
+
+	InFailureDelegate.Broadcast(FailedFilePath);
+}
+
 void UJTInputPlayer::TickCurrentSession()
 {
+	NumFrameInjectedEvents = 0;
+
 	if (!bCurrentlyPlayingSession)
 	{
 		return;
 	}
 
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputPlayer_TickCurrentSession);
+	JT_AUTOREPLAY_LLM_SCOPE();
+
 	int32 NextTimelineEventIndex = 0;
 	if (LastTimelineEventIndex != INDEX_NONE)
 	{
 		NextTimelineEventIndex = LastTimelineEventIndex + 1;
 	}
 
-	if (!CurrentSession.InputTimeline.IsValidIndex(NextTimelineEventIndex))
+	const FJTInputPlaybackProgram& Program = *CurrentProgram;
+	if (!Program.IsValidIndex(NextTimelineEventIndex))
 	{
 		++CurrentRecordingPlayCount;
 		if ((CachedCurrentRequestParams.NumTimesToPlay < 0)
 			|| (CurrentRecordingPlayCount < CachedCurrentRequestParams.NumTimesToPlay))
 		{
+			TRACE_BOOKMARK(TEXT("AutoReplay Play Looped (Play %d)"), CurrentRecordingPlayCount);
 			RequestPlay_Internal(CachedCurrentRequestParams, false);
 		}
 		else
@@ -169,49 +409,466 @@ void UJTInputPlayer::TickCurrentSession()
 	}
 
 	const FJTFrameDelta CurrentFrameDelta = (GFrameCounter - SessionStartFrame);
-	const FJTFrameDelta NextTimelineEventFrameDelta = CurrentSession.InputTimeline[NextTimelineEventIndex].FrameDelta;
+	const FJTFrameDelta NextTimelineEventFrameDelta = Program[NextTimelineEventIndex].FrameDelta;
 
 	if (CurrentFrameDelta != NextTimelineEventFrameDelta)
 	{
 		return;
 	}
 
-	UGameViewportClient* GameViewportClient = GetWorld()->GetGameInstance()->GetGameViewportClient();
-	if (!IsValid(GameViewportClient))
+	const TArrayView<const FJTInputPlaybackProgram::FOp> FrameOps = Program.GetFrameOps(NextTimelineEventIndex);
+	NumInjectedEvents += FrameOps.Num();
+	NumFrameInjectedEvents = FrameOps.Num();
+	INC_DWORD_STAT_BY(STAT_JTInputPlayer_FrameEvents, NumFrameInjectedEvents);
+	SET_DWORD_STAT(STAT_JTInputPlayer_SessionEvents, NumInjectedEvents);
+	SET_DWORD_STAT(STAT_JTInputPlayer_TimelineFrame, NextTimelineEventIndex);
+
+	if (bIsInjectingIntoPlayerControllers)
+	{
+		for (const FJTInputPlaybackProgram::FOp& Op : FrameOps)
+		{
+			if (APlayerController* PlayerController = ControllerSlotPlayerControllers[Op.ControllerSlot].Get())
+			{
+				PlayerController->InputKey(Op.MakeInputKeyParams());
+			}
+		}
+	}
+	else
+	{
+		UGameViewportClient* GameViewportClient = CachedGameViewportClient.Get();
+		if (GameViewportClient && (GameViewportClient->GetGameViewport() == CachedGameViewport))
+		{
+			for (const FJTInputPlaybackProgram::FOp& Op : FrameOps)
+			{
+				if (Op.EventType == EJTInputEventType::Key)
+				{
+					GameViewportClient->InputKey(Op.MakeKeyEventArgs(CachedGameViewport, Program.GetControllerId(Op.ControllerSlot)));
+				}
+				else
+				{
+					GameViewportClient->InputAxis(CachedGameViewport, Op.InputDevice, Op.Key, Op.Delta, Op.DeltaTime, Op.NumSamples, Op.bGamepad);
+				}
+			}
+		}
+	}
+
+	LastTimelineEventIndex = NextTimelineEventIndex;
+}
+
+void UJTInputPlayer::SeekToFrame_Internal(FJTFrameDelta InFrameDelta)
+{
+	const FJTInputPlaybackProgram& Program = *CurrentProgram;
+
+	const FJTSpatialCheckpointTrack& Checkpoints = Program.GetSession().SpatialCheckpoints;
+	if (CachedCurrentRequestParams.bRestoreSpatialCheckpointOnSeek && InFrameDelta > 0)
+	{
+		// A checkpoint holds the state at the end of its frame, so playback resumes on the frame after it
+		const int32 CheckpointIndex = Checkpoints.FindCheckpointIndex(InFrameDelta - 1);
+		if (CheckpointIndex != INDEX_NONE)
+		{
+			if (TryRestorePlayerSpatialData(Checkpoints.GetPlayers(CheckpointIndex)))
+			{
+				UE_LOG(LogJTInputPlayer, Log, TEXT("Restored spatial checkpoint at frame %u. Seeking from there instead of frame %u"),
+					Checkpoints[CheckpointIndex].FrameDelta, InFrameDelta);
+				InFrameDelta = (Checkpoints[CheckpointIndex].FrameDelta + 1);
+			}
+			else
+			{
+				UE_LOG(LogJTInputPlayer, Warning, TEXT("Unable to restore spatial checkpoint at frame %u. Is the player count the same as the recording?"),
+					Checkpoints[CheckpointIndex].FrameDelta);
+			}
+		}
+	}
+
+	const int32 TargetFrameIndex = Program.FindFrameIndex(InFrameDelta);
+
+	// Release whatever is held now, then press what was held going into the target frame
+	StopOngoingInput();
+
+	TArray<const FJTInputPlaybackProgram::FOp*> HeldKeyOps;
+	Program.GatherHeldKeyOps(TargetFrameIndex, HeldKeyOps);
+
+	for (const FJTInputPlaybackProgram::FOp* HeldKeyOp : HeldKeyOps)
+	{
+		InjectKeyPress(*HeldKeyOp);
+	}
+
+	UE_LOG(LogJTInputPlayer, Log, TEXT("Seeked to frame %u (%d held keys restored)"), InFrameDelta, HeldKeyOps.Num());
+	TRACE_BOOKMARK(TEXT("AutoReplay Seeked to Frame %u"), InFrameDelta);
+
+	// Rebase the session start so that the target frame is the current one
+	SessionStartFrame = (GFrameCounter - InFrameDelta);
+	LastTimelineEventIndex = (TargetFrameIndex - 1);
+	NextDivergenceCheckpointIndex = ((InFrameDelta > 0) ? (Checkpoints.FindCheckpointIndex(InFrameDelta - 1) + 1) : 0);
+
+	// Divergence is only reported once per play, so seeking (e.g. back to before it, or onto a restored checkpoint) starts detecting afresh
+	bHasDiverged = false;
+
+	ApplyTimeStep();
+}
+
+void UJTInputPlayer::TickDivergenceDetection()
+{
+	if (!bCurrentlyPlayingSession || bHasDiverged || !CachedCurrentRequestParams.bDetectDivergence)
+	{
+		return;
+	}
+
+	const FJTFrameDelta CurrentFrameDelta = static_cast<FJTFrameDelta>(GFrameCounter - SessionStartFrame);
+	if (CurrentFrameDelta == 0)
+	{
+		return;
+	}
+
+	// Input injected on a frame is only handled on the next world tick, so playback runs a frame behind the recording:
+	// the world tick of playback frame N + 1 simulates recorded frame N (see ApplyTimeStep). The game is now where the
+	// recording was at the end of the previous frame
+	const FJTFrameDelta ComparedFrameDelta = (CurrentFrameDelta - 1);
+
+	const FJTSpatialCheckpointTrack& Checkpoints = CurrentProgram->GetSession().SpatialCheckpoints;
+	while (Checkpoints.IsValidIndex(NextDivergenceCheckpointIndex) && Checkpoints[NextDivergenceCheckpointIndex].FrameDelta < ComparedFrameDelta)
+	{
+		++NextDivergenceCheckpointIndex;
+	}
+
+	if (!Checkpoints.IsValidIndex(NextDivergenceCheckpointIndex) || Checkpoints[NextDivergenceCheckpointIndex].FrameDelta != ComparedFrameDelta)
+	{
+		return;
+	}
+
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputPlayer_TickDivergenceDetection);
+
+	FJTInputPlaybackDivergence Divergence;
+	const bool bHasDivergedThisFrame = MeasureDivergence(NextDivergenceCheckpointIndex++, Divergence);
+	if (!bHasDivergedThisFrame)
+	{
+		return;
+	}
+
+	bHasDiverged = true;
+
+	if (Divergence.PlayerIndex == INDEX_NONE)
+	{
+		UE_LOG(LogJTInputPlayer, Warning, TEXT("Playback of %s diverged from the recording at frame %d. The number of players no longer matches"),
+			*CachedCurrentRequestParams.RecordingFilePath.FilePath, Divergence.Frame);
+	}
+	else
+	{
+		UE_LOG(LogJTInputPlayer, Warning, TEXT("Playback of %s diverged from the recording at frame %d. Player %d is off by %.1f units and %.1f degrees"),
+			*CachedCurrentRequestParams.RecordingFilePath.FilePath, Divergence.Frame, Divergence.PlayerIndex, Divergence.PositionError, Divergence.RotationError);
+	}
+
+	TRACE_BOOKMARK(TEXT("AutoReplay Playback Diverged (Frame %d)"), Divergence.Frame);
+
+	const bool bShouldStop = CachedCurrentRequestParams.bStopOnDivergence;
+	OnPlaybackDiverged.Broadcast(Divergence);
+
+	if (bShouldStop && bCurrentlyPlayingSession)
+	{
+		StopPlaying_Internal(true);
+	}
+}
+
+void UJTInputPlayer::ApplyTimeStep()
+{
+	// Uncapped variable frames would be far shorter than the recorded ones, so turbo always steps by a fixed amount
+	EJTInputPlaybackTimeStep TimeStep = CachedCurrentRequestParams.TimeStep;
+	if (bIsInTurbo && TimeStep == EJTInputPlaybackTimeStep::Variable)
+	{
+		TimeStep = EJTInputPlaybackTimeStep::Fixed;
+	}
+
+	if (!bCurrentlyPlayingSession || TimeStep == EJTInputPlaybackTimeStep::Variable)
+	{
+		return;
+	}
+
+	if (!bIsOverridingTimeStep)
+	{
+		bWasUsingFixedTimeStep = FApp::UseFixedTimeStep();
+		PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+		bIsOverridingTimeStep = true;
+	}
+
+	// Input injected on a frame is only handled on the next world tick, so playback runs a frame behind the recording:
+	// the world tick of playback frame N + 1 simulates recorded frame N (see TickDivergenceDetection). The engine picks
+	// up the fixed delta time as the next frame starts, so it's set to the delta time of the recorded frame the next
+	// frame simulates, i.e. that of the current frame
+	const FJTFrameDelta SimulatedFrameDelta = static_cast<FJTFrameDelta>(GFrameCounter - SessionStartFrame);
+	const FJTDeltaTimeTrack& DeltaTimes = CurrentProgram->GetSession().DeltaTimes;
+
+	float DeltaSeconds = CachedCurrentRequestParams.FixedTimeStepSeconds;
+	if (TimeStep == EJTInputPlaybackTimeStep::Recorded && DeltaTimes.HasFrame(SimulatedFrameDelta))
+	{
+		DeltaSeconds = DeltaTimes.GetDeltaSeconds(SimulatedFrameDelta);
+	}
+
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(FMath::Max(DeltaSeconds, UE_KINDA_SMALL_NUMBER));
+}
+
+void UJTInputPlayer::RestoreTimeStep()
+{
+	if (!bIsOverridingTimeStep)
 	{
 		return;
 	}
 
-	FSceneViewport* GameViewport = GameViewportClient->GetGameViewport();
-	if (!GameViewport)
+	FApp::SetUseFixedTimeStep(bWasUsingFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+	bIsOverridingTimeStep = false;
+}
+
+void UJTInputPlayer::BeginTurbo()
+{
+	bIsInTurbo = true;
+
+	UGameViewportClient* GameViewportClient = GetWorld()->GetGameInstance()->GetGameViewportClient();
+	if (IsValid(GameViewportClient))
+	{
+		TurboGameViewportClient = GameViewportClient;
+		bWasWorldRenderingDisabled = GameViewportClient->bDisableWorldRendering;
+		GameViewportClient->bDisableWorldRendering = true;
+	}
+
+	bWasSmoothingFrameRate = GEngine->bSmoothFrameRate;
+	bWasUsingFixedFrameRate = GEngine->bUseFixedFrameRate;
+	GEngine->bSmoothFrameRate = false;
+	GEngine->bUseFixedFrameRate = false;
+
+	// Set with the priority they already have, so that it isn't rejected for being lower (e.g. if set from an ini)
+	if (IConsoleVariable* MaxFPSVar = IConsoleManager::Get().FindConsoleVariable(TEXT("t.MaxFPS")))
+	{
+		PreviousMaxFPS = MaxFPSVar->GetFloat();
+		MaxFPSVar->Set(0.f, static_cast<EConsoleVariableFlags>(MaxFPSVar->GetFlags() & ECVF_SetByMask));
+	}
+
+	if (IConsoleVariable* VSyncVar = IConsoleManager::Get().FindConsoleVariable(TEXT("r.VSync")))
+	{
+		PreviousVSync = VSyncVar->GetInt();
+		VSyncVar->Set(0, static_cast<EConsoleVariableFlags>(VSyncVar->GetFlags() & ECVF_SetByMask));
+	}
+
+	UE_LOG(LogJTInputPlayer, Log, TEXT("Turbo on. World rendering is off and the frame rate is uncapped until playback stops"));
+}
+
+void UJTInputPlayer::EndTurbo()
+{
+	if (!bIsInTurbo)
 	{
 		return;
 	}
 
-	for (const FJTInputTimelineEvent& TimelineEvent : CurrentSession.InputTimeline[NextTimelineEventIndex].FrameEvents)
+	if (UGameViewportClient* GameViewportClient = TurboGameViewportClient.Get())
+	{
+		GameViewportClient->bDisableWorldRendering = bWasWorldRenderingDisabled;
+	}
+
+	TurboGameViewportClient.Reset();
+
+	GEngine->bSmoothFrameRate = bWasSmoothingFrameRate;
+	GEngine->bUseFixedFrameRate = bWasUsingFixedFrameRate;
+
+	if (IConsoleVariable* MaxFPSVar = IConsoleManager::Get().FindConsoleVariable(TEXT("t.MaxFPS")))
+	{
+		MaxFPSVar->Set(PreviousMaxFPS, static_cast<EConsoleVariableFlags>(MaxFPSVar->GetFlags() & ECVF_SetByMask));
+	}
+
+	if (IConsoleVariable* VSyncVar = IConsoleManager::Get().FindConsoleVariable(TEXT("r.VSync")))
+	{
+		VSyncVar->Set(PreviousVSync, static_cast<EConsoleVariableFlags>(VSyncVar->GetFlags() & ECVF_SetByMask));
+	}
+
+	bIsInTurbo = false;
+
+	UE_LOG(LogJTInputPlayer, Log, TEXT("Turbo off"));
+}
+
+bool UJTInputPlayer::MeasureDivergence(int32 InCheckpointIndex, FJTInputPlaybackDivergence& OutDivergence) const
+{
+	const FJTSpatialCheckpointTrack& Checkpoints = CurrentProgram->GetSession().SpatialCheckpoints;
+	const TArrayView<const FJTPlayerSpatialData> RecordedPlayers = Checkpoints.GetPlayers(InCheckpointIndex);
+
+	OutDivergence.Frame = static_cast<int32>(Checkpoints[InCheckpointIndex].FrameDelta);
+	OutDivergence.PlayerIndex = INDEX_NONE;
+
+	// Players are matched up with the recording in the same order their spatial data is gathered and restored in
+	int32 PlayerIndex = 0;
+	const TArray<ULocalPlayer*>& LocalPlayers = GetWorld()->GetGameInstance()->GetLocalPlayers();
+	for (const ULocalPlayer* LocalPlayer : LocalPlayers)
+	{
+		const APlayerController* PlayerController = LocalPlayer->PlayerController;
+		const APawn* PlayerPawn = (PlayerController ? PlayerController->GetPawn() : nullptr);
+		if (!PlayerPawn)
+		{
+			continue;
+		}
+
+		if (!RecordedPlayers.IsValidIndex(PlayerIndex))
+		{
+			return true;
+		}
+
+		const FJTPlayerSpatialData& RecordedPlayer = RecordedPlayers[PlayerIndex];
+
+		const float PositionError = static_cast<float>(FVector::Dist(PlayerPawn->GetActorLocation(), RecordedPlayer.PawnTransform.GetLocation()));
+		const float PawnRotationError = static_cast<float>(FMath::RadiansToDegrees(PlayerPawn->GetActorQuat().AngularDistance(RecordedPlayer.PawnTransform.GetRotation())));
+		const float ControlRotationError = static_cast<float>(FMath::RadiansToDegrees(PlayerController->GetControlRotation().Quaternion().AngularDistance(RecordedPlayer.ControlRotation.Quaternion())));
+		const float RotationError = FMath::Max(PawnRotationError, ControlRotationError);
+
+		if (PositionError > CachedCurrentRequestParams.DivergencePositionTolerance || RotationError > CachedCurrentRequestParams.DivergenceRotationTolerance)
+		{
+			OutDivergence.PlayerIndex = PlayerIndex;
+			OutDivergence.PositionError = PositionError;
+			OutDivergence.RotationError = RotationError;
+			return true;
+		}
+
+		++PlayerIndex;
+	}
+
+	return (PlayerIndex != RecordedPlayers.Num());
+}
+
+bool UJTInputPlayer::TryBindInputTarget()
+{
+	const EJTInputInjectionMode InjectionMode = CachedCurrentRequestParams.InjectionMode;
+
+	if (InjectionMode != EJTInputInjectionMode::PlayerController)
 	{
-		if (TimelineEvent.EventType == EJTInputEventType::Key)
+		UGameViewportClient* GameViewportClient = GetWorld()->GetGameInstance()->GetGameViewportClient();
+		FSceneViewport* GameViewport = (IsValid(GameViewportClient) ? GameViewportClient->GetGameViewport() : nullptr);
+		if (GameViewport)
 		{
-			const FJTInputKeyEventArgs& KeyEventArgs = TimelineEvent.KeyEventArgs;
-			GameViewportClient->InputKey(FInputKeyEventArgs(GameViewport, KeyEventArgs.ControllerId, KeyEventArgs.Key, KeyEventArgs.Event, KeyEventArgs.AmountDepressed, KeyEventArgs.bIsTouchEvent));
+			CachedGameViewportClient = GameViewportClient;
+			CachedGameViewport = GameViewport;
+			bIsInjectingIntoPlayerControllers = false;
+
+			if (!CurrentProgram->IsBoundTo(GameViewport))
+			{
+				CurrentProgram->Bind(GameViewport);
+			}
+
+			return true;
 		}
-		else if (TimelineEvent.EventType == EJTInputEventType::Axis)
+
+		if (InjectionMode == EJTInputInjectionMode::Viewport)
 		{
-			const FJTInputAxisEventArgs& AxisEventArgs = TimelineEvent.AxisEventArgs;
+			return false;
+		}
 
-			IPlatformInputDeviceMapper& DeviceMapper = IPlatformInputDeviceMapper::Get();
-			FPlatformUserId UserId = PLATFORMUSERID_NONE;
-			FInputDeviceId DeviceId = INPUTDEVICEID_NONE;
-			DeviceMapper.RemapControllerIdToPlatformUserAndDevice(AxisEventArgs.ControllerId, UserId, DeviceId);
+		UE_LOG(LogJTInputPlayer, Log, TEXT("No game viewport to play input into. Injecting input straight into the player controllers"));
+	}
+
+	return TryBindPlayerControllers();
+}
+
+bool UJTInputPlayer::TryBindPlayerControllers()
+{
+	const TArray<ULocalPlayer*>& LocalPlayers = GetWorld()->GetGameInstance()->GetLocalPlayers();
 
-			GameViewportClient->InputAxis(GameViewport, DeviceId, AxisEventArgs.Key, AxisEventArgs.Delta, AxisEventArgs.DeltaTime, AxisEventArgs.NumSamples, AxisEventArgs.bGamepad);
+	APlayerController* FallbackPlayerController = nullptr;
+	for (const ULocalPlayer* LocalPlayer : LocalPlayers)
+	{
+		if (LocalPlayer->PlayerController)
+		{
+			FallbackPlayerController = LocalPlayer->PlayerController;
+			break;
 		}
 	}
 
-	LastTimelineEventIndex = NextTimelineEventIndex;
+	if (!FallbackPlayerController)
+	{
+		return false;
+	}
+
+	// Input recorded for a controller id goes to the local player with that id, or the first local player if there isn't one
+	ControllerSlotPlayerControllers.Reset(CurrentProgram->NumControllers());
+	for (int32 ControllerSlot = 0; ControllerSlot < CurrentProgram->NumControllers(); ++ControllerSlot)
+	{
+		const int32 ControllerId = CurrentProgram->GetControllerId(ControllerSlot);
+
+		APlayerController* SlotPlayerController = FallbackPlayerController;
+		for (const ULocalPlayer* LocalPlayer : LocalPlayers)
+		{
+			if (LocalPlayer->PlayerController && LocalPlayer->GetControllerId() == ControllerId)
+			{
+				SlotPlayerController = LocalPlayer->PlayerController;
+				break;
+			}
+		}
+
+		ControllerSlotPlayerControllers.Emplace(SlotPlayerController);
+	}
+
+	CachedGameViewportClient.Reset();
+	CachedGameViewport = nullptr;
+	bIsInjectingIntoPlayerControllers = true;
+
+	if (!CurrentProgram->IsBoundTo(nullptr))
+	{
+		CurrentProgram->Bind(nullptr);
+	}
+
+	return true;
+}
+
+void UJTInputPlayer::InjectKeyPress(const FJTInputPlaybackProgram::FOp& InKeyOp)
+{
+	if (bIsInjectingIntoPlayerControllers)
+	{
+		if (APlayerController* PlayerController = ControllerSlotPlayerControllers[InKeyOp.ControllerSlot].Get())
+		{
+			PlayerController->InputKey(InKeyOp.MakeInputKeyParams(IE_Pressed));
+		}
+	}
+	else
+	{
+		UGameViewportClient* GameViewportClient = CachedGameViewportClient.Get();
+		if (GameViewportClient && (GameViewportClient->GetGameViewport() == CachedGameViewport))
+		{
+			GameViewportClient->InputKey(InKeyOp.MakeKeyEventArgs(CachedGameViewport, CurrentProgram->GetControllerId(InKeyOp.ControllerSlot), IE_Pressed));
+		}
+	}
 }
 
-bool UJTInputPlayer::TryRestorePlayerSpatialData()
+void UJTInputPlayer::BeginPerfCapture()
+{
+	const FString& SessionFilePath = CachedCurrentRequestParams.RecordingFilePath.FilePath;
+
+	CurrentPerfCaptureFilePath = CachedCurrentRequestParams.PerfCaptureFilePath;
+	if (CurrentPerfCaptureFilePath.IsEmpty())
+	{
+		CurrentPerfCaptureFilePath = FJTInputPerfCapture::MakeDefaultFilePath(SessionFilePath);
+	}
+
+	// Reserved for a single play of the whole recording up front, so that sampling doesn't allocate while measuring
+	const int32 NumRecordedFrames = (CurrentProgram->Num() > 0) ? static_cast<int32>((*CurrentProgram)[CurrentProgram->Num() - 1].FrameDelta + 1) : 0;
+	CurrentPerfCapture.Reset(SessionFilePath, NumRecordedFrames);
+	bIsCapturingPerf = true;
+
+	UE_LOG(LogJTInputPlayer, Log, TEXT("Performance capture started for %s"), *SessionFilePath);
+}
+
+void UJTInputPlayer::FinishPerfCapture()
+{
+	if (!bIsCapturingPerf)
+	{
+		return;
+	}
+
+	bIsCapturingPerf = false;
+
+	UE_LOG(LogJTInputPlayer, Log, TEXT("Performance capture of %d frames being written to %s"), CurrentPerfCapture.Samples.Num(), *CurrentPerfCaptureFilePath);
+
+	// Completed writes are dropped here, so the list only ever holds the few still in flight
+	PendingPerfCaptureWrites.RemoveAll([](const TFuture<bool>& PendingPerfCaptureWrite) { return PendingPerfCaptureWrite.IsReady(); });
+	PendingPerfCaptureWrites.Emplace(FJTInputPerfCapture::SaveToCsvAsync(CurrentPerfCaptureFilePath, MoveTemp(CurrentPerfCapture)));
+
+	CurrentPerfCapture = FJTInputPerfCapture();
+}
+
+bool UJTInputPlayer::TryRestorePlayerSpatialData(TArrayView<const FJTPlayerSpatialData> InPlayersSpatialData)
 {
 	const TArray<ULocalPlayer*>& LocalPlayers = GetWorld()->GetGameInstance()->GetLocalPlayers();
 
@@ -229,7 +886,7 @@ bool UJTInputPlayer::TryRestorePlayerSpatialData()
 			}
 		}
 
-		if (CountOfValidPlayers != CurrentSession.PlayersSpatialDataCollection.Num())
+		if (CountOfValidPlayers != InPlayersSpatialData.Num())
 		{
 			return false;
 		}
@@ -244,8 +901,13 @@ bool UJTInputPlayer::TryRestorePlayerSpatialData()
 			{
 				if (APawn* PlayerPawn = PlayerController->GetPawn())
 				{
-					PlayerPawn->SetActorTransform(CurrentSession.PlayersSpatialDataCollection[Index].PawnTransform);
-					PlayerController->SetControlRotation(CurrentSession.PlayersSpatialDataCollection[Index].ControlRotation);
+					PlayerPawn->SetActorTransform(InPlayersSpatialData[Index].PawnTransform);
+					PlayerController->SetControlRotation(InPlayersSpatialData[Index].ControlRotation);
+
+					if (UPawnMovementComponent* MovementComponent = PlayerPawn->GetMovementComponent())
+					{
+						MovementComponent->Velocity = InPlayersSpatialData[Index].Velocity;
+					}
 
 					++Index;
 				}
@@ -287,5 +949,15 @@ void UJTInputPlayer::DrawDebug() const
 
 		GEngine->AddOnScreenDebugMessage(PlayStatusHashKey, 0.f, PlayStatusColor, PlayStatusString);
 	}
+	else if (bIsLoadingSession && JT::AutoReplay::InputPlayer::CVarShowPlayStatus.GetValueOnGameThread())
+	{
+		static const uint64 PlayStatusHashKey = GetTypeHash(FString("JTInputPlayerPlayStatus"));
+		static const FColor LoadStatusColor = FColor::Yellow;
+
+		const FString LoadStatusString
+			= FString::Printf(TEXT("Loading Recording Session: %s"), *FPaths::GetPathLeaf(CachedCurrentRequestParams.RecordingFilePath.FilePath));
+
+		GEngine->AddOnScreenDebugMessage(PlayStatusHashKey, 0.f, LoadStatusColor, LoadStatusString);
+	}
 #endif // UE_ENABLE_DEBUG_DRAWING
 }
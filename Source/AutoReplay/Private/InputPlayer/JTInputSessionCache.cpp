@@ -0,0 +1,190 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "InputPlayer/JTInputSessionCache.h"
+
+#include "InputPlayer/JTInputPlayer.h"
+#include "InputSerializer/JTInputSerializer.h"
+#include "JTAutoReplayProfiling.h"
+
+#include "Algo/AllOf.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/ScopeLock.h"
+
+FJTInputSessionCache& FJTInputSessionCache::Get()
+{
+	static FJTInputSessionCache SessionCache;
+	return SessionCache;
+}
+
+TFuture<TSharedPtr<const FJTInputRecordingSession>> FJTInputSessionCache::LoadSessionAsync(const FFilePath& InFilePath)
+{
+	return Async(EAsyncExecution::ThreadPool, [this, InFilePath]()
+		{
+			return LoadSession(InFilePath);
+		});
+}
+
+TSharedPtr<const FJTInputRecordingSession> FJTInputSessionCache::LoadSession(const FFilePath& InFilePath)
+{
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	FFilePath FinalPath;
+	if (!FJTInputSerializer::TryResolveFilePath(InFilePath, FinalPath))
+	{
+		return nullptr;
+	}
+
+	if (TSharedPtr<const FJTInputRecordingSession> CachedSession = Find(FinalPath.FilePath))
+	{
+		UE_LOG(LogJTInputPlayer, Verbose, TEXT("Loaded session %s from the session cache"), *FinalPath.FilePath);
+		return CachedSession;
+	}
+
+	FFileStamp FirstFileStamp;
+	const bool bStampedFirstFile = TryStampFile(FinalPath.FilePath, FirstFileStamp);
+
+	TArray<FString> SegmentFilePaths;
+	TSharedPtr<FJTInputRecordingSession> ImportedSession = MakeShared<FJTInputRecordingSession>();
+	if (!FJTInputSerializer::ImportSession(InFilePath, *ImportedSession, &SegmentFilePaths))
+	{
+		return nullptr;
+	}
+
+	if (!bStampedFirstFile)
+	{
+		return ImportedSession;
+	}
+
+	// Json sessions are always read from a single file
+	if (SegmentFilePaths.IsEmpty())
+	{
+		SegmentFilePaths.Add(FinalPath.FilePath);
+	}
+
+	FEntry Entry;
+	Entry.FilePath = FinalPath.FilePath;
+	Entry.FileStamps.Reserve(SegmentFilePaths.Num());
+
+	for (const FString& SegmentFilePath : SegmentFilePaths)
+	{
+		if (!TryStampFile(SegmentFilePath, Entry.FileStamps.AddDefaulted_GetRef()))
+		{
+			return ImportedSession;
+		}
+	}
+
+	// The first file was stamped before it was read, so a session that changed while it was being read isn't cached
+	if (!(Entry.FileStamps[0] == FirstFileStamp))
+	{
+		return ImportedSession;
+	}
+
+	Entry.SessionBytes = static_cast<int64>(sizeof(FJTInputRecordingSession) + ImportedSession->GetAllocatedSize());
+	Entry.Session = ImportedSession;
+
+	Add(MoveTemp(Entry));
+
+	return ImportedSession;
+}
+
+void FJTInputSessionCache::Empty()
+{
+	FScopeLock Lock(&EntriesCriticalSection);
+
+	Entries.Empty();
+	CachedBytes = 0;
+}
+
+int64 FJTInputSessionCache::GetCachedBytes() const
+{
+	FScopeLock Lock(&EntriesCriticalSection);
+	return CachedBytes;
+}
+
+int32 FJTInputSessionCache::Num() const
+{
+	FScopeLock Lock(&EntriesCriticalSection);
+	return Entries.Num();
+}
+
+bool FJTInputSessionCache::TryStampFile(const FString& InFilePath, FFileStamp& OutFileStamp)
+{
+	const FFileStatData FileStatData = IFileManager::Get().GetStatData(*InFilePath);
+	if (!FileStatData.bIsValid)
+	{
+		return false;
+	}
+
+	OutFileStamp.FilePath = InFilePath;
+	OutFileStamp.ModificationTime = FileStatData.ModificationTime;
+	OutFileStamp.FileSize = FileStatData.FileSize;
+	return true;
+}
+
+TSharedPtr<const FJTInputRecordingSession> FJTInputSessionCache::Find(const FString& InFilePath)
+{
+	FScopeLock Lock(&EntriesCriticalSection);
+
+	const int32 EntryIndex = Entries.IndexOfByPredicate([&InFilePath](const FEntry& Entry) { return (Entry.FilePath == InFilePath); });
+	if (EntryIndex == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	// A change to any of the files the session was read from invalidates its cached session
+	const bool bIsUpToDate = Algo::AllOf(Entries[EntryIndex].FileStamps, [](const FFileStamp& FileStamp)
+		{
+			FFileStamp CurrentFileStamp;
+			return TryStampFile(FileStamp.FilePath, CurrentFileStamp) && (CurrentFileStamp == FileStamp);
+		});
+
+	if (!bIsUpToDate)
+	{
+		CachedBytes -= Entries[EntryIndex].SessionBytes;
+		Entries.RemoveAt(EntryIndex);
+		return nullptr;
+	}
+
+	// Move to the most recently used end
+	FEntry Entry = MoveTemp(Entries[EntryIndex]);
+	Entries.RemoveAt(EntryIndex);
+
+	return Entries.Emplace_GetRef(MoveTemp(Entry)).Session;
+}
+
+void FJTInputSessionCache::Add(FEntry&& InEntry)
+{
+	const int64 BudgetBytes = static_cast<int64>(UJTAutoReplaySettings::GetSettings()->SessionCacheBudgetMegabytes * 1024.0 * 1024.0);
+	if (InEntry.SessionBytes > BudgetBytes)
+	{
+		return;
+	}
+
+	FScopeLock Lock(&EntriesCriticalSection);
+
+	// Another load of the same file may have finished first
+	const int32 ExistingEntryIndex = Entries.IndexOfByPredicate([&InEntry](const FEntry& Entry) { return (Entry.FilePath == InEntry.FilePath); });
+	if (ExistingEntryIndex != INDEX_NONE)
+	{
+		CachedBytes -= Entries[ExistingEntryIndex].SessionBytes;
+		Entries.RemoveAt(ExistingEntryIndex);
+	}
+
+	TrimToBudget(BudgetBytes - InEntry.SessionBytes);
+
+	CachedBytes += InEntry.SessionBytes;
+	Entries.Emplace(MoveTemp(InEntry));
+}
+
+void FJTInputSessionCache::TrimToBudget(int64 InBudgetBytes)
+{
+	int32 NumEntriesToEvict = 0;
+	while (NumEntriesToEvict < Entries.Num() && CachedBytes > InBudgetBytes)
+	{
+		CachedBytes -= Entries[NumEntriesToEvict].SessionBytes;
+		++NumEntriesToEvict;
+	}
+
+	Entries.RemoveAt(0, NumEntriesToEvict);
+}
@@ -0,0 +1,78 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "InputRecorder/JTInputCaptureQueue.h"
+
+FJTInputCaptureQueue::FJTInputCaptureQueue(int32 InCapacity)
+{
+	const uint64 Capacity = FMath::RoundUpToPowerOfTwo64(static_cast<uint64>(FMath::Max(InCapacity, 2)));
+	Mask = (Capacity - 1);
+
+	Slots = MakeUnique<FSlot[]>(Capacity);
+	for (uint64 Position = 0; Position < Capacity; ++Position)
+	{
+		Slots[Position].Sequence.store(Position, std::memory_order_relaxed);
+	}
+}
+
+bool FJTInputCaptureQueue::Enqueue(const FJTCapturedInputEvent& InEvent)
+{
+	uint64 Position = EnqueuePosition.load(std::memory_order_relaxed);
+	FSlot* Slot = nullptr;
+
+	for (;;)
+	{
+		Slot = &Slots[Position & Mask];
+
+		const uint64 Sequence = Slot->Sequence.load(std::memory_order_acquire);
+		const int64 Difference = (static_cast<int64>(Sequence) - static_cast<int64>(Position));
+
+		if (Difference == 0)
+		{
+			// The slot is free. Claim it, unless another producer got there first (which reloads Position)
+			if (EnqueuePosition.compare_exchange_weak(Position, (Position + 1), std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (Difference < 0)
+		{
+			// The slot still holds an event from the previous lap that hasn't been drained, so the queue is full
+			NumDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else
+		{
+			Position = EnqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	Slot->Event = InEvent;
+	Slot->Sequence.store((Position + 1), std::memory_order_release);
+
+	return true;
+}
+
+bool FJTInputCaptureQueue::EnqueueKey(const FJTInputKeyEventArgs& InKeyEventArgs)
+{
+	FJTCapturedInputEvent CapturedEvent;
+	CapturedEvent.FrameCounter = GFrameCounter;
+	CapturedEvent.KeyName = InKeyEventArgs.Key.GetFName();
+	FJTInputTimeline::PackKeyEvent(0, InKeyEventArgs, CapturedEvent.Event);
+
+	return Enqueue(CapturedEvent);
+}
+
+bool FJTInputCaptureQueue::EnqueueAxis(const FJTInputAxisEventArgs& InAxisEventArgs)
+{
+	FJTCapturedInputEvent CapturedEvent;
+	CapturedEvent.FrameCounter = GFrameCounter;
+	CapturedEvent.KeyName = InAxisEventArgs.Key.GetFName();
+	FJTInputTimeline::PackAxisEvent(0, InAxisEventArgs, CapturedEvent.Event);
+
+	return Enqueue(CapturedEvent);
+}
+
+SIZE_T FJTInputCaptureQueue::GetAllocatedSize() const
+{
+	return (static_cast<SIZE_T>(GetCapacity()) * sizeof(FSlot));
+}
@@ -0,0 +1,225 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "InputRecorder/JTInputFlightRecorder.h"
+
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+	/** The number of players and held keys each snapshot has room for before it has to grow */
+	constexpr int32 SnapshotPlayersCapacity = 4;
+	constexpr int32 SnapshotHeldKeysCapacity = 16;
+}
+
+FJTInputFlightRecorder::FJTInputFlightRecorder(const FJTInputFlightRecorderParams& InParams)
+	: Params(InParams)
+{
+	Params.NumSnapshotsPerWindow = FMath::Max(Params.NumSnapshotsPerWindow, 1);
+	Params.MaxEvents = FMath::Max(Params.MaxEvents, 1);
+
+	// Everything is allocated up front, so that recording into the buffer never allocates
+	KeyTable.Reserve(0, 0, FJTInputTimeline::MinKeyGrowth);
+	Events.SetNum(Params.MaxEvents);
+	HeldKeys.Reserve(SnapshotHeldKeysCapacity);
+
+	// One more snapshot than the window is split into, so that there is always one at least a full window old
+	Snapshots.SetNum(Params.NumSnapshotsPerWindow + 1);
+	for (FSnapshot& Snapshot : Snapshots)
+	{
+		Snapshot.PlayersSpatialDataCollection.Reserve(SnapshotPlayersCapacity);
+		Snapshot.HeldKeys.Reserve(SnapshotHeldKeysCapacity);
+	}
+}
+
+void FJTInputFlightRecorder::RecordEvent(uint64 InFrame, const FKey& InKey, const FJTInputTimelineEvent& InEvent)
+{
+	const FJTInputKeyIndex KeyIndex = KeyTable.InternKey(InKey);
+
+	FEntry& Entry = AddEntry(InFrame);
+	Entry.Event = InEvent;
+	Entry.Event.KeyIndex = KeyIndex;
+
+	if (Entry.Event.EventType == EJTInputEventType::Key)
+	{
+		UpdateHeldKeys(Entry.Event);
+	}
+}
+
+bool FJTInputFlightRecorder::IsSnapshotDue() const
+{
+	if (NumSnapshots == 0)
+	{
+		return true;
+	}
+
+	const FSnapshot& LatestSnapshot = Snapshots[(NextSnapshotIndex + Snapshots.Num() - 1) % Snapshots.Num()];
+	if (Params.WindowFrames > 0)
+	{
+		const uint64 SnapshotIntervalFrames = FMath::Max(Params.WindowFrames / Params.NumSnapshotsPerWindow, 1);
+		return ((GFrameCounter - LatestSnapshot.Frame) >= SnapshotIntervalFrames);
+	}
+
+	const double SnapshotIntervalSeconds = (Params.WindowSeconds / Params.NumSnapshotsPerWindow);
+	return ((FPlatformTime::Seconds() - LatestSnapshot.Seconds) >= SnapshotIntervalSeconds);
+}
+
+void FJTInputFlightRecorder::TakeSnapshot(const FJTPlayersSpatialDataCollection& InPlayersSpatialDataCollection)
+{
+	FSnapshot& Snapshot = Snapshots[NextSnapshotIndex];
+	NextSnapshotIndex = ((NextSnapshotIndex + 1) % Snapshots.Num());
+	NumSnapshots = FMath::Min(NumSnapshots + 1, Snapshots.Num());
+
+	Snapshot.Frame = GFrameCounter;
+	Snapshot.Seconds = FPlatformTime::Seconds();
+	Snapshot.DateTime = FDateTime::Now();
+
+	// Reset and append rather than assign, so that the snapshot's storage is reused
+	Snapshot.PlayersSpatialDataCollection.Reset();
+	Snapshot.PlayersSpatialDataCollection.Append(InPlayersSpatialDataCollection);
+	Snapshot.HeldKeys.Reset();
+	Snapshot.HeldKeys.Append(HeldKeys);
+}
+
+bool FJTInputFlightRecorder::BuildSession(FJTInputRecordingSession& OutSession) const
+{
+	const FSnapshot* StartSnapshot = nullptr;
+	for (int32 Offset = 0; Offset < NumSnapshots; ++Offset)
+	{
+		const FSnapshot& Snapshot = Snapshots[(NextSnapshotIndex - NumSnapshots + Offset + Snapshots.Num()) % Snapshots.Num()];
+		if (IsSnapshotValid(Snapshot))
+		{
+			StartSnapshot = &Snapshot;
+			break;
+		}
+	}
+
+	if (!StartSnapshot)
+	{
+		return false;
+	}
+
+	OutSession.ClearSessionData();
+	OutSession.PlayersSpatialDataCollection = StartSnapshot->PlayersSpatialDataCollection;
+	OutSession.StartTime = StartSnapshot->DateTime.ToString();
+	OutSession.StopTime = FDateTime::Now().ToString();
+
+	// Snapshots are taken on tick, after the frame's input has been handled, so the session starts on the frame after
+	OutSession.StartFrameCounter = (StartSnapshot->Frame + 1);
+	OutSession.StopFrameCounter = GFrameCounter;
+
+	OutSession.InputTimeline.Reserve(NumEvents, (NumEvents + StartSnapshot->HeldKeys.Num()), KeyTable.NumKeys());
+
+	// Keys that were already held down at the snapshot are pressed on the first frame
+	for (const FHeldKey& HeldKey : StartSnapshot->HeldKeys)
+	{
+		FJTInputKeyEventArgs KeyEventArgs;
+		KeyEventArgs.Key = KeyTable.GetKey(HeldKey.KeyIndex);
+		KeyEventArgs.InputDevice = FInputDeviceId::CreateFromInternalId(HeldKey.InputDeviceId);
+		KeyEventArgs.ControllerId = HeldKey.ControllerId;
+		KeyEventArgs.AmountDepressed = 1.f;
+		KeyEventArgs.Event = EInputEvent::IE_Pressed;
+
+		OutSession.InputTimeline.AddKeyEvent(0, KeyEventArgs);
+	}
+
+	// Every later snapshot in the window doubles as a spatial checkpoint
+	for (int32 Offset = 0; Offset < NumSnapshots; ++Offset)
+	{
+		const FSnapshot& Snapshot = Snapshots[(NextSnapshotIndex - NumSnapshots + Offset + Snapshots.Num()) % Snapshots.Num()];
+		if (Snapshot.Frame >= OutSession.StartFrameCounter)
+		{
+			OutSession.SpatialCheckpoints.AddCheckpoint(static_cast<FJTFrameDelta>(Snapshot.Frame - OutSession.StartFrameCounter), Snapshot.PlayersSpatialDataCollection);
+		}
+	}
+
+	for (int32 Offset = 0; Offset < NumEvents; ++Offset)
+	{
+		const FEntry& Entry = Events[(NextEventIndex - NumEvents + Offset + Events.Num()) % Events.Num()];
+		if (Entry.Frame < OutSession.StartFrameCounter)
+		{
+			continue;
+		}
+
+		const FJTInputKeyIndex KeyIndex = OutSession.InputTimeline.InternKey(KeyTable.GetKey(Entry.Event.KeyIndex));
+
+		FJTInputTimelineEvent& TimelineEvent = OutSession.InputTimeline.AddEvent(static_cast<FJTFrameDelta>(Entry.Frame - OutSession.StartFrameCounter));
+		TimelineEvent = Entry.Event;
+		TimelineEvent.KeyIndex = KeyIndex;
+	}
+
+	return true;
+}
+
+SIZE_T FJTInputFlightRecorder::GetAllocatedSize() const
+{
+	SIZE_T AllocatedSize = KeyTable.GetAllocatedSize();
+	AllocatedSize += Events.GetAllocatedSize();
+	AllocatedSize += HeldKeys.GetAllocatedSize();
+	AllocatedSize += Snapshots.GetAllocatedSize();
+
+	for (const FSnapshot& Snapshot : Snapshots)
+	{
+		AllocatedSize += Snapshot.PlayersSpatialDataCollection.GetAllocatedSize();
+		AllocatedSize += Snapshot.HeldKeys.GetAllocatedSize();
+	}
+
+	return AllocatedSize;
+}
+
+FJTInputFlightRecorder::FEntry& FJTInputFlightRecorder::AddEntry(uint64 InFrame)
+{
+	FEntry& Entry = Events[NextEventIndex];
+	if (NumEvents == Events.Num())
+	{
+		LastOverwrittenFrame = Entry.Frame;
+		bHasOverwrittenEvents = true;
+	}
+	else
+	{
+		++NumEvents;
+	}
+
+	NextEventIndex = ((NextEventIndex + 1) % Events.Num());
+
+	Entry.Frame = InFrame;
+	return Entry;
+}
+
+void FJTInputFlightRecorder::UpdateHeldKeys(const FJTInputTimelineEvent& InKeyEvent)
+{
+	const EInputEvent KeyEvent = InKeyEvent.GetKeyEvent();
+	if (KeyEvent != EInputEvent::IE_Pressed && KeyEvent != EInputEvent::IE_Released)
+	{
+		return;
+	}
+
+	const int32 HeldKeyIndex = HeldKeys.IndexOfByPredicate([&InKeyEvent](const FHeldKey& InHeldKey)
+		{
+			return (InHeldKey.KeyIndex == InKeyEvent.KeyIndex) && (InHeldKey.ControllerId == InKeyEvent.ControllerId);
+		});
+
+	if (KeyEvent == EInputEvent::IE_Pressed && HeldKeyIndex == INDEX_NONE)
+	{
+		HeldKeys.Add(FHeldKey{ InKeyEvent.KeyIndex, InKeyEvent.ControllerId, InKeyEvent.Payload.Key.InputDeviceId });
+	}
+	else if (KeyEvent == EInputEvent::IE_Released && HeldKeyIndex != INDEX_NONE)
+	{
+		HeldKeys.RemoveAtSwap(HeldKeyIndex, 1, false);
+	}
+}
+
+bool FJTInputFlightRecorder::IsSnapshotValid(const FSnapshot& InSnapshot) const
+{
+	// Every event after the snapshot must still be in the buffer
+	if (bHasOverwrittenEvents && InSnapshot.Frame < LastOverwrittenFrame)
+	{
+		return false;
+	}
+
+	if (Params.WindowFrames > 0)
+	{
+		return ((GFrameCounter - InSnapshot.Frame) <= static_cast<uint64>(Params.WindowFrames));
+	}
+
+	return ((FPlatformTime::Seconds() - InSnapshot.Seconds) <= Params.WindowSeconds);
+}
@@ -3,6 +3,7 @@
 #include "InputRecorder/JTInputRecorder.h"
 
 #include "JTAutoReplayConsoleMenu.h"
+#include "JTAutoReplayProfiling.h"
 #include "InputSerializer/JTInputSerializer.h"
 
 #include "Engine/GameViewportClient.h"
@@ -10,14 +11,37 @@
 #include "Engine/Engine.h"
 #include "Engine/World.h"
 #include "GameFramework/PlayerController.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Parse.h"
 #include "TimerManager.h"
 #include "UnrealClient.h"
 
 DEFINE_LOG_CATEGORY(LogJTInputRecorder);
 
+namespace
+{
+	FFilePath MakeFlightRecorderFilePath(const TCHAR* InReason)
+	{
+		FFilePath FlightRecorderFilePath;
+		FlightRecorderFilePath.FilePath = FString::Printf(TEXT("FlightRecorder/%s_%s.%s"), InReason, *FDateTime::Now().ToString(),
+			*FJTInputSerializer::GetFileExtensionForFormat(EJTInputRecordingFileFormat::Binary));
+
+		return FlightRecorderFilePath;
+	}
+}
+
 void UJTInputRecorder::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
+
+	CaptureQueue = MakeUnique<FJTInputCaptureQueue>(UJTAutoReplaySettings::GetSettings()->CaptureQueueCapacity);
+
+	// Started on the first tick, once there is a viewport to record from
+	bHasPendingFlightRecorderStart = (UJTAutoReplaySettings::GetSettings()->bStartFlightRecorderOnStartup
+		|| FParse::Param(FCommandLine::Get(), TEXT("JTFlightRecorder")));
 }
 
 void UJTInputRecorder::Deinitialize()
@@ -28,16 +52,59 @@ void UJTInputRecorder::Deinitialize()
 	{
 		StopRecording();
 	}
+
+	if (IsFlightRecording())
+	{
+		StopFlightRecorder();
+	}
+
+	WaitForPendingExports();
 }
 
 void UJTInputRecorder::Tick(float DeltaTime)
 {
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	if (bHasPendingFlightRecorderStart)
+	{
+		bHasPendingFlightRecorderStart = false;
+
+		FJTInputFlightRecorderParams FlightRecorderParams;
+		FParse::Value(FCommandLine::Get(), TEXT("JTFlightRecorderSeconds="), FlightRecorderParams.WindowSeconds);
+		StartFlightRecorder(FlightRecorderParams);
+	}
+
+	// Drained first, so that snapshots and flushed chunks include all of this frame's input
+	DrainCaptureQueue();
+
+	if (FlightRecorder)
+	{
+		TickFlightRecorder();
+	}
+
+	if (bIsCurrentlyRecording)
+	{
+		CurrentRecordingSession.RecordDeltaTime(static_cast<float>(FApp::GetDeltaTime()));
+		TickSpatialCheckpoints();
+	}
+
+	if (bIsCurrentlyRecording && CurrentStreamWriter)
+	{
+		FlushFramesToStream(false);
+	}
+
+	if (bIsCurrentlyRecording)
+	{
+		TickProfiling();
+	}
+
+	TickPendingExports();
 	DrawDebug();
 }
 
 TStatId UJTInputRecorder::GetStatId() const
 {
-	RETURN_QUICK_DECLARE_CYCLE_STAT(UJTInputRecorder, STATGROUP_Tickables);
+	return GET_STATID(STAT_JTInputRecorder_Tick);
 }
 
 void UJTInputRecorder::RequestRecording(const FJTInputRecorderRequestParams RequestParams)
@@ -64,35 +131,46 @@ void UJTInputRecorder::RequestRecording(const FJTInputRecorderRequestParams Requ
 
 void UJTInputRecorder::StartRecording()
 {
+	JT_AUTOREPLAY_LLM_SCOPE();
+
 	ResetStartTimerHandle();
 
+	// Anything captured before the session starts only belongs to the flight recorder
+	DrainCaptureQueue();
+
 	FJTPlayersSpatialDataCollection CurrentPlayersSpatialDataCollection;
+	GatherPlayersSpatialData(CurrentPlayersSpatialDataCollection);
+
+	CurrentRecordingSession.StartSession(CurrentPlayersSpatialDataCollection);
+	if (CachedCurrentRequestParams.bCaptureRandomSeeds)
 	{
-		const TArray<ULocalPlayer*>& LocalPlayers = GetGameInstance()->GetLocalPlayers();
-		for (const ULocalPlayer* LocalPlayer : LocalPlayers)
-		{
-			// Only count local players with an actual PC
-			if (const APlayerController* PlayerController = LocalPlayer->PlayerController)
-			{
-				FJTPlayerSpatialData CurrentPlayerSpatialData;
-				if (const APawn* PlayerPawn = PlayerController->GetPawn())
-				{
-					CurrentPlayerSpatialData.ControlRotation = PlayerController->GetControlRotation();
-					CurrentPlayerSpatialData.PawnTransform = PlayerPawn->GetActorTransform();
-
-					CurrentPlayersSpatialDataCollection.Emplace(CurrentPlayerSpatialData);
-				}
-			}
-		}
+		CurrentRecordingSession.CaptureRandomSeeds();
 	}
 
-	CurrentRecordingSession.StartSession(CurrentPlayersSpatialDataCollection);
+	CurrentRecordingSession.InputTimeline.Reserve(
+		CachedCurrentRequestParams.TimelineFrameCapacityHint, CachedCurrentRequestParams.TimelineEventCapacityHint, FJTInputTimeline::MinKeyGrowth);
+	ReserveSpatialCheckpoints(CachedCurrentRequestParams.TimelineFrameCapacityHint);
+	CurrentRecordingSession.DeltaTimes.Reserve(CachedCurrentRequestParams.TimelineFrameCapacityHint);
+	NextSpatialCheckpointFrameDelta = 0;
+
+	if (CachedCurrentRequestParams.bStreamToDisk || CachedCurrentRequestParams.bJournal)
+	{
+		StartStreaming();
+	}
+
+	// Everything past this point should be recorded without allocating, unless the capacity hints are exceeded
+	NumRecordedEvents = 0;
+	LastTickNumRecordedEvents = 0;
+	SessionStartNumTimelineAllocations = FJTInputTimeline::GetNumAllocations();
+	CaptureFloorFrame = FMath::Max(CaptureFloorFrame, CurrentRecordingSession.StartFrameCounter);
+
 	UpdateEventArgsDelegates(true);
 
 	bIsCurrentlyRecording = true;
 	bIsCurrentlyEscaped = false;
 
 	UE_LOG(LogJTInputRecorder, Log, TEXT("Input Recording Started"));
+	TRACE_BOOKMARK(TEXT("AutoReplay Recording Started"));
 
 	OnStartedRecording.Broadcast();
 }
@@ -100,38 +178,357 @@ void UJTInputRecorder::StartRecording()
 void UJTInputRecorder::StopRecording()
 {
 	ResetStartTimerHandle();
+	DrainCaptureQueue();
 
-	UpdateEventArgsDelegates(false);
+	// The flight recorder keeps listening for input
+	UpdateEventArgsDelegates(IsFlightRecording());
 	CurrentRecordingSession.StopSession();
 
-	if (CachedCurrentRequestParams.RecordingFilePath.FilePath.IsEmpty())
-	{
-		FJTInputSerializer::ExportSessionToJsonWithDefaultPath(CurrentRecordingSession);
-	}
-	else
-	{
-		FJTInputSerializer::ExportSessionToJson(CachedCurrentRequestParams.RecordingFilePath, CurrentRecordingSession);
-	}
+	SessionStopNumTimelineAllocations = FJTInputTimeline::GetNumAllocations();
+	UE_LOG(LogJTInputRecorder, Log, TEXT("Recorded %llu input events with %llu timeline allocations"),
+		NumRecordedEvents, (SessionStopNumTimelineAllocations - SessionStartNumTimelineAllocations));
+
+	ExportCurrentSession();
 
 	CachedCurrentRequestParams = FJTInputRecorderRequestParams();
 	bIsCurrentlyRecording = false;
 	bIsCurrentlyEscaped = false;
 
+	SET_MEMORY_STAT(STAT_JTInputRecorder_SessionMemory, 0);
+	TRACE_COUNTER_SET(JTAutoReplay_RecordingSessionMemory, 0);
+
 	UE_LOG(LogJTInputRecorder, Log, TEXT("Input Recording Stopped"));
+	TRACE_BOOKMARK(TEXT("AutoReplay Recording Stopped"));
 
 	OnStoppedRecording.Broadcast();
 }
 
-void UJTInputRecorder::RecordKeyInput(const FInputKeyEventArgs& EventArgs)
+void UJTInputRecorder::StartFlightRecorder(const FJTInputFlightRecorderParams FlightRecorderParams)
+{
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	if (IsFlightRecording())
+	{
+		StopFlightRecorder();
+	}
+
+	FlightRecorder = MakeUnique<FJTInputFlightRecorder>(FlightRecorderParams);
+
+	if (FlightRecorderParams.bDumpOnCrash)
+	{
+		SystemErrorDelegateHandle = FCoreDelegates::OnHandleSystemError.AddUObject(this, &UJTInputRecorder::OnSystemError);
+	}
+
+	if (FlightRecorderParams.bDumpOnEnsure)
+	{
+		SystemEnsureDelegateHandle = FCoreDelegates::OnHandleSystemEnsure.AddUObject(this, &UJTInputRecorder::OnSystemEnsure);
+	}
+
+	UpdateEventArgsDelegates(true);
+
+	const FJTInputFlightRecorderParams& Params = FlightRecorder->GetParams();
+	UE_LOG(LogJTInputRecorder, Log, TEXT("Flight Recorder Started. Keeping the last %s of input (up to %d events, %.2f KB)"),
+		*((Params.WindowFrames > 0) ? FString::Printf(TEXT("%d frames"), Params.WindowFrames) : FString::Printf(TEXT("%.0f seconds"), Params.WindowSeconds)),
+		Params.MaxEvents, (FlightRecorder->GetAllocatedSize() / 1024.0));
+}
+
+void UJTInputRecorder::StopFlightRecorder()
+{
+	FCoreDelegates::OnHandleSystemError.Remove(SystemErrorDelegateHandle);
+	FCoreDelegates::OnHandleSystemEnsure.Remove(SystemEnsureDelegateHandle);
+	SystemErrorDelegateHandle.Reset();
+	SystemEnsureDelegateHandle.Reset();
+
+	FlightRecorder.Reset();
+
+	// An ongoing recording session keeps listening for input
+	UpdateEventArgsDelegates(bIsCurrentlyRecording);
+
+	UE_LOG(LogJTInputRecorder, Log, TEXT("Flight Recorder Stopped"));
+}
+
+bool UJTInputRecorder::DumpFlightRecorder(const FFilePath FilePath)
+{
+	return DumpFlightRecorder_Internal((FilePath.FilePath.IsEmpty() ? MakeFlightRecorderFilePath(TEXT("Dump")) : FilePath), false);
+}
+
+void UJTInputRecorder::GatherPlayersSpatialData(FJTPlayersSpatialDataCollection& OutPlayersSpatialDataCollection) const
+{
+	OutPlayersSpatialDataCollection.Reset();
+
+	const TArray<ULocalPlayer*>& LocalPlayers = GetGameInstance()->GetLocalPlayers();
+	for (const ULocalPlayer* LocalPlayer : LocalPlayers)
+	{
+		// Only count local players with an actual PC
+		if (const APlayerController* PlayerController = LocalPlayer->PlayerController)
+		{
+			FJTPlayerSpatialData CurrentPlayerSpatialData;
+			if (const APawn* PlayerPawn = PlayerController->GetPawn())
+			{
+				CurrentPlayerSpatialData.ControlRotation = PlayerController->GetControlRotation();
+				CurrentPlayerSpatialData.PawnTransform = PlayerPawn->GetActorTransform();
+				CurrentPlayerSpatialData.Velocity = PlayerPawn->GetVelocity();
+
+				OutPlayersSpatialDataCollection.Emplace(CurrentPlayerSpatialData);
+			}
+		}
+	}
+}
+
+void UJTInputRecorder::TickFlightRecorder()
 {
-	const bool ShouldRecordKey = DetermineIfKeyShouldBeRecorded(EventArgs.Key, EventArgs.Event);
-	if (!ShouldRecordKey)
+	if (!FlightRecorder->IsSnapshotDue())
 	{
 		return;
 	}
 
-	FJTInputKeyEventArgs KeyEventArgs(EventArgs);
-	CurrentRecordingSession.RecordKey(KeyEventArgs);
+	// Gathered into a member so that snapshots don't allocate
+	GatherPlayersSpatialData(FlightRecorderSnapshotSpatialData);
+	FlightRecorder->TakeSnapshot(FlightRecorderSnapshotSpatialData);
+
+	// The snapshot's held keys only account for input drained so far, so anything captured later this frame goes on the next
+	CaptureFloorFrame = FMath::Max(CaptureFloorFrame, (GFrameCounter + 1));
+}
+
+void UJTInputRecorder::TickSpatialCheckpoints()
+{
+	const int32 SpatialCheckpointIntervalFrames = CachedCurrentRequestParams.SpatialCheckpointIntervalFrames;
+	const FJTFrameDelta CurrentFrameDelta = CurrentRecordingSession.GetCurrentFrameDelta();
+	if (SpatialCheckpointIntervalFrames <= 0 || CurrentFrameDelta < NextSpatialCheckpointFrameDelta)
+	{
+		return;
+	}
+
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputRecorder_RecordSpatialCheckpoint);
+
+	// Gathered into a member so that checkpoints don't allocate
+	GatherPlayersSpatialData(SpatialCheckpointData);
+	CurrentRecordingSession.RecordSpatialCheckpoint(SpatialCheckpointData);
+
+	NextSpatialCheckpointFrameDelta = (CurrentFrameDelta + SpatialCheckpointIntervalFrames);
+}
+
+void UJTInputRecorder::ReserveSpatialCheckpoints(int32 InNumFrames)
+{
+	const int32 SpatialCheckpointIntervalFrames = CachedCurrentRequestParams.SpatialCheckpointIntervalFrames;
+	if (SpatialCheckpointIntervalFrames <= 0)
+	{
+		return;
+	}
+
+	const int32 NumCheckpoints = ((InNumFrames / SpatialCheckpointIntervalFrames) + 1);
+	const int32 NumPlayers = FMath::Max(CurrentRecordingSession.PlayersSpatialDataCollection.Num(), 1);
+	CurrentRecordingSession.SpatialCheckpoints.Reserve(NumCheckpoints, (NumCheckpoints * NumPlayers));
+}
+
+bool UJTInputRecorder::DumpFlightRecorder_Internal(const FFilePath& InFilePath, bool bShouldWaitForExport)
+{
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputRecorder_DumpFlightRecorder);
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	if (!FlightRecorder)
+	{
+		UE_LOG(LogJTInputRecorder, Warning, TEXT("Cannot dump flight recorder. It isn't running"));
+		return false;
+	}
+
+	// Draining is only safe from the game thread (a crash can be handled on any thread)
+	if (IsInGameThread())
+	{
+		DrainCaptureQueue();
+	}
+
+	FJTInputRecordingSession FlightRecorderSession;
+	if (!FlightRecorder->BuildSession(FlightRecorderSession))
+	{
+		UE_LOG(LogJTInputRecorder, Error, TEXT("Cannot dump flight recorder. No snapshot to start from (more than %d events may have been recorded since the last one)"),
+			FlightRecorder->GetParams().MaxEvents);
+		return false;
+	}
+
+	UE_LOG(LogJTInputRecorder, Log, TEXT("Dumping flight recorder (%d frames, %d events) to %s"),
+		FlightRecorderSession.InputTimeline.Num(), FlightRecorderSession.InputTimeline.NumEvents(), *InFilePath.FilePath);
+
+	if (bShouldWaitForExport)
+	{
+		return FJTInputSerializer::ExportSession(InFilePath, FlightRecorderSession);
+	}
+
+	FJTPendingExport& PendingExport = PendingExports.AddDefaulted_GetRef();
+	PendingExport.ExportFuture = FJTInputSerializer::ExportSessionAsync(InFilePath, MoveTemp(FlightRecorderSession));
+
+	return true;
+}
+
+void UJTInputRecorder::OnSystemError()
+{
+	// The process is going down, so the window is written out right away. This is best effort, since the crash
+	// may have left the game in any state
+	DumpFlightRecorder_Internal(MakeFlightRecorderFilePath(TEXT("Crash")), true);
+}
+
+void UJTInputRecorder::OnSystemEnsure()
+{
+	// Ensures can fire on any thread, but the flight recorder is only safe to read on the game thread
+	if (IsInGameThread())
+	{
+		DumpFlightRecorder_Internal(MakeFlightRecorderFilePath(TEXT("Ensure")), false);
+	}
+}
+
+void UJTInputRecorder::StartStreaming()
+{
+	FJTInputSessionStreamParams StreamParams;
+	StreamParams.MaxSegmentDurationSeconds = (CachedCurrentRequestParams.MaxSegmentDurationMinutes * 60.0);
+	StreamParams.MaxSegmentSizeBytes = static_cast<int64>(CachedCurrentRequestParams.MaxSegmentSizeMegabytes * 1024.0 * 1024.0);
+
+	// Flushed chunks are handed to the writer in pooled timelines that come back once written, and are
+	// swapped with the recording session's own storage whenever a whole timeline is flushed
+	const int32 ChunkFrameCapacity = FMath::Max(CachedCurrentRequestParams.TimelineFrameCapacityHint, CachedCurrentRequestParams.StreamChunkFrameCount + 1);
+	CurrentTimelinePool = MakeShared<FJTInputTimelinePool>(ChunkFrameCapacity, CachedCurrentRequestParams.TimelineEventCapacityHint);
+	CurrentTimelinePool->Prewarm(2);
+	StreamParams.TimelinePool = CurrentTimelinePool;
+	StreamParams.bJournal = CachedCurrentRequestParams.bJournal;
+
+	CurrentStreamWriter = FJTInputSerializer::CreateSessionStreamWriter(CachedCurrentRequestParams.RecordingFilePath, StreamParams);
+	if (!CurrentStreamWriter)
+	{
+		UE_LOG(LogJTInputRecorder, Error, TEXT("Unable to stream recording to disk. Session will be held in memory until recording stops"));
+		return;
+	}
+
+	CurrentStreamWriter->BeginSession(CurrentRecordingSession);
+	LastStreamFlushSeconds = FPlatformTime::Seconds();
+
+	UE_LOG(LogJTInputRecorder, Log, TEXT("%s recording to %s"),
+		(StreamParams.bJournal ? TEXT("Journaling") : TEXT("Streaming")), *CurrentStreamWriter->GetFilePath().FilePath);
+}
+
+void UJTInputRecorder::FlushFramesToStream(bool bIncludeCurrentFrame)
+{
+	if (!bIncludeCurrentFrame && CurrentRecordingSession.InputTimeline.Num() < FMath::Max(CachedCurrentRequestParams.StreamChunkFrameCount, 1))
+	{
+		// Journals are also committed on an interval, so that quiet stretches of input aren't held in memory for long
+		const bool bIsJournalCommitDue = (CachedCurrentRequestParams.bJournal
+			&& ((FPlatformTime::Seconds() - LastStreamFlushSeconds) >= CachedCurrentRequestParams.JournalCommitIntervalSeconds));
+		if (!bIsJournalCommitDue)
+		{
+			return;
+		}
+	}
+
+	LastStreamFlushSeconds = FPlatformTime::Seconds();
+
+	FJTInputTimeline Frames = CurrentTimelinePool->Acquire();
+	CurrentRecordingSession.ExtractTimelineFrames(bIncludeCurrentFrame, Frames);
+
+	// Flushed frames can't receive any more events
+	CaptureFloorFrame = FMath::Max(CaptureFloorFrame, (bIncludeCurrentFrame ? (GFrameCounter + 1) : GFrameCounter));
+
+	CurrentStreamWriter->AppendFrames(MoveTemp(Frames));
+
+	if (!CurrentRecordingSession.SpatialCheckpoints.IsEmpty())
+	{
+		// There are only a handful of checkpoints per chunk, so their storage is handed over rather than pooled
+		FJTSpatialCheckpointTrack Checkpoints;
+		Swap(Checkpoints, CurrentRecordingSession.SpatialCheckpoints);
+		ReserveSpatialCheckpoints(CachedCurrentRequestParams.StreamChunkFrameCount);
+
+		CurrentStreamWriter->AppendSpatialCheckpoints(MoveTemp(Checkpoints));
+	}
+
+	if (!CurrentRecordingSession.DeltaTimes.IsEmpty())
+	{
+		FJTDeltaTimeTrack DeltaTimes;
+		Swap(DeltaTimes, CurrentRecordingSession.DeltaTimes);
+		CurrentRecordingSession.DeltaTimes.Reserve(CachedCurrentRequestParams.StreamChunkFrameCount);
+
+		CurrentStreamWriter->AppendDeltaTimes(MoveTemp(DeltaTimes));
+	}
+}
+
+void UJTInputRecorder::ExportCurrentSession()
+{
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputRecorder_ExportCurrentSession);
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	FJTPendingExport& PendingExport = PendingExports.AddDefaulted_GetRef();
+
+	if (CurrentStreamWriter)
+	{
+		FlushFramesToStream(true);
+		PendingExport.ExportFuture = CurrentStreamWriter->EndSession(CurrentRecordingSession);
+		PendingExport.StreamWriter = MoveTemp(CurrentStreamWriter);
+	}
+	else
+	{
+		// The session is handed over to the export task, leaving the recorder free to start a new one right away
+		PendingExport.ExportFuture
+			= FJTInputSerializer::ExportSessionAsync(CachedCurrentRequestParams.RecordingFilePath, MoveTemp(CurrentRecordingSession));
+	}
+
+	CurrentRecordingSession.ClearSessionData();
+	CurrentTimelinePool.Reset();
+}
+
+void UJTInputRecorder::TickPendingExports()
+{
+	for (int32 Index = 0; Index < PendingExports.Num(); ++Index)
+	{
+		if (!PendingExports[Index].ExportFuture.IsReady())
+		{
+			continue;
+		}
+
+		const FJTInputSessionExportResult& ExportResult = PendingExports[Index].ExportFuture.Get();
+		if (ExportResult.bSuccess)
+		{
+			UE_LOG(LogJTInputRecorder, Log, TEXT("Input Recording Exported to %s"), *ExportResult.FilePath);
+		}
+		else
+		{
+			UE_LOG(LogJTInputRecorder, Error, TEXT("Input Recording could not be exported to %s"), *ExportResult.FilePath);
+		}
+
+		OnRecordingExported.Broadcast(ExportResult.bSuccess, ExportResult.FilePath);
+
+		PendingExports.RemoveAt(Index--);
+	}
+}
+
+void UJTInputRecorder::WaitForPendingExports()
+{
+	for (FJTPendingExport& PendingExport : PendingExports)
+	{
+		PendingExport.ExportFuture.Wait();
+	}
+
+	TickPendingExports();
+}
+
+bool UJTInputRecorder::CaptureKeyInput(const FJTInputKeyEventArgs& InKeyEventArgs)
+{
+	if (!bIsCapturingInput.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	return CaptureQueue->EnqueueKey(InKeyEventArgs);
+}
+
+bool UJTInputRecorder::CaptureAxisInput(const FJTInputAxisEventArgs& InAxisEventArgs)
+{
+	if (!bIsCapturingInput.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	return CaptureQueue->EnqueueAxis(InAxisEventArgs);
+}
+
+void UJTInputRecorder::RecordKeyInput(const FInputKeyEventArgs& EventArgs)
+{
+	CaptureKeyInput(FJTInputKeyEventArgs(EventArgs));
 }
 
 void UJTInputRecorder::RecordAxisInput(
@@ -143,18 +540,111 @@ void UJTInputRecorder::RecordAxisInput(
 	int32      NumSamples,
 	bool       bGamepad)
 {
-	const bool ShouldRecordKey = DetermineIfKeyShouldBeRecorded(Key, EInputEvent::IE_Axis);
-	if (!ShouldRecordKey)
+	CaptureAxisInput(FJTInputAxisEventArgs(Key, Delta, DeltaTime, ControllerID, NumSamples, bGamepad));
+}
+
+void UJTInputRecorder::DrainCaptureQueue()
+{
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputRecorder_DrainCaptureQueue);
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	CaptureQueue->Drain([this](const FJTCapturedInputEvent& InCapturedEvent)
+		{
+			const FKey Key(InCapturedEvent.KeyName);
+			const EInputEvent InputEvent = ((InCapturedEvent.Event.EventType == EJTInputEventType::Key) ? InCapturedEvent.Event.GetKeyEvent() : EInputEvent::IE_Axis);
+
+			const bool ShouldRecordKey = DetermineIfKeyShouldBeRecorded(Key, InputEvent);
+			if (!ShouldRecordKey)
+			{
+				return;
+			}
+
+			// Events captured off the game thread can be stamped with a frame that has already been drained (or flushed),
+			// so they are moved up to the earliest frame that can still receive events
+			const uint64 Frame = FMath::Max(InCapturedEvent.FrameCounter, CaptureFloorFrame);
+			CaptureFloorFrame = Frame;
+
+			INC_DWORD_STAT(STAT_JTInputRecorder_FrameEvents);
+
+			if (bIsCurrentlyRecording)
+			{
+				CurrentRecordingSession.RecordEvent(Frame, Key, InCapturedEvent.Event);
+				++NumRecordedEvents;
+			}
+
+			if (FlightRecorder)
+			{
+				FlightRecorder->RecordEvent(Frame, Key, InCapturedEvent.Event);
+			}
+		});
+
+	const uint64 NumDroppedEvents = CaptureQueue->GetNumDroppedEvents();
+	if (NumDroppedEvents != LastNumDroppedCaptureEvents)
 	{
-		return;
+		UE_LOG(LogJTInputRecorder, Warning, TEXT("Dropped %llu input events because the capture queue (%d events) was full. Raise CaptureQueueCapacity in the AutoReplay settings"),
+			(NumDroppedEvents - LastNumDroppedCaptureEvents), CaptureQueue->GetCapacity());
+		LastNumDroppedCaptureEvents = NumDroppedEvents;
+	}
+}
+
+uint64 UJTInputRecorder::GetNumTimelineAllocations() const
+{
+	const uint64 NumTimelineAllocations = (bIsCurrentlyRecording ? FJTInputTimeline::GetNumAllocations() : SessionStopNumTimelineAllocations);
+	return (NumTimelineAllocations - SessionStartNumTimelineAllocations);
+}
+
+SIZE_T UJTInputRecorder::GetAllocatedSize() const
+{
+	FJTAutoReplayMemoryReport MemoryReport;
+	GetMemoryReport(MemoryReport);
+	return MemoryReport.GetTotal();
+}
+
+void UJTInputRecorder::GetMemoryReport(FJTAutoReplayMemoryReport& OutReport) const
+{
+	CurrentRecordingSession.AppendMemoryReport(TEXT("Session "), OutReport);
+
+	// Timelines handed back to the pool by the stream writer, waiting to be reused
+	if (CurrentTimelinePool)
+	{
+		OutReport.Add(TEXT("Timeline Pool"), CurrentTimelinePool->GetAllocatedSize());
 	}
 
-	FJTInputAxisEventArgs AxisEventArgs(Key, Delta, DeltaTime, ControllerID, NumSamples, bGamepad);
-	CurrentRecordingSession.RecordAxis(AxisEventArgs);
+	if (CaptureQueue)
+	{
+		OutReport.Add(FString::Printf(TEXT("Capture Queue (%d events)"), CaptureQueue->GetCapacity()), CaptureQueue->GetAllocatedSize());
+	}
+
+	if (FlightRecorder)
+	{
+		OutReport.Add(FString::Printf(TEXT("Flight Recorder (%d events)"), FlightRecorder->NumBufferedEvents()), FlightRecorder->GetAllocatedSize());
+	}
+
+	// Sessions being exported are owned by their background tasks, so only the bookkeeping is counted here
+	OutReport.Add(FString::Printf(TEXT("Pending Exports (%d)"), PendingExports.Num()), PendingExports.GetAllocatedSize());
+}
+
+void UJTInputRecorder::TickProfiling()
+{
+	const SIZE_T SessionMemory = CurrentRecordingSession.GetAllocatedSize();
+	SET_MEMORY_STAT(STAT_JTInputRecorder_SessionMemory, SessionMemory);
+	SET_DWORD_STAT(STAT_JTInputRecorder_SessionEvents, NumRecordedEvents);
+	TRACE_COUNTER_SET(JTAutoReplay_RecordingSessionMemory, SessionMemory);
+	TRACE_COUNTER_SET(JTAutoReplay_FrameEventsRecorded, (NumRecordedEvents - LastTickNumRecordedEvents));
+	LastTickNumRecordedEvents = NumRecordedEvents;
+
+	const FJTFrameDelta CurrentFrameDelta = CurrentRecordingSession.GetCurrentFrameDelta();
+	if (JT::AutoReplay::Profiling::ShouldBookmarkFrame(CurrentFrameDelta))
+	{
+		TRACE_BOOKMARK(TEXT("AutoReplay Recording Frame %u"), CurrentFrameDelta);
+	}
 }
 
 void UJTInputRecorder::UpdateEventArgsDelegates(bool bShouldBind)
 {
+	// Input captured through CaptureKeyInput/CaptureAxisInput doesn't need a viewport
+	bIsCapturingInput.store(bShouldBind, std::memory_order_relaxed);
+
 	UGameInstance* GameInstance = GetGameInstance();
 	if (!IsValid(GameInstance))
 	{
@@ -164,19 +654,24 @@ void UJTInputRecorder::UpdateEventArgsDelegates(bool bShouldBind)
 	UGameViewportClient* GameViewportClient = GameInstance->GetGameViewportClient();
 	if (!IsValid(GameViewportClient))
 	{
+		if (bShouldBind)
+		{
+			// Live input only arrives through the viewport, so only input captured explicitly (if any) is recorded
+			UE_LOG(LogJTInputRecorder, Warning, TEXT("No game viewport client (e.g. running headless). Only input passed to CaptureKeyInput/CaptureAxisInput will be recorded"));
+		}
+
 		return;
 	}
 
+	// Always unbound first, since recording sessions and the flight recorder share the same bindings
+	GameViewportClient->OnInputKey().RemoveAll(this);
+	GameViewportClient->OnInputAxis().RemoveAll(this);
+
 	if (bShouldBind)
 	{
 		GameViewportClient->OnInputKey().AddUObject(this, &UJTInputRecorder::RecordKeyInput);
 		GameViewportClient->OnInputAxis().AddUObject(this, &UJTInputRecorder::RecordAxisInput);
 	}
-	else
-	{
-		GameViewportClient->OnInputKey().RemoveAll(this);
-		GameViewportClient->OnInputAxis().RemoveAll(this);
-	}
 }
 
 void UJTInputRecorder::ResetStartTimerHandle()
@@ -232,6 +727,14 @@ void UJTInputRecorder::DrawDebug() const
 			RecordingStatusColor,
 			FString("Recording Session In Progress"));
 
+		static const uint64 RecordingAllocationsHashKey = GetTypeHash(FString("JTInputRecorderAllocations"));
+
+		GEngine->AddOnScreenDebugMessage(
+			RecordingAllocationsHashKey,
+			0.f,
+			RecordingStatusColor,
+			FString::Printf(TEXT("Recorded %llu events with %llu timeline allocations"), NumRecordedEvents, GetNumTimelineAllocations()));
+
 		if (bIsCurrentlyEscaped)
 		{
 			static const uint64 RecordingEscapeHashKey = GetTypeHash(FString("JTInputRecorderEscape"));
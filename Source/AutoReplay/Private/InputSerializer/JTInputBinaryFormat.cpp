@@ -0,0 +1,965 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "InputSerializer/JTInputBinaryFormat.h"
+
+#include "InputSerializer/JTInputSerializer.h"
+
+#include "Misc/Crc.h"
+#include "Serialization/Archive.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace JT
+{
+	namespace AutoReplay
+	{
+		namespace BinaryFormat
+		{
+			namespace
+			{
+				// Key event payload flags. The lowest 3 bits hold the EInputEvent
+				static constexpr uint8 KeyFlag_EventMask = 0x07;
+				static constexpr uint8 KeyFlag_TouchEvent = 0x08;
+				static constexpr uint8 KeyFlag_FullyDepressed = 0x10;
+				static constexpr uint8 KeyFlag_NotDepressed = 0x20;
+
+				// Axis event payload flags
+				static constexpr uint8 AxisFlag_Gamepad = 0x01;
+				static constexpr uint8 AxisFlag_SingleSample = 0x02;
+
+				void WriteVarUInt(FArchive& Ar, uint64 Value)
+				{
+					do
+					{
+						uint8 Byte = static_cast<uint8>(Value & 0x7F);
+						Value >>= 7;
+						if (Value != 0)
+						{
+							Byte |= 0x80;
+						}
+						Ar << Byte;
+					}
+					while (Value != 0);
+				}
+
+				uint64 ReadVarUInt(FArchive& Ar)
+				{
+					uint64 Value = 0;
+					for (int32 Shift = 0; Shift < 64; Shift += 7)
+					{
+						uint8 Byte = 0;
+						Ar << Byte;
+						if (Ar.IsError())
+						{
+							return 0;
+						}
+
+						Value |= (static_cast<uint64>(Byte & 0x7F) << Shift);
+						if ((Byte & 0x80) == 0)
+						{
+							return Value;
+						}
+					}
+
+					// Malformed varint (more than 10 bytes)
+					Ar.SetError();
+					return 0;
+				}
+
+				void WriteVarInt(FArchive& Ar, int32 Value)
+				{
+					// ZigZag so that small negative values (e.g. INDEX_NONE) stay small
+					const uint32 ZigZag = (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31);
+					WriteVarUInt(Ar, ZigZag);
+				}
+
+				int32 ReadVarInt(FArchive& Ar)
+				{
+					const uint32 ZigZag = static_cast<uint32>(ReadVarUInt(Ar));
+					return static_cast<int32>((ZigZag >> 1) ^ (~(ZigZag & 1) + 1));
+				}
+
+				void WriteVarInt64(FArchive& Ar, int64 Value)
+				{
+					const uint64 ZigZag = (static_cast<uint64>(Value) << 1) ^ static_cast<uint64>(Value >> 63);
+					WriteVarUInt(Ar, ZigZag);
+				}
+
+				int64 ReadVarInt64(FArchive& Ar)
+				{
+					const uint64 ZigZag = ReadVarUInt(Ar);
+					return static_cast<int64>((ZigZag >> 1) ^ (~(ZigZag & 1) + 1));
+				}
+
+				/** Reads a count and ensures it could possibly fit in the remainder of the archive */
+				bool ReadCount(FArchive& Ar, int64 SectionEnd, int32 MinBytesPerElement, int32& OutCount)
+				{
+					const uint64 Count = ReadVarUInt(Ar);
+					const int64 RemainingBytes = (SectionEnd - Ar.Tell());
+					if (Ar.IsError() || Count > static_cast<uint64>(MAX_int32)
+						|| (static_cast<int64>(Count) * MinBytesPerElement) > RemainingBytes)
+					{
+						Ar.SetError();
+						return false;
+					}
+
+					OutCount = static_cast<int32>(Count);
+					return true;
+				}
+
+				void WriteVector(FArchive& Ar, const FVector& InVector)
+				{
+					double X = InVector.X;
+					double Y = InVector.Y;
+					double Z = InVector.Z;
+					Ar << X << Y << Z;
+				}
+
+				FVector ReadVector(FArchive& Ar)
+				{
+					double X = 0.0;
+					double Y = 0.0;
+					double Z = 0.0;
+					Ar << X << Y << Z;
+					return FVector(X, Y, Z);
+				}
+
+				void WriteSpatialData(FArchive& Ar, const FJTPlayerSpatialData& InSpatialData)
+				{
+					const FQuat Rotation = InSpatialData.PawnTransform.GetRotation();
+					double QuatX = Rotation.X;
+					double QuatY = Rotation.Y;
+					double QuatZ = Rotation.Z;
+					double QuatW = Rotation.W;
+
+					WriteVector(Ar, InSpatialData.PawnTransform.GetLocation());
+					Ar << QuatX << QuatY << QuatZ << QuatW;
+					WriteVector(Ar, InSpatialData.PawnTransform.GetScale3D());
+
+					double Pitch = InSpatialData.ControlRotation.Pitch;
+					double Yaw = InSpatialData.ControlRotation.Yaw;
+					double Roll = InSpatialData.ControlRotation.Roll;
+					Ar << Pitch << Yaw << Roll;
+
+					WriteVector(Ar, InSpatialData.Velocity);
+				}
+
+				FJTPlayerSpatialData ReadSpatialData(FArchive& Ar, uint8 InVersion)
+				{
+					FJTPlayerSpatialData SpatialData;
+
+					const FVector Location = ReadVector(Ar);
+
+					double QuatX = 0.0;
+					double QuatY = 0.0;
+					double QuatZ = 0.0;
+					double QuatW = 1.0;
+					Ar << QuatX << QuatY << QuatZ << QuatW;
+
+					const FVector Scale = ReadVector(Ar);
+					SpatialData.PawnTransform = FTransform(FQuat(QuatX, QuatY, QuatZ, QuatW), Location, Scale);
+
+					double Pitch = 0.0;
+					double Yaw = 0.0;
+					double Roll = 0.0;
+					Ar << Pitch << Yaw << Roll;
+					SpatialData.ControlRotation = FRotator(Pitch, Yaw, Roll);
+
+					if (InVersion >= static_cast<uint8>(EJTInputRecordingFormatVersion::SpatialCheckpoints))
+					{
+						SpatialData.Velocity = ReadVector(Ar);
+					}
+
+					return SpatialData;
+				}
+
+				/** The number of values a player's spatial data is quantized into for checkpoints */
+				static constexpr int32 NumQuantizedSpatialValues = 16;
+
+				/**
+				 * The precision each quantized value is stored at: location, rotation (quaternion), scale,
+				 * control rotation (degrees) and velocity, in that order
+				 */
+				static constexpr double QuantizedSpatialValuePrecisions[NumQuantizedSpatialValues] =
+				{
+					0.01, 0.01, 0.01,
+					0.000001, 0.000001, 0.000001, 0.000001,
+					0.0001, 0.0001, 0.0001,
+					0.0001, 0.0001, 0.0001,
+					0.01, 0.01, 0.01
+				};
+
+				/** Delta times are quantized to microseconds */
+				static constexpr double QuantizedDeltaTimePrecision = 0.000001;
+
+				void QuantizeSpatialData(const FJTPlayerSpatialData& InSpatialData, int64* OutValues)
+				{
+					const FVector Location = InSpatialData.PawnTransform.GetLocation();
+					const FQuat Rotation = InSpatialData.PawnTransform.GetRotation();
+					const FVector Scale = InSpatialData.PawnTransform.GetScale3D();
+					const FRotator& ControlRotation = InSpatialData.ControlRotation;
+					const FVector& Velocity = InSpatialData.Velocity;
+
+					const double Values[NumQuantizedSpatialValues] =
+					{
+						Location.X, Location.Y, Location.Z,
+						Rotation.X, Rotation.Y, Rotation.Z, Rotation.W,
+						Scale.X, Scale.Y, Scale.Z,
+						ControlRotation.Pitch, ControlRotation.Yaw, ControlRotation.Roll,
+						Velocity.X, Velocity.Y, Velocity.Z
+					};
+
+					for (int32 ValueIndex = 0; ValueIndex < NumQuantizedSpatialValues; ++ValueIndex)
+					{
+						OutValues[ValueIndex] = FMath::RoundToInt64(Values[ValueIndex] / QuantizedSpatialValuePrecisions[ValueIndex]);
+					}
+				}
+
+				FJTPlayerSpatialData DequantizeSpatialData(const int64* InValues)
+				{
+					double Values[NumQuantizedSpatialValues];
+					for (int32 ValueIndex = 0; ValueIndex < NumQuantizedSpatialValues; ++ValueIndex)
+					{
+						Values[ValueIndex] = (static_cast<double>(InValues[ValueIndex]) * QuantizedSpatialValuePrecisions[ValueIndex]);
+					}
+
+					FJTPlayerSpatialData SpatialData;
+					SpatialData.PawnTransform = FTransform(
+						FQuat(Values[3], Values[4], Values[5], Values[6]).GetNormalized(),
+						FVector(Values[0], Values[1], Values[2]),
+						FVector(Values[7], Values[8], Values[9]));
+					SpatialData.ControlRotation = FRotator(Values[10], Values[11], Values[12]);
+					SpatialData.Velocity = FVector(Values[13], Values[14], Values[15]);
+
+					return SpatialData;
+				}
+
+				void WriteSection(FArchive& Ar, ESectionTag InTag, const TArray<uint8>& InPayload)
+				{
+					uint8 Tag = static_cast<uint8>(InTag);
+					uint32 PayloadSize = static_cast<uint32>(InPayload.Num());
+
+					Ar << Tag;
+					Ar << PayloadSize;
+					Ar.Serialize(const_cast<uint8*>(InPayload.GetData()), InPayload.Num());
+				}
+
+				void WriteKeyEvent(FArchive& Ar, const FJTInputTimelineEvent& InTimelineEvent)
+				{
+					const float AmountDepressed = InTimelineEvent.Payload.Key.AmountDepressed;
+
+					uint8 Flags = (InTimelineEvent.Flags & (FJTInputTimelineEvent::KeyFlag_EventMask | FJTInputTimelineEvent::KeyFlag_TouchEvent));
+					Flags |= (AmountDepressed == 1.f ? KeyFlag_FullyDepressed : 0);
+					Flags |= (AmountDepressed == 0.f ? KeyFlag_NotDepressed : 0);
+					Ar << Flags;
+
+					WriteVarInt(Ar, InTimelineEvent.ControllerId);
+					WriteVarInt(Ar, InTimelineEvent.Payload.Key.InputDeviceId);
+
+					if ((Flags & (KeyFlag_FullyDepressed | KeyFlag_NotDepressed)) == 0)
+					{
+						float AmountDepressedToWrite = AmountDepressed;
+						Ar << AmountDepressedToWrite;
+					}
+				}
+
+				void ReadKeyEvent(FArchive& Ar, FJTInputTimelineEvent& OutTimelineEvent)
+				{
+					uint8 Flags = 0;
+					Ar << Flags;
+
+					OutTimelineEvent.EventType = EJTInputEventType::Key;
+					OutTimelineEvent.Flags = (Flags & (FJTInputTimelineEvent::KeyFlag_EventMask | FJTInputTimelineEvent::KeyFlag_TouchEvent));
+					OutTimelineEvent.ControllerId = ReadVarInt(Ar);
+					OutTimelineEvent.Payload.Key.InputDeviceId = ReadVarInt(Ar);
+
+					if (Flags & KeyFlag_FullyDepressed)
+					{
+						OutTimelineEvent.Payload.Key.AmountDepressed = 1.f;
+					}
+					else if (Flags & KeyFlag_NotDepressed)
+					{
+						OutTimelineEvent.Payload.Key.AmountDepressed = 0.f;
+					}
+					else
+					{
+						Ar << OutTimelineEvent.Payload.Key.AmountDepressed;
+					}
+				}
+
+				void WriteAxisEvent(FArchive& Ar, const FJTInputTimelineEvent& InTimelineEvent)
+				{
+					const FJTInputTimelineEvent::FAxisPayload& AxisPayload = InTimelineEvent.Payload.Axis;
+
+					uint8 Flags = (InTimelineEvent.IsGamepad() ? AxisFlag_Gamepad : 0);
+					Flags |= (AxisPayload.NumSamples == 1 ? AxisFlag_SingleSample : 0);
+					Ar << Flags;
+
+					WriteVarInt(Ar, InTimelineEvent.ControllerId);
+
+					float Delta = AxisPayload.Delta;
+					float DeltaTime = AxisPayload.DeltaTime;
+					Ar << Delta << DeltaTime;
+
+					if ((Flags & AxisFlag_SingleSample) == 0)
+					{
+						WriteVarInt(Ar, AxisPayload.NumSamples);
+					}
+				}
+
+				void ReadAxisEvent(FArchive& Ar, FJTInputTimelineEvent& OutTimelineEvent)
+				{
+					uint8 Flags = 0;
+					Ar << Flags;
+
+					OutTimelineEvent.EventType = EJTInputEventType::Axis;
+					OutTimelineEvent.Flags = ((Flags & AxisFlag_Gamepad) ? FJTInputTimelineEvent::AxisFlag_Gamepad : 0);
+					OutTimelineEvent.ControllerId = ReadVarInt(Ar);
+					Ar << OutTimelineEvent.Payload.Axis.Delta << OutTimelineEvent.Payload.Axis.DeltaTime;
+					OutTimelineEvent.Payload.Axis.NumSamples = ((Flags & AxisFlag_SingleSample) ? 1 : ReadVarInt(Ar));
+				}
+
+				bool ReadMetadataSection(FArchive& Ar, int64 SectionEnd, FJTInputRecordingSession& OutSession)
+				{
+					Ar << OutSession.StartTime;
+					OutSession.StartFrameCounter = ReadVarUInt(Ar);
+
+					// Each player's spatial data is at least 13 doubles (16 once velocity was added)
+					static constexpr int32 SpatialDataSize = (13 * sizeof(double));
+
+					int32 NumPlayers = 0;
+					if (!ReadCount(Ar, SectionEnd, SpatialDataSize, NumPlayers))
+					{
+						return false;
+					}
+
+					OutSession.PlayersSpatialDataCollection.Reset(NumPlayers);
+					for (int32 PlayerIndex = 0; PlayerIndex < NumPlayers; ++PlayerIndex)
+					{
+						OutSession.PlayersSpatialDataCollection.Emplace(ReadSpatialData(Ar, OutSession.RecordingFormatVersion));
+					}
+
+					if (OutSession.RecordingFormatVersion >= static_cast<uint8>(EJTInputRecordingFormatVersion::RandomSeeds))
+					{
+						uint8 bHasRandomSeeds = 0;
+						Ar << bHasRandomSeeds;
+						OutSession.bHasRandomSeeds = (bHasRandomSeeds != 0);
+
+						if (OutSession.bHasRandomSeeds)
+						{
+							OutSession.RandomSeed = ReadVarInt(Ar);
+
+							// Each stream seed is at least an empty name and a one byte seed
+							int32 NumStreamSeeds = 0;
+							if (!ReadCount(Ar, SectionEnd, (sizeof(int32) + 1), NumStreamSeeds))
+							{
+								return false;
+							}
+
+							OutSession.RandomStreamSeeds.Reset(NumStreamSeeds);
+							for (int32 StreamSeedIndex = 0; StreamSeedIndex < NumStreamSeeds; ++StreamSeedIndex)
+							{
+								FString StreamName;
+								Ar << StreamName;
+
+								FJTRandomStreamSeed& StreamSeed = OutSession.RandomStreamSeeds.AddDefaulted_GetRef();
+								StreamSeed.Name = FName(*StreamName);
+								StreamSeed.Seed = ReadVarInt(Ar);
+							}
+						}
+					}
+
+					return !Ar.IsError();
+				}
+
+				bool ReadTimelineChunkSection(FArchive& Ar, int64 SectionEnd, FJTInputRecordingSession& OutSession)
+				{
+					FJTInputTimeline& Timeline = OutSession.InputTimeline;
+
+					int32 NumKeys = 0;
+					if (!ReadCount(Ar, SectionEnd, 1, NumKeys))
+					{
+						return false;
+					}
+
+					// Map the chunk local key table onto the session's interned key table
+					TArray<FJTInputKeyIndex> ChunkKeyIndices;
+					ChunkKeyIndices.Reserve(NumKeys);
+					for (int32 KeyIndex = 0; KeyIndex < NumKeys; ++KeyIndex)
+					{
+						FString KeyName;
+						Ar << KeyName;
+						ChunkKeyIndices.Emplace(Timeline.InternKey(FKey(FName(*KeyName))));
+					}
+
+					int32 NumFrames = 0;
+					if (!ReadCount(Ar, SectionEnd, 2, NumFrames))
+					{
+						return false;
+					}
+
+					FJTFrameDelta PreviousFrameDelta = 0;
+					for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+					{
+						const FJTFrameDelta FrameDelta = (PreviousFrameDelta + static_cast<FJTFrameDelta>(ReadVarUInt(Ar)));
+						PreviousFrameDelta = FrameDelta;
+
+						int32 NumEvents = 0;
+						if (!ReadCount(Ar, SectionEnd, 3, NumEvents))
+						{
+							return false;
+						}
+
+						for (int32 EventIndex = 0; EventIndex < NumEvents; ++EventIndex)
+						{
+							uint8 EventType = 0;
+							Ar << EventType;
+
+							const int32 ChunkKeyIndex = static_cast<int32>(ReadVarUInt(Ar));
+							if (Ar.IsError() || !ChunkKeyIndices.IsValidIndex(ChunkKeyIndex))
+							{
+								Ar.SetError();
+								return false;
+							}
+
+							FJTInputTimelineEvent& TimelineEvent = Timeline.AddEvent(FrameDelta);
+							TimelineEvent.KeyIndex = ChunkKeyIndices[ChunkKeyIndex];
+
+							if (static_cast<EJTInputEventType>(EventType) == EJTInputEventType::Key)
+							{
+								ReadKeyEvent(Ar, TimelineEvent);
+							}
+							else if (static_cast<EJTInputEventType>(EventType) == EJTInputEventType::Axis)
+							{
+								ReadAxisEvent(Ar, TimelineEvent);
+							}
+							else
+							{
+								Ar.SetError();
+								return false;
+							}
+						}
+					}
+
+					return !Ar.IsError();
+				}
+
+				bool ReadSpatialCheckpointsSection(FArchive& Ar, int64 SectionEnd, FJTInputRecordingSession& OutSession)
+				{
+					int32 NumCheckpoints = 0;
+					if (!ReadCount(Ar, SectionEnd, 2, NumCheckpoints))
+					{
+						return false;
+					}
+
+					// The quantized values of each player at the previous checkpoint, which the current one is delta encoded against
+					TArray<int64> PreviousValues;
+					FJTPlayersSpatialDataCollection CheckpointPlayers;
+
+					FJTFrameDelta PreviousFrameDelta = 0;
+					for (int32 CheckpointIndex = 0; CheckpointIndex < NumCheckpoints; ++CheckpointIndex)
+					{
+						const FJTFrameDelta FrameDelta = (PreviousFrameDelta + static_cast<FJTFrameDelta>(ReadVarUInt(Ar)));
+						PreviousFrameDelta = FrameDelta;
+
+						int32 NumPlayers = 0;
+						if (!ReadCount(Ar, SectionEnd, NumQuantizedSpatialValues, NumPlayers))
+						{
+							return false;
+						}
+
+						if (PreviousValues.Num() < (NumPlayers * NumQuantizedSpatialValues))
+						{
+							PreviousValues.SetNumZeroed(NumPlayers * NumQuantizedSpatialValues);
+						}
+
+						CheckpointPlayers.Reset(NumPlayers);
+						for (int32 PlayerIndex = 0; PlayerIndex < NumPlayers; ++PlayerIndex)
+						{
+							int64* PlayerValues = (PreviousValues.GetData() + (PlayerIndex * NumQuantizedSpatialValues));
+							for (int32 ValueIndex = 0; ValueIndex < NumQuantizedSpatialValues; ++ValueIndex)
+							{
+								PlayerValues[ValueIndex] += ReadVarInt64(Ar);
+							}
+
+							CheckpointPlayers.Emplace(DequantizeSpatialData(PlayerValues));
+						}
+
+						if (Ar.IsError())
+						{
+							return false;
+						}
+
+						OutSession.SpatialCheckpoints.AddCheckpoint(FrameDelta, CheckpointPlayers);
+					}
+
+					return !Ar.IsError();
+				}
+
+				bool ReadDeltaTimesSection(FArchive& Ar, int64 SectionEnd, FJTInputRecordingSession& OutSession)
+				{
+					const FJTFrameDelta FirstFrameDelta = static_cast<FJTFrameDelta>(ReadVarUInt(Ar));
+
+					int32 NumFrames = 0;
+					if (!ReadCount(Ar, SectionEnd, 1, NumFrames))
+					{
+						return false;
+					}
+
+					OutSession.DeltaTimes.Reserve(OutSession.DeltaTimes.Num() + NumFrames);
+
+					int64 DeltaMicroseconds = 0;
+					for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+					{
+						DeltaMicroseconds += ReadVarInt64(Ar);
+						OutSession.DeltaTimes.AddFrame((FirstFrameDelta + FrameIndex), static_cast<float>(DeltaMicroseconds * QuantizedDeltaTimePrecision));
+					}
+
+					return !Ar.IsError();
+				}
+
+				bool ReadStopInfoSection(FArchive& Ar, FJTInputRecordingSession& OutSession)
+				{
+					Ar << OutSession.StopTime;
+					OutSession.StopFrameCounter = ReadVarUInt(Ar);
+
+					return !Ar.IsError();
+				}
+
+				bool ReadHeader(FArchive& Ar, FJTInputRecordingSession& OutSession)
+				{
+					uint32 Magic = 0;
+					uint8 Version = 0;
+					Ar << Magic;
+					Ar << Version;
+
+					if (Ar.IsError() || Magic != FileMagic)
+					{
+						UE_LOG(LogJTInputSerializer, Error, TEXT("Could not read binary session. File is not a recording session"));
+						return false;
+					}
+
+					if (Version > static_cast<uint8>(EJTInputRecordingFormatVersion::Latest))
+					{
+						UE_LOG(LogJTInputSerializer, Error, TEXT("Could not read binary session. Unsupported format version %u"), Version);
+						return false;
+					}
+
+					OutSession.RecordingFormatVersion = Version;
+					return true;
+				}
+
+				/**
+				 * Reads sections until the End section or the given offset, whichever comes first
+				 *
+				 * @param bOutReachedEnd set if the End section was read
+				 */
+				bool ReadSections(FArchive& Ar, int64 SectionsEnd, FJTInputRecordingSession& OutSession, FString& OutNextSegmentFileName, bool& bOutReachedEnd)
+				{
+					bOutReachedEnd = false;
+					OutNextSegmentFileName.Reset();
+
+					while (Ar.Tell() < SectionsEnd)
+					{
+						uint8 Tag = 0;
+						uint32 PayloadSize = 0;
+						Ar << Tag;
+						Ar << PayloadSize;
+
+						const int64 SectionEnd = (Ar.Tell() + PayloadSize);
+						if (Ar.IsError() || SectionEnd > SectionsEnd)
+						{
+							UE_LOG(LogJTInputSerializer, Error, TEXT("Could not read binary session. Section is truncated"));
+							return false;
+						}
+
+						bool bReadSection = true;
+						switch (static_cast<ESectionTag>(Tag))
+						{
+							case ESectionTag::Metadata:
+								bReadSection = ReadMetadataSection(Ar, SectionEnd, OutSession);
+								break;
+							case ESectionTag::TimelineChunk:
+								bReadSection = ReadTimelineChunkSection(Ar, SectionEnd, OutSession);
+								break;
+							case ESectionTag::SpatialCheckpoints:
+								bReadSection = ReadSpatialCheckpointsSection(Ar, SectionEnd, OutSession);
+								break;
+							case ESectionTag::DeltaTimes:
+								bReadSection = ReadDeltaTimesSection(Ar, SectionEnd, OutSession);
+								break;
+							case ESectionTag::StopInfo:
+								bReadSection = ReadStopInfoSection(Ar, OutSession);
+								break;
+							case ESectionTag::NextSegment:
+								Ar << OutNextSegmentFileName;
+								bReadSection = (!Ar.IsError() && !OutNextSegmentFileName.IsEmpty());
+								break;
+							case ESectionTag::Commit:
+								// Only needed to recover cut off sessions (see RecoverSession)
+								break;
+							case ESectionTag::End:
+								bOutReachedEnd = true;
+								return true;
+							default:
+								// Unknown sections are written by newer versions of the format. Skip them
+								break;
+						}
+
+						if (!bReadSection || Ar.Tell() > SectionEnd)
+						{
+							UE_LOG(LogJTInputSerializer, Error, TEXT("Could not read binary session. Section %u is malformed"), Tag);
+							return false;
+						}
+
+						Ar.Seek(SectionEnd);
+					}
+
+					return true;
+				}
+
+				/**
+				 * Scans the section headers (from the current position) for the last commit whose checksum matches
+				 *
+				 * @return the offset just past the last valid commit, or INDEX_NONE if there is none
+				 */
+				int64 FindCommittedEnd(FArchive& Ar, bool& bOutIsComplete)
+				{
+					bOutIsComplete = false;
+
+					int64 CommittedEnd = INDEX_NONE;
+					int64 UncommittedStart = Ar.Tell();
+					TArray<uint8> UncommittedBytes;
+
+					// Each section header is a tag and a payload size
+					static constexpr int64 SectionHeaderSize = (sizeof(uint8) + sizeof(uint32));
+
+					while ((Ar.Tell() + SectionHeaderSize) <= Ar.TotalSize())
+					{
+						const int64 SectionStart = Ar.Tell();
+
+						uint8 Tag = 0;
+						uint32 PayloadSize = 0;
+						Ar << Tag;
+						Ar << PayloadSize;
+
+						const int64 SectionEnd = (Ar.Tell() + PayloadSize);
+						if (Ar.IsError() || SectionEnd > Ar.TotalSize())
+						{
+							break;
+						}
+
+						if (static_cast<ESectionTag>(Tag) == ESectionTag::End)
+						{
+							bOutIsComplete = true;
+							return SectionEnd;
+						}
+
+						if (static_cast<ESectionTag>(Tag) == ESectionTag::Commit)
+						{
+							uint32 Crc = 0;
+							Ar << Crc;
+
+							UncommittedBytes.SetNumUninitialized(static_cast<int32>(SectionStart - UncommittedStart), false);
+							Ar.Seek(UncommittedStart);
+							Ar.Serialize(UncommittedBytes.GetData(), UncommittedBytes.Num());
+
+							if (Ar.IsError() || FCrc::MemCrc32(UncommittedBytes.GetData(), UncommittedBytes.Num()) != Crc)
+							{
+								UE_LOG(LogJTInputSerializer, Warning, TEXT("Commit at offset %lld does not match its checksum. Dropping everything after it"), SectionStart);
+								break;
+							}
+
+							CommittedEnd = SectionEnd;
+							UncommittedStart = SectionEnd;
+						}
+
+						Ar.Seek(SectionEnd);
+					}
+
+					return CommittedEnd;
+				}
+			} // namespace
+
+			void WriteSession(FArchive& Ar, const FJTInputRecordingSession& InSession)
+			{
+				WriteHeader(Ar);
+				WriteMetadataSection(Ar, InSession);
+
+				const FJTInputTimeline& Timeline = InSession.InputTimeline;
+				for (int32 FirstFrameIndex = 0; FirstFrameIndex < Timeline.Num(); FirstFrameIndex += MaxFramesPerTimelineChunk)
+				{
+					const int32 NumFrames = FMath::Min(MaxFramesPerTimelineChunk, (Timeline.Num() - FirstFrameIndex));
+					WriteTimelineChunkSection(Ar, Timeline, FirstFrameIndex, NumFrames);
+				}
+
+				const FJTSpatialCheckpointTrack& Checkpoints = InSession.SpatialCheckpoints;
+				for (int32 FirstCheckpointIndex = 0; FirstCheckpointIndex < Checkpoints.Num(); FirstCheckpointIndex += MaxCheckpointsPerSection)
+				{
+					const int32 NumCheckpoints = FMath::Min(MaxCheckpointsPerSection, (Checkpoints.Num() - FirstCheckpointIndex));
+					WriteSpatialCheckpointsSection(Ar, Checkpoints, FirstCheckpointIndex, NumCheckpoints);
+				}
+
+				const FJTDeltaTimeTrack& DeltaTimes = InSession.DeltaTimes;
+				for (int32 FirstFrameIndex = 0; FirstFrameIndex < DeltaTimes.Num(); FirstFrameIndex += MaxFramesPerDeltaTimesSection)
+				{
+					const int32 NumFrames = FMath::Min(MaxFramesPerDeltaTimesSection, (DeltaTimes.Num() - FirstFrameIndex));
+					WriteDeltaTimesSection(Ar, DeltaTimes, (DeltaTimes.GetFirstFrameDelta() + FirstFrameIndex), NumFrames);
+				}
+
+				WriteStopInfoSection(Ar, InSession);
+				WriteEndSection(Ar);
+			}
+
+			void WriteHeader(FArchive& Ar)
+			{
+				uint32 Magic = FileMagic;
+				uint8 Version = static_cast<uint8>(EJTInputRecordingFormatVersion::Latest);
+
+				Ar << Magic;
+				Ar << Version;
+			}
+
+			void WriteMetadataSection(FArchive& Ar, const FJTInputRecordingSession& InSession)
+			{
+				TArray<uint8> Payload;
+				FMemoryWriter PayloadAr(Payload);
+
+				FString StartTime = InSession.StartTime;
+				PayloadAr << StartTime;
+				WriteVarUInt(PayloadAr, InSession.StartFrameCounter);
+
+				WriteVarUInt(PayloadAr, InSession.PlayersSpatialDataCollection.Num());
+				for (const FJTPlayerSpatialData& SpatialData : InSession.PlayersSpatialDataCollection)
+				{
+					WriteSpatialData(PayloadAr, SpatialData);
+				}
+
+				uint8 bHasRandomSeeds = (InSession.bHasRandomSeeds ? 1 : 0);
+				PayloadAr << bHasRandomSeeds;
+				if (InSession.bHasRandomSeeds)
+				{
+					WriteVarInt(PayloadAr, InSession.RandomSeed);
+
+					WriteVarUInt(PayloadAr, InSession.RandomStreamSeeds.Num());
+					for (const FJTRandomStreamSeed& StreamSeed : InSession.RandomStreamSeeds)
+					{
+						FString StreamName = StreamSeed.Name.ToString();
+						PayloadAr << StreamName;
+						WriteVarInt(PayloadAr, StreamSeed.Seed);
+					}
+				}
+
+				WriteSection(Ar, ESectionTag::Metadata, Payload);
+			}
+
+			void WriteTimelineChunkSection(FArchive& Ar, const FJTInputTimeline& InTimeline, int32 InFirstFrameIndex, int32 InNumFrames)
+			{
+				const int32 EndFrameIndex = (InFirstFrameIndex + InNumFrames);
+
+				// Build the chunk local key table out of only the keys referenced by the chunk's events
+				TArray<int32> ChunkKeyIndices;
+				ChunkKeyIndices.Init(INDEX_NONE, InTimeline.NumKeys());
+
+				TArray<FJTInputKeyIndex> ChunkKeyTable;
+				for (int32 FrameIndex = InFirstFrameIndex; FrameIndex < EndFrameIndex; ++FrameIndex)
+				{
+					for (const FJTInputTimelineEvent& TimelineEvent : InTimeline.GetFrameEvents(FrameIndex))
+					{
+						if (ChunkKeyIndices[TimelineEvent.KeyIndex] == INDEX_NONE)
+						{
+							ChunkKeyIndices[TimelineEvent.KeyIndex] = ChunkKeyTable.Emplace(TimelineEvent.KeyIndex);
+						}
+					}
+				}
+
+				TArray<uint8> Payload;
+				FMemoryWriter PayloadAr(Payload);
+
+				WriteVarUInt(PayloadAr, ChunkKeyTable.Num());
+				for (const FJTInputKeyIndex KeyIndex : ChunkKeyTable)
+				{
+					FString KeyNameString = InTimeline.GetKey(KeyIndex).GetFName().ToString();
+					PayloadAr << KeyNameString;
+				}
+
+				WriteVarUInt(PayloadAr, InNumFrames);
+
+				FJTFrameDelta PreviousFrameDelta = 0;
+				for (int32 FrameIndex = InFirstFrameIndex; FrameIndex < EndFrameIndex; ++FrameIndex)
+				{
+					const FJTInputTimelineFrame& Frame = InTimeline[FrameIndex];
+
+					// Frames are strictly increasing, so the delta to the previous frame is always positive (and small)
+					WriteVarUInt(PayloadAr, (Frame.FrameDelta - PreviousFrameDelta));
+					PreviousFrameDelta = Frame.FrameDelta;
+
+					WriteVarUInt(PayloadAr, Frame.NumEvents);
+					for (const FJTInputTimelineEvent& TimelineEvent : InTimeline.GetFrameEvents(FrameIndex))
+					{
+						uint8 EventType = static_cast<uint8>(TimelineEvent.EventType);
+						PayloadAr << EventType;
+						WriteVarUInt(PayloadAr, ChunkKeyIndices[TimelineEvent.KeyIndex]);
+
+						if (TimelineEvent.EventType == EJTInputEventType::Key)
+						{
+							WriteKeyEvent(PayloadAr, TimelineEvent);
+						}
+						else
+						{
+							WriteAxisEvent(PayloadAr, TimelineEvent);
+						}
+					}
+				}
+
+				WriteSection(Ar, ESectionTag::TimelineChunk, Payload);
+			}
+
+			void WriteSpatialCheckpointsSection(FArchive& Ar, const FJTSpatialCheckpointTrack& InCheckpoints, int32 InFirstCheckpointIndex, int32 InNumCheckpoints)
+			{
+				TArray<uint8> Payload;
+				FMemoryWriter PayloadAr(Payload);
+
+				WriteVarUInt(PayloadAr, InNumCheckpoints);
+
+				TArray<int64> PreviousValues;
+				int64 Values[NumQuantizedSpatialValues];
+
+				FJTFrameDelta PreviousFrameDelta = 0;
+				for (int32 CheckpointIndex = InFirstCheckpointIndex; CheckpointIndex < (InFirstCheckpointIndex + InNumCheckpoints); ++CheckpointIndex)
+				{
+					const FJTSpatialCheckpoint& Checkpoint = InCheckpoints[CheckpointIndex];
+
+					// Checkpoints are strictly increasing, so the delta to the previous checkpoint is always positive
+					WriteVarUInt(PayloadAr, (Checkpoint.FrameDelta - PreviousFrameDelta));
+					PreviousFrameDelta = Checkpoint.FrameDelta;
+
+					const TArrayView<const FJTPlayerSpatialData> Players = InCheckpoints.GetPlayers(CheckpointIndex);
+					WriteVarUInt(PayloadAr, Players.Num());
+
+					if (PreviousValues.Num() < (Players.Num() * NumQuantizedSpatialValues))
+					{
+						PreviousValues.SetNumZeroed(Players.Num() * NumQuantizedSpatialValues);
+					}
+
+					for (int32 PlayerIndex = 0; PlayerIndex < Players.Num(); ++PlayerIndex)
+					{
+						QuantizeSpatialData(Players[PlayerIndex], Values);
+
+						int64* PlayerPreviousValues = (PreviousValues.GetData() + (PlayerIndex * NumQuantizedSpatialValues));
+						for (int32 ValueIndex = 0; ValueIndex < NumQuantizedSpatialValues; ++ValueIndex)
+						{
+							WriteVarInt64(PayloadAr, (Values[ValueIndex] - PlayerPreviousValues[ValueIndex]));
+							PlayerPreviousValues[ValueIndex] = Values[ValueIndex];
+						}
+					}
+				}
+
+				WriteSection(Ar, ESectionTag::SpatialCheckpoints, Payload);
+			}
+
+			void WriteDeltaTimesSection(FArchive& Ar, const FJTDeltaTimeTrack& InDeltaTimes, FJTFrameDelta InFirstFrameDelta, int32 InNumFrames)
+			{
+				TArray<uint8> Payload;
+				FMemoryWriter PayloadAr(Payload);
+
+				WriteVarUInt(PayloadAr, InFirstFrameDelta);
+				WriteVarUInt(PayloadAr, InNumFrames);
+
+				// Frame times barely change from one frame to the next, so the delta to the previous frame is usually tiny
+				int64 PreviousDeltaMicroseconds = 0;
+				for (int32 FrameIndex = 0; FrameIndex < InNumFrames; ++FrameIndex)
+				{
+					const float DeltaSeconds = InDeltaTimes.GetDeltaSeconds(InFirstFrameDelta + FrameIndex);
+					const int64 DeltaMicroseconds = FMath::RoundToInt64(DeltaSeconds / QuantizedDeltaTimePrecision);
+
+					WriteVarInt64(PayloadAr, (DeltaMicroseconds - PreviousDeltaMicroseconds));
+					PreviousDeltaMicroseconds = DeltaMicroseconds;
+				}
+
+				WriteSection(Ar, ESectionTag::DeltaTimes, Payload);
+			}
+
+			void WriteStopInfoSection(FArchive& Ar, const FJTInputRecordingSession& InSession)
+			{
+				TArray<uint8> Payload;
+				FMemoryWriter PayloadAr(Payload);
+
+				FString StopTime = InSession.StopTime;
+				PayloadAr << StopTime;
+				WriteVarUInt(PayloadAr, InSession.StopFrameCounter);
+
+				WriteSection(Ar, ESectionTag::StopInfo, Payload);
+			}
+
+			void WriteNextSegmentSection(FArchive& Ar, const FString& InNextSegmentFileName)
+			{
+				TArray<uint8> Payload;
+				FMemoryWriter PayloadAr(Payload);
+
+				FString NextSegmentFileName = InNextSegmentFileName;
+				PayloadAr << NextSegmentFileName;
+
+				WriteSection(Ar, ESectionTag::NextSegment, Payload);
+			}
+
+			void WriteEndSection(FArchive& Ar)
+			{
+				WriteSection(Ar, ESectionTag::End, TArray<uint8>());
+			}
+
+			void WriteCommitSection(FArchive& Ar, uint32 InCrc)
+			{
+				TArray<uint8> Payload;
+				FMemoryWriter PayloadAr(Payload);
+
+				uint32 Crc = InCrc;
+				PayloadAr << Crc;
+
+				WriteSection(Ar, ESectionTag::Commit, Payload);
+			}
+
+			bool ReadSession(FArchive& Ar, FJTInputRecordingSession& OutSession, FString& OutNextSegmentFileName)
+			{
+				if (!ReadHeader(Ar, OutSession))
+				{
+					return false;
+				}
+
+				bool bReachedEnd = false;
+				if (!ReadSections(Ar, Ar.TotalSize(), OutSession, OutNextSegmentFileName, bReachedEnd))
+				{
+					return false;
+				}
+
+				if (!bReachedEnd)
+				{
+					UE_LOG(LogJTInputSerializer, Error, TEXT("Could not read binary session. Missing end of file marker"));
+					return false;
+				}
+
+				return true;
+			}
+
+			bool RecoverSession(FArchive& Ar, FJTInputRecordingSession& OutSession, FString& OutNextSegmentFileName, bool& bOutIsComplete)
+			{
+				if (!ReadHeader(Ar, OutSession))
+				{
+					return false;
+				}
+
+				const int64 SectionsStart = Ar.Tell();
+				const int64 CommittedEnd = FindCommittedEnd(Ar, bOutIsComplete);
+				if (CommittedEnd == INDEX_NONE)
+				{
+					UE_LOG(LogJTInputSerializer, Error, TEXT("Could not recover binary session. No intact commit (the session may not have been journaled)"));
+					return false;
+				}
+
+				Ar.Seek(SectionsStart);
+
+				bool bReachedEnd = false;
+				return ReadSections(Ar, CommittedEnd, OutSession, OutNextSegmentFileName, bReachedEnd);
+			}
+		} // namespace BinaryFormat
+	} // namespace AutoReplay
+} // namespace JT
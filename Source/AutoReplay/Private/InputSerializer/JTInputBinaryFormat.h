@@ -0,0 +1,116 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "JTAutoReplayCommonTypes.h"
+
+class FArchive;
+
+/**
+ * Layout of a binary (.jtirs) recording session file:
+ *
+ * [Header]   Magic (uint32), RecordingFormatVersion (uint8)
+ * [Section]* Tag (uint8), PayloadSize (uint32), Payload (PayloadSize bytes)
+ *
+ * The file always terminates with an End section. Files with a newer RecordingFormatVersion than the reader's
+ * Latest are rejected, since a version bump may change the layout of existing sections (e.g. the Metadata section
+ * gained random seeds). Sections with unknown tags are only skipped within a supported version, so a section can be
+ * added without a version bump when older readers of that version can safely ignore it.
+ *
+ * Each timeline chunk section is self-contained: it carries its own FKey name table and
+ * encodes frame deltas as varints relative to the previous frame within the chunk.
+ *
+ * Spatial checkpoint sections are self-contained as well. Each player's values are quantized (see
+ * JTInputBinaryFormat.cpp for the precision of each) and encoded as varint deltas from the same player's
+ * values at the previous checkpoint within the section, so players that barely move cost a byte per value.
+ *
+ * Delta time sections hold a contiguous run of frames, each frame's delta time quantized to microseconds and
+ * encoded as a varint delta from the previous frame's, so a steady frame rate costs about a byte per frame.
+ *
+ * Streamed recordings may be split into a linked set of segment files. Only the first segment
+ * holds the Metadata section, every segment but the last ends with a NextSegment section naming
+ * the file that continues the session and the last segment holds the StopInfo section.
+ *
+ * Journaled recordings additionally follow every batch of sections with a Commit section, holding a checksum
+ * of all bytes written since the previous commit. If the recording never finished (e.g. the game crashed), the
+ * file is still readable up to its last valid commit through RecoverSession.
+ */
+namespace JT
+{
+	namespace AutoReplay
+	{
+		namespace BinaryFormat
+		{
+			/** 'JTIR' in little endian */
+			static constexpr uint32 FileMagic = 0x5249544A;
+
+			/** Upper bound on the number of frames written to a single timeline chunk */
+			static constexpr int32 MaxFramesPerTimelineChunk = 4096;
+
+			/** Upper bound on the number of checkpoints written to a single spatial checkpoints section */
+			static constexpr int32 MaxCheckpointsPerSection = 1024;
+
+			/** Upper bound on the number of frames written to a single delta times section */
+			static constexpr int32 MaxFramesPerDeltaTimesSection = 4096;
+
+			enum class ESectionTag : uint8
+			{
+				/** Session start data (start time, start frame counter, player spatial data, random seeds) */
+				Metadata = 1,
+
+				/** A run of timeline frames along with the key name table they reference */
+				TimelineChunk = 2,
+
+				/** Session stop data (stop time, stop frame counter) */
+				StopInfo = 3,
+
+				/** The file name (relative to the current file's directory) of the segment continuing this session */
+				NextSegment = 4,
+
+				/** A CRC32 of every byte between the end of the previous commit (or the header) and this section */
+				Commit = 5,
+
+				/** A run of spatial checkpoints, delta encoded against the previous checkpoint within the section */
+				SpatialCheckpoints = 6,
+
+				/** A contiguous run of frame delta times, delta encoded against the previous frame within the section */
+				DeltaTimes = 7,
+
+				End = 255
+			};
+
+			/** Serializes a whole session (header, metadata, timeline, tracks and stop info) to the given archive */
+			void WriteSession(FArchive& Ar, const FJTInputRecordingSession& InSession);
+
+			void WriteHeader(FArchive& Ar);
+			void WriteMetadataSection(FArchive& Ar, const FJTInputRecordingSession& InSession);
+			void WriteTimelineChunkSection(FArchive& Ar, const FJTInputTimeline& InTimeline, int32 InFirstFrameIndex, int32 InNumFrames);
+			void WriteSpatialCheckpointsSection(FArchive& Ar, const FJTSpatialCheckpointTrack& InCheckpoints, int32 InFirstCheckpointIndex, int32 InNumCheckpoints);
+			void WriteDeltaTimesSection(FArchive& Ar, const FJTDeltaTimeTrack& InDeltaTimes, FJTFrameDelta InFirstFrameDelta, int32 InNumFrames);
+			void WriteStopInfoSection(FArchive& Ar, const FJTInputRecordingSession& InSession);
+			void WriteNextSegmentSection(FArchive& Ar, const FString& InNextSegmentFileName);
+			void WriteEndSection(FArchive& Ar);
+			void WriteCommitSection(FArchive& Ar, uint32 InCrc);
+
+			/**
+			 * Deserializes a session (or a single segment of one) from the given archive. Read data is
+			 * appended to the given session, so that consecutive segments can be read into the same session
+			 *
+			 * @param OutNextSegmentFileName set if the archive is a segment that is continued in another file
+			 *
+			 * @return whether or not the archive held a valid, complete session or segment
+			 */
+			bool ReadSession(FArchive& Ar, FJTInputRecordingSession& OutSession, FString& OutNextSegmentFileName);
+
+			/**
+			 * Like ReadSession, but for journaled sessions (or segments) that may have been cut off. Only the sections
+			 * up to the last commit whose checksum matches are read
+			 *
+			 * @param bOutIsComplete set if the archive held a complete session or segment, i.e. nothing had to be dropped
+			 *
+			 * @return whether or not anything could be recovered (i.e. the header and at least one commit were intact)
+			 */
+			bool RecoverSession(FArchive& Ar, FJTInputRecordingSession& OutSession, FString& OutNextSegmentFileName, bool& bOutIsComplete);
+		} // namespace BinaryFormat
+	} // namespace AutoReplay
+} // namespace JT
@@ -0,0 +1,103 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "JTAutoReplayCommonTypes.h"
+
+#include "JTInputJsonTypes.generated.h"
+
+/**
+ * Reflected mirrors of the runtime session types, used as the interchange layout for json sessions.
+ * The runtime timeline is stored in a compact form that can't be reflected, so it is expanded into
+ * these when exporting and collapsed back when importing. Their layout must stay stable so that
+ * previously exported json sessions keep importing
+ */
+
+USTRUCT()
+struct FJTInputJsonTimelineEvent
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	FJTInputKeyEventArgs KeyEventArgs;
+
+	UPROPERTY()
+	FJTInputAxisEventArgs AxisEventArgs;
+
+	UPROPERTY()
+	EJTInputEventType EventType = EJTInputEventType::Invalid;
+};
+
+USTRUCT()
+struct FJTInputJsonTimelineFrame
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	uint32 FrameDelta = 0;
+
+	UPROPERTY()
+	TArray<FJTInputJsonTimelineEvent> FrameEvents;
+};
+
+USTRUCT()
+struct FJTInputJsonSpatialCheckpoint
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	uint32 FrameDelta = 0;
+
+	UPROPERTY()
+	TArray<FJTPlayerSpatialData> PlayersSpatialDataCollection;
+};
+
+USTRUCT()
+struct FJTInputJsonRecordingSession
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	TArray<FJTInputJsonTimelineFrame> InputTimeline;
+
+	UPROPERTY()
+	TArray<FJTPlayerSpatialData> PlayersSpatialDataCollection;
+
+	UPROPERTY()
+	TArray<FJTInputJsonSpatialCheckpoint> SpatialCheckpoints;
+
+	/** The frame delta of the first entry in DeltaTimes */
+	UPROPERTY()
+	uint32 FirstDeltaTimeFrame = 0;
+
+	UPROPERTY()
+	TArray<float> DeltaTimes;
+
+	UPROPERTY()
+	bool bHasRandomSeeds = false;
+
+	UPROPERTY()
+	int32 RandomSeed = 0;
+
+	UPROPERTY()
+	TArray<FJTRandomStreamSeed> RandomStreamSeeds;
+
+	UPROPERTY()
+	FString StartTime;
+
+	UPROPERTY()
+	FString StopTime;
+
+	UPROPERTY()
+	uint64 StartFrameCounter = 0;
+
+	UPROPERTY()
+	uint64 StopFrameCounter = 0;
+
+	UPROPERTY()
+	uint8 RecordingFormatVersion = 0;
+};
@@ -2,22 +2,199 @@
 
 #include "InputSerializer/JTInputSerializer.h"
 
+#include "JTAutoReplayProfiling.h"
+#include "InputSerializer/JTInputBinaryFormat.h"
+#include "InputSerializer/JTInputJsonTypes.h"
+#include "InputSerializer/JTInputSessionStreamWriter.h"
+
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
 #include "JsonObjectConverter.h"
 #include "Misc/DateTime.h"
 #include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
 
 static const FString DefaultInputRecordingSessionPrefix = "IRS";
 static const FString JsonFileExtension = "json";
+static const FString BinaryFileExtension = "jtirs";
 
 DEFINE_LOG_CATEGORY(LogJTInputSerializer);
 
+namespace
+{
+	void ExpandSessionToJsonSession(const FJTInputRecordingSession& InSession, FJTInputJsonRecordingSession& OutJsonSession)
+	{
+		const FJTInputTimeline& Timeline = InSession.InputTimeline;
+
+		OutJsonSession.InputTimeline.Reserve(Timeline.Num());
+		for (int32 FrameIndex = 0; FrameIndex < Timeline.Num(); ++FrameIndex)
+		{
+			FJTInputJsonTimelineFrame& JsonFrame = OutJsonSession.InputTimeline.AddDefaulted_GetRef();
+			JsonFrame.FrameDelta = Timeline[FrameIndex].FrameDelta;
+
+			const TArrayView<const FJTInputTimelineEvent> FrameEvents = Timeline.GetFrameEvents(FrameIndex);
+			JsonFrame.FrameEvents.Reserve(FrameEvents.Num());
+			for (const FJTInputTimelineEvent& TimelineEvent : FrameEvents)
+			{
+				FJTInputJsonTimelineEvent& JsonEvent = JsonFrame.FrameEvents.AddDefaulted_GetRef();
+				JsonEvent.EventType = TimelineEvent.EventType;
+
+				if (TimelineEvent.EventType == EJTInputEventType::Key)
+				{
+					JsonEvent.KeyEventArgs = Timeline.GetKeyEventArgs(TimelineEvent);
+				}
+				else if (TimelineEvent.EventType == EJTInputEventType::Axis)
+				{
+					JsonEvent.AxisEventArgs = Timeline.GetAxisEventArgs(TimelineEvent);
+				}
+			}
+		}
+
+		const FJTSpatialCheckpointTrack& Checkpoints = InSession.SpatialCheckpoints;
+		OutJsonSession.SpatialCheckpoints.Reserve(Checkpoints.Num());
+		for (int32 CheckpointIndex = 0; CheckpointIndex < Checkpoints.Num(); ++CheckpointIndex)
+		{
+			FJTInputJsonSpatialCheckpoint& JsonCheckpoint = OutJsonSession.SpatialCheckpoints.AddDefaulted_GetRef();
+			JsonCheckpoint.FrameDelta = Checkpoints[CheckpointIndex].FrameDelta;
+			const TArrayView<const FJTPlayerSpatialData> Players = Checkpoints.GetPlayers(CheckpointIndex);
+			JsonCheckpoint.PlayersSpatialDataCollection.Append(Players.GetData(), Players.Num());
+		}
+
+		const FJTDeltaTimeTrack& DeltaTimes = InSession.DeltaTimes;
+		OutJsonSession.FirstDeltaTimeFrame = DeltaTimes.GetFirstFrameDelta();
+		OutJsonSession.DeltaTimes.Reserve(DeltaTimes.Num());
+		for (FJTFrameDelta FrameDelta = DeltaTimes.GetFirstFrameDelta(); FrameDelta < DeltaTimes.GetEndFrameDelta(); ++FrameDelta)
+		{
+			OutJsonSession.DeltaTimes.Add(DeltaTimes.GetDeltaSeconds(FrameDelta));
+		}
+
+		OutJsonSession.PlayersSpatialDataCollection = InSession.PlayersSpatialDataCollection;
+		OutJsonSession.bHasRandomSeeds = InSession.bHasRandomSeeds;
+		OutJsonSession.RandomSeed = InSession.RandomSeed;
+		OutJsonSession.RandomStreamSeeds = InSession.RandomStreamSeeds;
+		OutJsonSession.StartTime = InSession.StartTime;
+		OutJsonSession.StopTime = InSession.StopTime;
+		OutJsonSession.StartFrameCounter = InSession.StartFrameCounter;
+		OutJsonSession.StopFrameCounter = InSession.StopFrameCounter;
+		OutJsonSession.RecordingFormatVersion = InSession.RecordingFormatVersion;
+	}
+
+	void CollapseJsonSessionToSession(const FJTInputJsonRecordingSession& InJsonSession, FJTInputRecordingSession& OutSession)
+	{
+		for (const FJTInputJsonTimelineFrame& JsonFrame : InJsonSession.InputTimeline)
+		{
+			for (const FJTInputJsonTimelineEvent& JsonEvent : JsonFrame.FrameEvents)
+			{
+				if (JsonEvent.EventType == EJTInputEventType::Key)
+				{
+					OutSession.InputTimeline.AddKeyEvent(JsonFrame.FrameDelta, JsonEvent.KeyEventArgs);
+				}
+				else if (JsonEvent.EventType == EJTInputEventType::Axis)
+				{
+					OutSession.InputTimeline.AddAxisEvent(JsonFrame.FrameDelta, JsonEvent.AxisEventArgs);
+				}
+			}
+		}
+
+		for (const FJTInputJsonSpatialCheckpoint& JsonCheckpoint : InJsonSession.SpatialCheckpoints)
+		{
+			OutSession.SpatialCheckpoints.AddCheckpoint(JsonCheckpoint.FrameDelta, JsonCheckpoint.PlayersSpatialDataCollection);
+		}
+
+		OutSession.DeltaTimes.Reserve(InJsonSession.DeltaTimes.Num());
+		for (int32 FrameIndex = 0; FrameIndex < InJsonSession.DeltaTimes.Num(); ++FrameIndex)
+		{
+			OutSession.DeltaTimes.AddFrame((InJsonSession.FirstDeltaTimeFrame + FrameIndex), InJsonSession.DeltaTimes[FrameIndex]);
+		}
+
+		OutSession.PlayersSpatialDataCollection = InJsonSession.PlayersSpatialDataCollection;
+		OutSession.bHasRandomSeeds = InJsonSession.bHasRandomSeeds;
+		OutSession.RandomSeed = InJsonSession.RandomSeed;
+		OutSession.RandomStreamSeeds = InJsonSession.RandomStreamSeeds;
+		OutSession.StartTime = InJsonSession.StartTime;
+		OutSession.StopTime = InJsonSession.StopTime;
+		OutSession.StartFrameCounter = InJsonSession.StartFrameCounter;
+		OutSession.StopFrameCounter = InJsonSession.StopFrameCounter;
+		OutSession.RecordingFormatVersion = InJsonSession.RecordingFormatVersion;
+	}
+} // namespace
+
+bool FJTInputSerializer::ExportSession(const FFilePath& InFilePath, const FJTInputRecordingSession& InSession)
+{
+	if (GetFileFormatForPath(InFilePath) == EJTInputRecordingFileFormat::Binary)
+	{
+		return ExportSessionToBinary(InFilePath, InSession);
+	}
+
+	return ExportSessionToJson(InFilePath, InSession);
+}
+
+bool FJTInputSerializer::ExportSessionWithDefaultPath(const FJTInputRecordingSession& InSession)
+{
+	return ExportSession(MakeDefaultFilePath(), InSession);
+}
+
+TFuture<FJTInputSessionExportResult> FJTInputSerializer::ExportSessionAsync(const FFilePath& InFilePath, FJTInputRecordingSession&& InSession)
+{
+	// Resolve the path up front so that autogenerated names are stamped with the time the export was requested
+	const FFilePath FilePath = (InFilePath.FilePath.IsEmpty() ? MakeDefaultFilePath() : InFilePath);
+
+	FFilePath FinalPath;
+	TryResolveFilePath(FilePath, FinalPath);
+
+	return Async(EAsyncExecution::ThreadPool, [FilePath, FinalPath, Session = MoveTemp(InSession)]()
+		{
+			FJTInputSessionExportResult Result;
+			Result.bSuccess = ExportSession(FilePath, Session);
+			Result.FilePath = FinalPath.FilePath;
+
+			return Result;
+		});
+}
+
+bool FJTInputSerializer::ImportSession(const FFilePath& InFilePath, FJTInputRecordingSession& OutSession, TArray<FString>* OutSegmentFilePaths)
+{
+	if (OutSegmentFilePaths)
+	{
+		OutSegmentFilePaths->Reset();
+	}
+
+	if (GetFileFormatForPath(InFilePath) == EJTInputRecordingFileFormat::Binary)
+	{
+		return ImportSessionFromBinary(InFilePath, OutSession, OutSegmentFilePaths);
+	}
+
+	return ImportSessionFromJson(InFilePath, OutSession);
+}
+
+TFuture<TSharedPtr<FJTInputRecordingSession>> FJTInputSerializer::ImportSessionAsync(const FFilePath& InFilePath)
+{
+	return Async(EAsyncExecution::ThreadPool, [InFilePath]() -> TSharedPtr<FJTInputRecordingSession>
+		{
+			TSharedPtr<FJTInputRecordingSession> Session = MakeShared<FJTInputRecordingSession>();
+			if (!ImportSession(InFilePath, *Session))
+			{
+				return nullptr;
+			}
+
+			return Session;
+		});
+}
+
 bool FJTInputSerializer::ExportSessionToJson(const FFilePath& InJsonFilePath, const FJTInputRecordingSession& InSession)
 {
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputSerializer_ExportSessionToJson);
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	FJTInputJsonRecordingSession JsonSession;
+	ExpandSessionToJsonSession(InSession, JsonSession);
+
 	FString SessionJsonString;
-	FJsonObjectConverter::UStructToJsonObjectString<FJTInputRecordingSession>(InSession, SessionJsonString);
+	FJsonObjectConverter::UStructToJsonObjectString<FJTInputJsonRecordingSession>(JsonSession, SessionJsonString);
 
 	FFilePath FinalPath;
-	const bool bConstructedFinalPath = TryConstructFinalPath(InJsonFilePath, FinalPath);
+	const bool bConstructedFinalPath = TryConstructFinalPath(InJsonFilePath, JsonFileExtension, FinalPath);
 	if (!bConstructedFinalPath)
 	{
 		UE_LOG(LogJTInputSerializer, Error, TEXT("Could not export session to Json. Unable to construct final path"));
@@ -36,18 +213,16 @@ bool FJTInputSerializer::ExportSessionToJson(const FFilePath& InJsonFilePath, co
 
 bool FJTInputSerializer::ExportSessionToJsonWithDefaultPath(const FJTInputRecordingSession& InSession)
 {
-	FFilePath DefaultPath;
-	DefaultPath.FilePath =
-		(UJTAutoReplaySettings::GetSettings()->RecordingSessionExportDirectory
-			+ DefaultInputRecordingSessionPrefix + FDateTime::Now().ToString());
-
-	return ExportSessionToJson(DefaultPath, InSession);
+	return ExportSessionToJson(MakeDefaultFilePath(), InSession);
 }
 
 bool FJTInputSerializer::ImportSessionFromJson(const FFilePath& InJsonFilePath, FJTInputRecordingSession& OutSession)
 {
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputSerializer_ImportSessionFromJson);
+	JT_AUTOREPLAY_LLM_SCOPE();
+
 	FFilePath FinalPath;
-	const bool bConstructedFinalPath = TryConstructFinalPath(InJsonFilePath, FinalPath);
+	const bool bConstructedFinalPath = TryConstructFinalPath(InJsonFilePath, JsonFileExtension, FinalPath);
 	if (!bConstructedFinalPath)
 	{
 		UE_LOG(LogJTInputSerializer, Error, TEXT("Could not import session from Json. Unable to construct final path"));
@@ -62,24 +237,221 @@ bool FJTInputSerializer::ImportSessionFromJson(const FFilePath& InJsonFilePath,
 		return false;
 	}
 
+	FJTInputJsonRecordingSession JsonSession;
+	FJsonObjectConverter::JsonObjectStringToUStruct<FJTInputJsonRecordingSession>(SessionJsonString, &JsonSession);
+
+	OutSession.ClearSessionData();
+	CollapseJsonSessionToSession(JsonSession, OutSession);
+
+	return true;
+}
+
+bool FJTInputSerializer::ExportSessionToBinary(const FFilePath& InBinaryFilePath, const FJTInputRecordingSession& InSession)
+{
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputSerializer_ExportSessionToBinary);
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	FFilePath FinalPath;
+	const bool bConstructedFinalPath = TryConstructFinalPath(InBinaryFilePath, BinaryFileExtension, FinalPath);
+	if (!bConstructedFinalPath)
+	{
+		UE_LOG(LogJTInputSerializer, Error, TEXT("Could not export session to binary. Unable to construct final path"));
+		return false;
+	}
+
+	TArray<uint8> SessionBytes;
+	FMemoryWriter SessionWriter(SessionBytes);
+	JT::AutoReplay::BinaryFormat::WriteSession(SessionWriter, InSession);
+
+	const bool bSavedBytesToFile = FFileHelper::SaveArrayToFile(SessionBytes, *FinalPath.FilePath);
+	if (!bSavedBytesToFile)
+	{
+		UE_LOG(LogJTInputSerializer, Error, TEXT("Could not export session to binary. Unable to save bytes to file"));
+		return false;
+	}
+
+	return true;
+}
+
+bool FJTInputSerializer::ImportSessionFromBinary(const FFilePath& InBinaryFilePath, FJTInputRecordingSession& OutSession, TArray<FString>* OutSegmentFilePaths)
+{
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputSerializer_ImportSessionFromBinary);
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	FFilePath FinalPath;
+	const bool bConstructedFinalPath = TryConstructFinalPath(InBinaryFilePath, BinaryFileExtension, FinalPath);
+	if (!bConstructedFinalPath)
+	{
+		UE_LOG(LogJTInputSerializer, Error, TEXT("Could not import session from binary. Unable to construct final path"));
+		return false;
+	}
+
+	bool bWasComplete = false;
+	return ReadBinarySegments(FinalPath.FilePath, false, OutSession, bWasComplete, OutSegmentFilePaths);
+}
+
+bool FJTInputSerializer::RecoverSessionFromBinary(const FFilePath& InBinaryFilePath, FJTInputRecordingSession& OutSession, bool& bOutWasComplete)
+{
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputSerializer_RecoverSessionFromBinary);
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	FFilePath FinalPath;
+	const bool bConstructedFinalPath = TryConstructFinalPath(InBinaryFilePath, BinaryFileExtension, FinalPath);
+	if (!bConstructedFinalPath)
+	{
+		UE_LOG(LogJTInputSerializer, Error, TEXT("Could not recover session from binary. Unable to construct final path"));
+		return false;
+	}
+
+	if (!ReadBinarySegments(FinalPath.FilePath, true, OutSession, bOutWasComplete))
+	{
+		return false;
+	}
+
+	// The stop data is only written when recording stops, so it's lost if the game crashed. End the session on its last frame
+	if (OutSession.StopFrameCounter == 0)
+	{
+		const FJTFrameDelta LastFrameDelta = (OutSession.InputTimeline.IsEmpty() ? 0 : OutSession.InputTimeline.Last().FrameDelta);
+		OutSession.StopFrameCounter = (OutSession.StartFrameCounter + LastFrameDelta + 1);
+		OutSession.StopTime = IFileManager::Get().GetTimeStamp(*FinalPath.FilePath).ToString();
+	}
+
+	return true;
+}
+
+bool FJTInputSerializer::ReadBinarySegments(const FString& InFirstSegmentPath, bool bShouldRecover, FJTInputRecordingSession& OutSession, bool& bOutWasComplete,
+	TArray<FString>* OutSegmentFilePaths)
+{
 	OutSession.ClearSessionData();
-	FJsonObjectConverter::JsonObjectStringToUStruct<FJTInputRecordingSession>(SessionJsonString, &OutSession);
+	bOutWasComplete = true;
+
+	if (OutSegmentFilePaths)
+	{
+		OutSegmentFilePaths->Reset();
+	}
+
+	// Streamed sessions may be split into a linked set of segment files. Follow the links until the last segment
+	TSet<FString> VisitedSegmentPaths;
+	FString SegmentPath = InFirstSegmentPath;
+	while (!SegmentPath.IsEmpty())
+	{
+		bool bAlreadyVisitedSegment = false;
+		VisitedSegmentPaths.Add(SegmentPath, &bAlreadyVisitedSegment);
+		if (bAlreadyVisitedSegment)
+		{
+			OutSession.ClearSessionData();
+			UE_LOG(LogJTInputSerializer, Error, TEXT("Could not import session from binary. %s links back to itself"), *SegmentPath);
+			return false;
+		}
+
+		TArray<uint8> SegmentBytes;
+		const bool bLoadedFileToBytes = FFileHelper::LoadFileToArray(SegmentBytes, *SegmentPath);
+		if (!bLoadedFileToBytes)
+		{
+			OutSession.ClearSessionData();
+			UE_LOG(LogJTInputSerializer, Error, TEXT("Could not import session from binary. Unable to load %s to bytes"), *SegmentPath);
+			return false;
+		}
+
+		FString NextSegmentFileName;
+		FMemoryReader SegmentReader(SegmentBytes);
+
+		bool bReadSegment = false;
+		if (bShouldRecover)
+		{
+			bool bIsSegmentComplete = false;
+			bReadSegment = JT::AutoReplay::BinaryFormat::RecoverSession(SegmentReader, OutSession, NextSegmentFileName, bIsSegmentComplete);
+
+			if (bReadSegment && !bIsSegmentComplete)
+			{
+				UE_LOG(LogJTInputSerializer, Warning, TEXT("%s was cut off. Recovered it up to its last commit"), *SegmentPath);
+				bOutWasComplete = false;
+			}
+		}
+		else
+		{
+			bReadSegment = JT::AutoReplay::BinaryFormat::ReadSession(SegmentReader, OutSession, NextSegmentFileName);
+		}
+
+		if (!bReadSegment)
+		{
+			OutSession.ClearSessionData();
+			UE_LOG(LogJTInputSerializer, Error, TEXT("Could not import session from binary. %s is malformed"), *SegmentPath);
+			return false;
+		}
+
+		if (OutSegmentFilePaths)
+		{
+			OutSegmentFilePaths->Add(SegmentPath);
+		}
+
+		SegmentPath = (NextSegmentFileName.IsEmpty() ? FString() : (FPaths::GetPath(SegmentPath) / NextSegmentFileName));
+	}
 
 	return true;
 }
 
-bool FJTInputSerializer::TryConstructFinalPath(const FFilePath& InJsonFilePath, FFilePath& OutFinalPath)
+TUniquePtr<FJTInputSessionStreamWriter> FJTInputSerializer::CreateSessionStreamWriter(
+	const FFilePath& InBinaryFilePath,
+	const FJTInputSessionStreamParams& InStreamParams)
+{
+	FFilePath FinalPath;
+	const bool bConstructedFinalPath
+		= TryConstructFinalPath(InBinaryFilePath.FilePath.IsEmpty() ? MakeDefaultFilePath() : InBinaryFilePath, BinaryFileExtension, FinalPath);
+	if (!bConstructedFinalPath)
+	{
+		UE_LOG(LogJTInputSerializer, Error, TEXT("Could not create session stream writer. Unable to construct final path"));
+		return nullptr;
+	}
+
+	return MakeUnique<FJTInputSessionStreamWriter>(FinalPath, InStreamParams);
+}
+
+bool FJTInputSerializer::TryResolveFilePath(const FFilePath& InFilePath, FFilePath& OutFinalPath)
+{
+	return TryConstructFinalPath(InFilePath, GetFileExtensionForFormat(GetFileFormatForPath(InFilePath)), OutFinalPath);
+}
+
+EJTInputRecordingFileFormat FJTInputSerializer::GetFileFormatForPath(const FFilePath& InFilePath)
+{
+	const FString Extension = FPaths::GetExtension(InFilePath.FilePath);
+	if (Extension == BinaryFileExtension)
+	{
+		return EJTInputRecordingFileFormat::Binary;
+	}
+	else if (Extension == JsonFileExtension)
+	{
+		return EJTInputRecordingFileFormat::Json;
+	}
+
+	return UJTAutoReplaySettings::GetSettings()->DefaultRecordingFileFormat;
+}
+
+const FString& FJTInputSerializer::GetFileExtensionForFormat(EJTInputRecordingFileFormat InFileFormat)
+{
+	return ((InFileFormat == EJTInputRecordingFileFormat::Binary) ? BinaryFileExtension : JsonFileExtension);
+}
+
+FFilePath FJTInputSerializer::MakeDefaultFilePath()
+{
+	FFilePath DefaultPath;
+	DefaultPath.FilePath = (DefaultInputRecordingSessionPrefix + FDateTime::Now().ToString());
+
+	return DefaultPath;
+}
+
+bool FJTInputSerializer::TryConstructFinalPath(const FFilePath& InFilePath, const FString& InFileExtension, FFilePath& OutFinalPath)
 {
-	if (InJsonFilePath.FilePath.IsEmpty())
+	if (InFilePath.FilePath.IsEmpty())
 	{
 		return false;
 	}
 
-	OutFinalPath.FilePath = (UJTAutoReplaySettings::GetSettings()->RecordingSessionExportDirectory + InJsonFilePath.FilePath);
+	OutFinalPath.FilePath = (UJTAutoReplaySettings::GetSettings()->RecordingSessionExportDirectory + InFilePath.FilePath);
 
-	if (FPaths::GetExtension(OutFinalPath.FilePath) != JsonFileExtension)
+	if (FPaths::GetExtension(OutFinalPath.FilePath) != InFileExtension)
 	{
-		OutFinalPath.FilePath += FString(".") + FString(JsonFileExtension);
+		OutFinalPath.FilePath += FString(".") + InFileExtension;
 	}
 
 	return true;
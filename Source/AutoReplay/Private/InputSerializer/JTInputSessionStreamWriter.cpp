@@ -0,0 +1,302 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "InputSerializer/JTInputSessionStreamWriter.h"
+
+#include "JTAutoReplayProfiling.h"
+#include "InputSerializer/JTInputBinaryFormat.h"
+#include "InputSerializer/JTInputSerializer.h"
+
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Crc.h"
+#include "Serialization/MemoryWriter.h"
+
+FJTInputSessionStreamWriter::FJTInputSessionStreamWriter(const FFilePath& InFilePath, const FJTInputSessionStreamParams& InStreamParams)
+	: FilePath(InFilePath)
+	, StreamParams(InStreamParams)
+	, WritePipe(TEXT("JTInputSessionStreamWriter"))
+{
+	if (StreamParams.bJournal)
+	{
+		UncommittedArchive = MakeUnique<FMemoryWriter>(UncommittedBytes);
+	}
+}
+
+FJTInputSessionStreamWriter::~FJTInputSessionStreamWriter()
+{
+	Flush();
+	CloseSegment_AnyThread();
+}
+
+void FJTInputSessionStreamWriter::BeginSession(const FJTInputRecordingSession& InSession)
+{
+	CurrentSegmentIndex = 0;
+	CurrentSegmentOpenTime = FPlatformTime::Seconds();
+	CurrentSegmentSize = 0;
+
+	// Only the start data is needed, so avoid copying any timeline frames over to the write task
+	FJTInputRecordingSession SessionStartData;
+	SessionStartData.StartTime = InSession.StartTime;
+	SessionStartData.StartFrameCounter = InSession.StartFrameCounter;
+	SessionStartData.PlayersSpatialDataCollection = InSession.PlayersSpatialDataCollection;
+	SessionStartData.bHasRandomSeeds = InSession.bHasRandomSeeds;
+	SessionStartData.RandomSeed = InSession.RandomSeed;
+	SessionStartData.RandomStreamSeeds = InSession.RandomStreamSeeds;
+
+	LastWriteTask = WritePipe.Launch(UE_SOURCE_LOCATION, [this, SegmentFilePath = FilePath.FilePath, SessionStartData = MoveTemp(SessionStartData)]()
+		{
+			OpenSegment_AnyThread(SegmentFilePath);
+			if (SegmentArchive)
+			{
+				// Committed right away, so that even a session that crashes before its first chunk can be recovered
+				JT::AutoReplay::BinaryFormat::WriteMetadataSection(GetSectionArchive_AnyThread(), SessionStartData);
+				Commit_AnyThread();
+				UpdateSegmentState_AnyThread();
+			}
+		});
+}
+
+void FJTInputSessionStreamWriter::AppendFrames(FJTInputTimeline&& InFrames)
+{
+	if (InFrames.IsEmpty())
+	{
+		if (StreamParams.TimelinePool)
+		{
+			StreamParams.TimelinePool->Release(MoveTemp(InFrames));
+		}
+
+		return;
+	}
+
+	RotateSegmentIfNeeded();
+
+	LastWriteTask = WritePipe.Launch(UE_SOURCE_LOCATION, [this, Frames = MoveTemp(InFrames)]() mutable
+		{
+			JT_AUTOREPLAY_TRACE_SCOPE(JTInputSessionStreamWriter_WriteFrames);
+			JT_AUTOREPLAY_LLM_SCOPE();
+
+			if (SegmentArchive)
+			{
+				using namespace JT::AutoReplay::BinaryFormat;
+				for (int32 FirstFrameIndex = 0; FirstFrameIndex < Frames.Num(); FirstFrameIndex += MaxFramesPerTimelineChunk)
+				{
+					const int32 NumFrames = FMath::Min(MaxFramesPerTimelineChunk, (Frames.Num() - FirstFrameIndex));
+					WriteTimelineChunkSection(GetSectionArchive_AnyThread(), Frames, FirstFrameIndex, NumFrames);
+				}
+
+				Commit_AnyThread();
+				UpdateSegmentState_AnyThread();
+			}
+
+			if (StreamParams.TimelinePool)
+			{
+				StreamParams.TimelinePool->Release(MoveTemp(Frames));
+			}
+		});
+}
+
+void FJTInputSessionStreamWriter::AppendSpatialCheckpoints(FJTSpatialCheckpointTrack&& InCheckpoints)
+{
+	if (InCheckpoints.IsEmpty())
+	{
+		return;
+	}
+
+	LastWriteTask = WritePipe.Launch(UE_SOURCE_LOCATION, [this, Checkpoints = MoveTemp(InCheckpoints)]()
+		{
+			JT_AUTOREPLAY_TRACE_SCOPE(JTInputSessionStreamWriter_WriteSpatialCheckpoints);
+			JT_AUTOREPLAY_LLM_SCOPE();
+
+			if (SegmentArchive)
+			{
+				using namespace JT::AutoReplay::BinaryFormat;
+				for (int32 FirstCheckpointIndex = 0; FirstCheckpointIndex < Checkpoints.Num(); FirstCheckpointIndex += MaxCheckpointsPerSection)
+				{
+					const int32 NumCheckpoints = FMath::Min(MaxCheckpointsPerSection, (Checkpoints.Num() - FirstCheckpointIndex));
+					WriteSpatialCheckpointsSection(GetSectionArchive_AnyThread(), Checkpoints, FirstCheckpointIndex, NumCheckpoints);
+				}
+
+				Commit_AnyThread();
+				UpdateSegmentState_AnyThread();
+			}
+		});
+}
+
+void FJTInputSessionStreamWriter::AppendDeltaTimes(FJTDeltaTimeTrack&& InDeltaTimes)
+{
+	if (InDeltaTimes.IsEmpty())
+	{
+		return;
+	}
+
+	LastWriteTask = WritePipe.Launch(UE_SOURCE_LOCATION, [this, DeltaTimes = MoveTemp(InDeltaTimes)]()
+		{
+			JT_AUTOREPLAY_TRACE_SCOPE(JTInputSessionStreamWriter_WriteDeltaTimes);
+			JT_AUTOREPLAY_LLM_SCOPE();
+
+			if (SegmentArchive)
+			{
+				using namespace JT::AutoReplay::BinaryFormat;
+				for (int32 FirstFrameIndex = 0; FirstFrameIndex < DeltaTimes.Num(); FirstFrameIndex += MaxFramesPerDeltaTimesSection)
+				{
+					const int32 NumFrames = FMath::Min(MaxFramesPerDeltaTimesSection, (DeltaTimes.Num() - FirstFrameIndex));
+					WriteDeltaTimesSection(GetSectionArchive_AnyThread(), DeltaTimes, (DeltaTimes.GetFirstFrameDelta() + FirstFrameIndex), NumFrames);
+				}
+
+				Commit_AnyThread();
+				UpdateSegmentState_AnyThread();
+			}
+		});
+}
+
+TFuture<FJTInputSessionExportResult> FJTInputSessionStreamWriter::EndSession(const FJTInputRecordingSession& InSession)
+{
+	FJTInputRecordingSession SessionStopData;
+	SessionStopData.StopTime = InSession.StopTime;
+	SessionStopData.StopFrameCounter = InSession.StopFrameCounter;
+
+	TSharedRef<TPromise<FJTInputSessionExportResult>> ExportPromise = MakeShared<TPromise<FJTInputSessionExportResult>>();
+	TFuture<FJTInputSessionExportResult> ExportFuture = ExportPromise->GetFuture();
+
+	LastWriteTask = WritePipe.Launch(UE_SOURCE_LOCATION, [this, SessionStopData = MoveTemp(SessionStopData), ExportPromise]()
+		{
+			if (SegmentArchive)
+			{
+				JT::AutoReplay::BinaryFormat::WriteStopInfoSection(GetSectionArchive_AnyThread(), SessionStopData);
+				JT::AutoReplay::BinaryFormat::WriteEndSection(GetSectionArchive_AnyThread());
+				Commit_AnyThread();
+				UpdateSegmentState_AnyThread();
+				CloseSegment_AnyThread();
+			}
+
+			FJTInputSessionExportResult Result;
+			Result.bSuccess = !bHasFailed;
+			Result.FilePath = FilePath.FilePath;
+			ExportPromise->SetValue(MoveTemp(Result));
+		});
+
+	return ExportFuture;
+}
+
+void FJTInputSessionStreamWriter::Flush()
+{
+	if (LastWriteTask.IsValid())
+	{
+		LastWriteTask.Wait();
+	}
+}
+
+void FJTInputSessionStreamWriter::RotateSegmentIfNeeded()
+{
+	const bool bExceededDuration = ((StreamParams.MaxSegmentDurationSeconds > 0.0)
+		&& ((FPlatformTime::Seconds() - CurrentSegmentOpenTime) >= StreamParams.MaxSegmentDurationSeconds));
+	const bool bExceededSize = ((StreamParams.MaxSegmentSizeBytes > 0)
+		&& (CurrentSegmentSize.load() >= StreamParams.MaxSegmentSizeBytes));
+
+	if (!bExceededDuration && !bExceededSize)
+	{
+		return;
+	}
+
+	++CurrentSegmentIndex;
+	CurrentSegmentOpenTime = FPlatformTime::Seconds();
+	CurrentSegmentSize = 0;
+
+	const FString NextSegmentFilePath = MakeSegmentFilePath(CurrentSegmentIndex);
+
+	UE_LOG(LogJTInputSerializer, Log, TEXT("Rotating streamed session to new segment %s"), *NextSegmentFilePath);
+
+	LastWriteTask = WritePipe.Launch(UE_SOURCE_LOCATION, [this, NextSegmentFilePath]()
+		{
+			if (!SegmentArchive)
+			{
+				return;
+			}
+
+			JT::AutoReplay::BinaryFormat::WriteNextSegmentSection(GetSectionArchive_AnyThread(), FPaths::GetCleanFilename(NextSegmentFilePath));
+			JT::AutoReplay::BinaryFormat::WriteEndSection(GetSectionArchive_AnyThread());
+			Commit_AnyThread();
+			CloseSegment_AnyThread();
+
+			OpenSegment_AnyThread(NextSegmentFilePath);
+		});
+}
+
+FString FJTInputSessionStreamWriter::MakeSegmentFilePath(int32 InSegmentIndex) const
+{
+	if (InSegmentIndex == 0)
+	{
+		return FilePath.FilePath;
+	}
+
+	return FString::Printf(TEXT("%s_%03d.%s"),
+		*FPaths::Combine(FPaths::GetPath(FilePath.FilePath), FPaths::GetBaseFilename(FilePath.FilePath)),
+		InSegmentIndex,
+		*FPaths::GetExtension(FilePath.FilePath));
+}
+
+void FJTInputSessionStreamWriter::OpenSegment_AnyThread(const FString& InSegmentFilePath)
+{
+	if (bHasFailed)
+	{
+		return;
+	}
+
+	SegmentArchive.Reset(IFileManager::Get().CreateFileWriter(*InSegmentFilePath));
+	if (!SegmentArchive)
+	{
+		UE_LOG(LogJTInputSerializer, Error, TEXT("Could not stream session. Unable to open %s for writing"), *InSegmentFilePath);
+		bHasFailed = true;
+		return;
+	}
+
+	JT::AutoReplay::BinaryFormat::WriteHeader(*SegmentArchive);
+	UpdateSegmentState_AnyThread();
+}
+
+void FJTInputSessionStreamWriter::CloseSegment_AnyThread()
+{
+	if (SegmentArchive)
+	{
+		SegmentArchive->Close();
+		SegmentArchive.Reset();
+	}
+}
+
+void FJTInputSessionStreamWriter::UpdateSegmentState_AnyThread()
+{
+	if (SegmentArchive->IsError())
+	{
+		UE_LOG(LogJTInputSerializer, Error, TEXT("Could not stream session. Failed writing to segment file"));
+		bHasFailed = true;
+		CloseSegment_AnyThread();
+		return;
+	}
+
+	CurrentSegmentSize = SegmentArchive->Tell();
+}
+
+FArchive& FJTInputSessionStreamWriter::GetSectionArchive_AnyThread()
+{
+	return (UncommittedArchive ? *UncommittedArchive : *SegmentArchive);
+}
+
+void FJTInputSessionStreamWriter::Commit_AnyThread()
+{
+	if (!UncommittedArchive || !SegmentArchive || UncommittedBytes.IsEmpty())
+	{
+		return;
+	}
+
+	JT_AUTOREPLAY_TRACE_SCOPE(JTInputSessionStreamWriter_Commit);
+
+	SegmentArchive->Serialize(UncommittedBytes.GetData(), UncommittedBytes.Num());
+	JT::AutoReplay::BinaryFormat::WriteCommitSection(*SegmentArchive, FCrc::MemCrc32(UncommittedBytes.GetData(), UncommittedBytes.Num()));
+
+	// Hands the bytes over to the OS, which is all that's needed for them to survive the game crashing
+	SegmentArchive->Flush();
+
+	// Keeps the staging buffer's allocation around for the next commit
+	UncommittedBytes.Reset();
+	UncommittedArchive->Seek(0);
+}
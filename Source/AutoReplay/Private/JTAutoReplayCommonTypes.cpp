@@ -0,0 +1,288 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "JTAutoReplayCommonTypes.h"
+
+#include "JTAutoReplayRandomStreamRegistry.h"
+
+#include "Algo/BinarySearch.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+std::atomic<uint64> FJTInputTimeline::NumAllocations = 0;
+
+FJTInputKeyIndex FJTInputTimeline::InternKey(const FKey& InKey)
+{
+	if (const FJTInputKeyIndex* ExistingKeyIndex = KeyIndices.Find(InKey.GetFName()))
+	{
+		return *ExistingKeyIndex;
+	}
+
+	checkf(Keys.Num() < MAX_uint16, TEXT("Input timeline key table is full"));
+
+	if (UNLIKELY(Keys.Num() == Keys.Max()))
+	{
+		Reserve(0, 0, FMath::Min(Keys.Max() + FMath::Max(MinKeyGrowth, Keys.Max()), static_cast<int32>(MAX_uint16)));
+	}
+
+	const FJTInputKeyIndex NewKeyIndex = static_cast<FJTInputKeyIndex>(Keys.Emplace(InKey));
+	KeyIndices.Emplace(InKey.GetFName(), NewKeyIndex);
+
+	return NewKeyIndex;
+}
+
+FJTInputKeyEventArgs FJTInputTimeline::GetKeyEventArgs(const FJTInputTimelineEvent& InTimelineEvent) const
+{
+	FJTInputKeyEventArgs KeyEventArgs;
+	KeyEventArgs.Key = GetKey(InTimelineEvent.KeyIndex);
+	KeyEventArgs.InputDevice = FInputDeviceId::CreateFromInternalId(InTimelineEvent.Payload.Key.InputDeviceId);
+	KeyEventArgs.ControllerId = InTimelineEvent.ControllerId;
+	KeyEventArgs.AmountDepressed = InTimelineEvent.Payload.Key.AmountDepressed;
+	KeyEventArgs.Event = InTimelineEvent.GetKeyEvent();
+	KeyEventArgs.bIsTouchEvent = InTimelineEvent.IsTouchEvent();
+
+	return KeyEventArgs;
+}
+
+FJTInputAxisEventArgs FJTInputTimeline::GetAxisEventArgs(const FJTInputTimelineEvent& InTimelineEvent) const
+{
+	return FJTInputAxisEventArgs(
+		GetKey(InTimelineEvent.KeyIndex),
+		InTimelineEvent.Payload.Axis.Delta,
+		InTimelineEvent.Payload.Axis.DeltaTime,
+		InTimelineEvent.ControllerId,
+		InTimelineEvent.Payload.Axis.NumSamples,
+		InTimelineEvent.IsGamepad());
+}
+
+void FJTInputTimeline::ExtractFramesBefore(FJTFrameDelta InFrameDelta, FJTInputTimeline& OutTimeline)
+{
+	check(OutTimeline.IsEmpty());
+
+	OutTimeline.Reserve(0, 0, Keys.Num());
+	OutTimeline.Keys.Append(Keys);
+
+	const int32 NumFramesToExtract = Algo::LowerBoundBy(Frames, InFrameDelta, &FJTInputTimelineFrame::FrameDelta);
+	if (NumFramesToExtract == 0)
+	{
+		return;
+	}
+
+	if (NumFramesToExtract == Frames.Num())
+	{
+		Swap(Frames, OutTimeline.Frames);
+		Swap(Events, OutTimeline.Events);
+		return;
+	}
+
+	// Copy the extracted prefix out, and rebase the remaining frames onto the start of the event array
+	const int32 NumEventsToExtract = Frames[NumFramesToExtract].FirstEventIndex;
+
+	OutTimeline.Reserve(NumFramesToExtract, NumEventsToExtract);
+	OutTimeline.Frames.Append(Frames.GetData(), NumFramesToExtract);
+	OutTimeline.Events.Append(Events.GetData(), NumEventsToExtract);
+
+	Frames.RemoveAt(0, NumFramesToExtract, false);
+	Events.RemoveAt(0, NumEventsToExtract, false);
+	for (FJTInputTimelineFrame& Frame : Frames)
+	{
+		Frame.FirstEventIndex -= NumEventsToExtract;
+	}
+}
+
+void FJTInputTimeline::Reserve(int32 InNumFrames, int32 InNumEvents, int32 InNumKeys)
+{
+	if (InNumFrames > Frames.Max())
+	{
+		Frames.Reserve(InNumFrames);
+		NumAllocations.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (InNumEvents > Events.Max())
+	{
+		Events.Reserve(InNumEvents);
+		NumAllocations.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (InNumKeys > Keys.Max())
+	{
+		Keys.Reserve(InNumKeys);
+		KeyIndices.Reserve(InNumKeys);
+		NumAllocations.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void FJTInputTimeline::GrowFrames()
+{
+	Reserve(Frames.Max() + FMath::Max(MinFrameGrowth, Frames.Max()), 0);
+}
+
+void FJTInputTimeline::GrowEvents()
+{
+	Reserve(0, Events.Max() + FMath::Max(MinEventGrowth, Events.Max()));
+}
+
+void FJTInputTimeline::Reset()
+{
+	Frames.Reset();
+	Events.Reset();
+	Keys.Reset();
+	KeyIndices.Reset();
+}
+
+SIZE_T FJTInputTimeline::GetAllocatedSize() const
+{
+	return Frames.GetAllocatedSize()
+		+ Events.GetAllocatedSize()
+		+ Keys.GetAllocatedSize()
+		+ KeyIndices.GetAllocatedSize();
+}
+
+FJTInputTimelinePool::FJTInputTimelinePool(int32 InNumFramesPerTimeline, int32 InNumEventsPerTimeline)
+	: NumFramesPerTimeline(InNumFramesPerTimeline)
+	, NumEventsPerTimeline(InNumEventsPerTimeline)
+{
+	// Enough room for the timelines in flight between a producer and a consumer, so releasing never allocates
+	FreeTimelines.Reserve(8);
+}
+
+FJTInputTimeline FJTInputTimelinePool::Acquire()
+{
+	{
+		FScopeLock Lock(&FreeTimelinesCriticalSection);
+		if (!FreeTimelines.IsEmpty())
+		{
+			return FreeTimelines.Pop(false);
+		}
+	}
+
+	FJTInputTimeline NewTimeline;
+	NewTimeline.Reserve(NumFramesPerTimeline, NumEventsPerTimeline, FJTInputTimeline::MinKeyGrowth);
+
+	return NewTimeline;
+}
+
+void FJTInputTimelinePool::Release(FJTInputTimeline&& InTimeline)
+{
+	InTimeline.Reset();
+
+	FScopeLock Lock(&FreeTimelinesCriticalSection);
+	FreeTimelines.Emplace(MoveTemp(InTimeline));
+}
+
+void FJTInputTimelinePool::Prewarm(int32 InNumTimelines)
+{
+	FScopeLock Lock(&FreeTimelinesCriticalSection);
+
+	while (FreeTimelines.Num() < InNumTimelines)
+	{
+		FJTInputTimeline& NewTimeline = FreeTimelines.AddDefaulted_GetRef();
+		NewTimeline.Reserve(NumFramesPerTimeline, NumEventsPerTimeline, FJTInputTimeline::MinKeyGrowth);
+	}
+}
+
+SIZE_T FJTInputTimelinePool::GetAllocatedSize() const
+{
+	FScopeLock Lock(&FreeTimelinesCriticalSection);
+
+	SIZE_T AllocatedSize = FreeTimelines.GetAllocatedSize();
+	for (const FJTInputTimeline& FreeTimeline : FreeTimelines)
+	{
+		AllocatedSize += FreeTimeline.GetAllocatedSize();
+	}
+
+	return AllocatedSize;
+}
+
+SIZE_T FJTAutoReplayMemoryReport::GetTotal() const
+{
+	SIZE_T Total = 0;
+	for (const FEntry& Entry : Entries)
+	{
+		Total += Entry.Bytes;
+	}
+
+	return Total;
+}
+
+void FJTAutoReplayMemoryReport::Print(FOutputDevice& InOutputDevice, const TCHAR* InTitle) const
+{
+	InOutputDevice.Logf(TEXT("%s: %.2f KB"), InTitle, (GetTotal() / 1024.0));
+	for (const FEntry& Entry : Entries)
+	{
+		InOutputDevice.Logf(TEXT("    %-40s %10.2f KB"), *Entry.Name, (Entry.Bytes / 1024.0));
+	}
+}
+
+int32 FJTSpatialCheckpointTrack::FindCheckpointIndex(FJTFrameDelta InFrameDelta) const
+{
+	return (Algo::UpperBoundBy(Checkpoints, InFrameDelta, &FJTSpatialCheckpoint::FrameDelta) - 1);
+}
+
+void FJTSpatialCheckpointTrack::Reserve(int32 InNumCheckpoints, int32 InNumPlayers)
+{
+	Checkpoints.Reserve(InNumCheckpoints);
+	Players.Reserve(InNumPlayers);
+}
+
+void FJTSpatialCheckpointTrack::Reset()
+{
+	Checkpoints.Reset();
+	Players.Reset();
+}
+
+SIZE_T FJTSpatialCheckpointTrack::GetAllocatedSize() const
+{
+	return (Checkpoints.GetAllocatedSize() + Players.GetAllocatedSize());
+}
+
+void FJTDeltaTimeTrack::Reserve(int32 InNumFrames)
+{
+	DeltaSeconds.Reserve(InNumFrames);
+}
+
+void FJTDeltaTimeTrack::Reset()
+{
+	FirstFrameDelta = 0;
+	DeltaSeconds.Reset();
+}
+
+SIZE_T FJTDeltaTimeTrack::GetAllocatedSize() const
+{
+	return DeltaSeconds.GetAllocatedSize();
+}
+
+void FJTInputRecordingSession::AppendMemoryReport(const FString& InPrefix, FJTAutoReplayMemoryReport& OutReport) const
+{
+	OutReport.Add(InPrefix + TEXT("Timeline"), InputTimeline.GetAllocatedSize());
+	OutReport.Add(InPrefix + TEXT("Spatial Checkpoints"), SpatialCheckpoints.GetAllocatedSize());
+	OutReport.Add(InPrefix + TEXT("Delta Times"), DeltaTimes.GetAllocatedSize());
+	OutReport.Add(InPrefix + TEXT("Spatial Data"), PlayersSpatialDataCollection.GetAllocatedSize());
+	OutReport.Add(InPrefix + TEXT("Random Seeds"), RandomStreamSeeds.GetAllocatedSize());
+	OutReport.Add(InPrefix + TEXT("Strings"), (StartTime.GetAllocatedSize() + StopTime.GetAllocatedSize()));
+}
+
+void FJTInputRecordingSession::CaptureRandomSeeds()
+{
+	// The state of rand() can't be read back, so the global generators are reseeded with a seed of our own instead
+	RandomSeed = static_cast<int32>(FPlatformTime::Cycles());
+	FMath::RandInit(RandomSeed);
+	FMath::SRandInit(RandomSeed);
+
+	RandomStreamSeeds.Reset();
+	FJTRandomStreamRegistry::Get().CaptureSeeds(RandomStreamSeeds);
+
+	bHasRandomSeeds = true;
+}
+
+int32 FJTInputRecordingSession::RestoreRandomSeeds() const
+{
+	if (!bHasRandomSeeds)
+	{
+		return INDEX_NONE;
+	}
+
+	FMath::RandInit(RandomSeed);
+	FMath::SRandInit(RandomSeed);
+
+	return FJTRandomStreamRegistry::Get().RestoreSeeds(RandomStreamSeeds);
+}
@@ -2,9 +2,13 @@
 
 #include "JTAutoReplayConsoleMenu.h"
 
+#include "BatchRunner/JTInputBatchRunner.h"
+#include "InputPlayer/JTInputPerfCapture.h"
 #include "InputPlayer/JTInputPlayer.h"
+#include "InputPlayer/JTInputSessionCache.h"
 #include "InputRecorder/JTInputRecorder.h"
 #include "InputSerializer/JTInputSerializer.h"
+#include "PerfComparator/JTPerfComparator.h"
 
 #include "CoreMinimal.h"
 #include "Engine/World.h"
@@ -21,7 +25,11 @@ namespace JT
 				TEXT("[session filename to play]\n")
 				TEXT("[OPTIONAL: [1/0] - whether to restore player spatial data at start (default 1)]\n")
 				TEXT("[OPTIONAL: [0-inf] - time delay (in seconds) before starting (default 0)]\n")
-				TEXT("[OPTIONAL: [1-inf] - number of times to play (default 1. Negative values mean loop infinitely)"),
+				TEXT("[OPTIONAL: [1-inf] - number of times to play (default 1. Negative values mean loop infinitely)]\n")
+				TEXT("[OPTIONAL: [0-inf] - the frame of the recording to start playing from (default 0)]\n")
+				TEXT("[OPTIONAL: [0/1/2] - how to inject input: 0 = automatic, 1 = through the viewport, 2 = straight into the player controllers (default 0)]\n")
+				TEXT("[OPTIONAL: [0/1/2] - how to step time: 0 = variable, 1 = recorded delta times, 2 = fixed 60Hz (default 0)]\n")
+				TEXT("[OPTIONAL: [1/0] - whether to play in turbo, i.e. as fast as possible with world rendering off (default 0)]"),
 				FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InParams, UWorld* InWorld)
 					{
 						if (InParams.IsEmpty())
@@ -54,6 +62,22 @@ namespace JT
 							{
 								InputPlayerRequestParams.NumTimesToPlay = FCString::Atoi(*CurrentString);
 							}
+							else if (Index == 4)
+							{
+								InputPlayerRequestParams.StartFrame = FCString::Atoi(*CurrentString);
+							}
+							else if (Index == 5)
+							{
+								InputPlayerRequestParams.InjectionMode = static_cast<EJTInputInjectionMode>(FMath::Clamp(FCString::Atoi(*CurrentString), 0, 2));
+							}
+							else if (Index == 6)
+							{
+								InputPlayerRequestParams.TimeStep = static_cast<EJTInputPlaybackTimeStep>(FMath::Clamp(FCString::Atoi(*CurrentString), 0, 2));
+							}
+							else if (Index == 7)
+							{
+								InputPlayerRequestParams.bTurbo = static_cast<bool>(FCString::Atoi(*CurrentString));
+							}
 						}
 
 						UJTInputPlayer* InputPlayer = InWorld->GetSubsystem<UJTInputPlayer>();
@@ -84,10 +108,60 @@ namespace JT
 						InputPlayer->StopPlaying();
 					}));
 
+			FAutoConsoleCommandWithWorldAndArgs CCommandSeekToFrame(
+				TEXT("jt.autoreplay.inputplayer.seek"),
+				TEXT("Jump the current play session to a given frame of the recording. Args:\n")
+				TEXT("[frame to seek to (relative to the start of the recording). Prefix with + or - to seek relative to the current frame]"),
+				FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InParams, UWorld* InWorld)
+					{
+						if (InParams.IsEmpty())
+						{
+							return;
+						}
+
+						if (!IsValid(InWorld))
+						{
+							return;
+						}
+
+						UJTInputPlayer* InputPlayer = InWorld->GetSubsystem<UJTInputPlayer>();
+						if (!IsValid(InputPlayer))
+						{
+							return;
+						}
+
+						const FString& FrameString = InParams[0];
+						int32 Frame = FCString::Atoi(*FrameString);
+						if (FrameString.StartsWith(TEXT("+")) || FrameString.StartsWith(TEXT("-")))
+						{
+							Frame += InputPlayer->GetCurrentFrame();
+						}
+
+						InputPlayer->SeekToFrame(Frame);
+					}));
+
+			FAutoConsoleCommand CCommandClearSessionCache(
+				TEXT("jt.autoreplay.inputplayer.clearsessioncache"),
+				TEXT("Clears all decoded sessions from the session cache shared by all input players"),
+				FConsoleCommandDelegate::CreateLambda([]()
+					{
+						FJTInputSessionCache::Get().Empty();
+					}));
+
 			TAutoConsoleVariable<bool> CVarShowPlayStatus(
 				TEXT("jt.autoreplay.inputplayer.showplaystatus"),
 				true,
 				TEXT("Shows the current play status for the input player"));
+
+			TAutoConsoleVariable<bool> CVarCapturePerformance(
+				TEXT("jt.autoreplay.inputplayer.captureperf"),
+				false,
+				TEXT("Captures the per-frame performance of every play session, as if bCapturePerformance was set on every play request"));
+
+			TAutoConsoleVariable<bool> CVarTurbo(
+				TEXT("jt.autoreplay.inputplayer.turbo"),
+				false,
+				TEXT("Plays every session as fast as possible with world rendering off, as if bTurbo was set on every play request"));
 		} // Input Player
 
 		namespace InputRecorder
@@ -97,7 +171,10 @@ namespace JT
 				TEXT("Request the input recorder to start a new recording session. Args: \n")
 				TEXT("[OPTIONAL: name of recording file (will be autogenerated by default)] \n")
 				TEXT("[OPTIONAL: [0-inf] - time delay (in seconds) before starting (default 0)] \n")
-				TEXT("[OPTIONAL: [1/0] - whether to record input when game is paused (default 0)]"),
+				TEXT("[OPTIONAL: [1/0] - whether to record input when game is paused (default 0)] \n")
+				TEXT("[OPTIONAL: [1/0] - whether to stream the recording to disk while recording (default 0)] \n")
+				TEXT("[OPTIONAL: [0-inf] - when streaming, start a new segment file every N minutes (default 0 = never)] \n")
+				TEXT("[OPTIONAL: [0-inf] - when streaming, start a new segment file every N megabytes (default 0 = never)]"),
 				FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InParams, UWorld* InWorld)
 					{
 						if (!IsValid(InWorld))
@@ -121,6 +198,18 @@ namespace JT
 							{
 								InputRecorderRequestParams.bRecordInputWhenGamePaused = static_cast<bool>(FCString::Atoi(*CurrentString));
 							}
+							else if (Index == 3)
+							{
+								InputRecorderRequestParams.bStreamToDisk = static_cast<bool>(FCString::Atoi(*CurrentString));
+							}
+							else if (Index == 4)
+							{
+								InputRecorderRequestParams.MaxSegmentDurationMinutes = FCString::Atof(*CurrentString);
+							}
+							else if (Index == 5)
+							{
+								InputRecorderRequestParams.MaxSegmentSizeMegabytes = FCString::Atof(*CurrentString);
+							}
 						}
 
 						UGameInstance* GameInstance = InWorld->GetGameInstance();
@@ -163,10 +252,340 @@ namespace JT
 						InputRecorder->StopRecording();
 					}));
 
+			FAutoConsoleCommandWithWorldAndArgs CCommandLogAllocations(
+				TEXT("jt.autoreplay.inputrecorder.logallocations"),
+				TEXT("Logs the number of events recorded and timeline allocations made by the current (or last) recording session"),
+				FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InParams, UWorld* InWorld)
+					{
+						if (!IsValid(InWorld))
+						{
+							return;
+						}
+
+						UGameInstance* GameInstance = InWorld->GetGameInstance();
+						if (!IsValid(GameInstance))
+						{
+							return;
+						}
+
+						UJTInputRecorder* InputRecorder = GameInstance->GetSubsystem<UJTInputRecorder>();
+						if (!IsValid(InputRecorder))
+						{
+							return;
+						}
+
+						UE_LOG(LogJTInputRecorder, Display, TEXT("Recorded %llu input events with %llu timeline allocations (%llu since startup)"),
+							InputRecorder->GetNumRecordedEvents(), InputRecorder->GetNumTimelineAllocations(), FJTInputTimeline::GetNumAllocations());
+					}));
+
+			FAutoConsoleCommandWithWorldAndArgs CCommandStartFlightRecorder(
+				TEXT("jt.autoreplay.inputrecorder.startflightrecorder"),
+				TEXT("Start keeping a rolling window of the most recent input, that can be dumped as a playable session. Args: \n")
+				TEXT("[OPTIONAL: [1-inf] - the length of the window (in seconds) (default 60)] \n")
+				TEXT("[OPTIONAL: [1-inf] - the maximum number of events held in the window (default 65536)]"),
+				FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InParams, UWorld* InWorld)
+					{
+						if (!IsValid(InWorld))
+						{
+							return;
+						}
+
+						FJTInputFlightRecorderParams FlightRecorderParams;
+						for (int32 Index = 0; Index < InParams.Num(); ++Index)
+						{
+							const FString& CurrentString = InParams[Index];
+							if (Index == 0)
+							{
+								FlightRecorderParams.WindowSeconds = FCString::Atof(*CurrentString);
+							}
+							else if (Index == 1)
+							{
+								FlightRecorderParams.MaxEvents = FCString::Atoi(*CurrentString);
+							}
+						}
+
+						UGameInstance* GameInstance = InWorld->GetGameInstance();
+						if (!IsValid(GameInstance))
+						{
+							return;
+						}
+
+						UJTInputRecorder* InputRecorder = GameInstance->GetSubsystem<UJTInputRecorder>();
+						if (!IsValid(InputRecorder))
+						{
+							return;
+						}
+
+						InputRecorder->StartFlightRecorder(FlightRecorderParams);
+					}));
+
+			FAutoConsoleCommandWithWorldAndArgs CCommandStopFlightRecorder(
+				TEXT("jt.autoreplay.inputrecorder.stopflightrecorder"),
+				TEXT("Stop the input recorder's flight recorder, dropping its window"),
+				FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InParams, UWorld* InWorld)
+					{
+						if (!IsValid(InWorld))
+						{
+							return;
+						}
+
+						UGameInstance* GameInstance = InWorld->GetGameInstance();
+						if (!IsValid(GameInstance))
+						{
+							return;
+						}
+
+						UJTInputRecorder* InputRecorder = GameInstance->GetSubsystem<UJTInputRecorder>();
+						if (!IsValid(InputRecorder))
+						{
+							return;
+						}
+
+						InputRecorder->StopFlightRecorder();
+					}));
+
+			FAutoConsoleCommandWithWorldAndArgs CCommandDumpFlightRecorder(
+				TEXT("jt.autoreplay.inputrecorder.dumpflightrecorder"),
+				TEXT("Write the flight recorder's window out as a playable session. Args: \n")
+				TEXT("[OPTIONAL: name of recording file (will be autogenerated under FlightRecorder/ by default)]"),
+				FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InParams, UWorld* InWorld)
+					{
+						if (!IsValid(InWorld))
+						{
+							return;
+						}
+
+						FFilePath FilePath;
+						if (InParams.Num() > 0)
+						{
+							FilePath.FilePath = InParams[0];
+						}
+
+						UGameInstance* GameInstance = InWorld->GetGameInstance();
+						if (!IsValid(GameInstance))
+						{
+							return;
+						}
+
+						UJTInputRecorder* InputRecorder = GameInstance->GetSubsystem<UJTInputRecorder>();
+						if (!IsValid(InputRecorder))
+						{
+							return;
+						}
+
+						InputRecorder->DumpFlightRecorder(FilePath);
+					}));
+
+			FAutoConsoleCommandWithArgs CCommandRecoverJournal(
+				TEXT("jt.autoreplay.inputrecorder.recoverjournal"),
+				TEXT("Recover a journaled recording that was cut off (e.g. by a crash) into a playable session. Args: \n")
+				TEXT("[name of the journaled recording file] \n")
+				TEXT("[OPTIONAL: name of the recovered recording file (default {name}_Recovered)]"),
+				FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& InParams)
+					{
+						if (InParams.Num() < 1)
+						{
+							return;
+						}
+
+						FFilePath JournalFilePath;
+						JournalFilePath.FilePath = InParams[0];
+
+						FJTInputRecordingSession RecoveredSession;
+						bool bWasComplete = false;
+						if (!FJTInputSerializer::RecoverSessionFromBinary(JournalFilePath, RecoveredSession, bWasComplete))
+						{
+							UE_LOG(LogJTInputRecorder, Error, TEXT("Unable to recover %s"), *JournalFilePath.FilePath);
+							return;
+						}
+
+						FFilePath RecoveredFilePath;
+						RecoveredFilePath.FilePath = ((InParams.Num() > 1) ? InParams[1]
+							: (FPaths::Combine(FPaths::GetPath(JournalFilePath.FilePath), FPaths::GetBaseFilename(JournalFilePath.FilePath)) + TEXT("_Recovered.")
+								+ FJTInputSerializer::GetFileExtensionForFormat(EJTInputRecordingFileFormat::Binary)));
+
+						if (FJTInputSerializer::ExportSession(RecoveredFilePath, RecoveredSession))
+						{
+							UE_LOG(LogJTInputRecorder, Display, TEXT("Recovered %d frames (%d events) of %s%s to %s"),
+								RecoveredSession.InputTimeline.Num(), RecoveredSession.InputTimeline.NumEvents(), *JournalFilePath.FilePath,
+								(bWasComplete ? TEXT(" (which was already complete)") : TEXT("")), *RecoveredFilePath.FilePath);
+						}
+					}));
+
 			TAutoConsoleVariable<bool> CVarShowRecordingStatus(
 				TEXT("jt.autoreplay.inputrecorder.showrecordingstatus"),
 				true,
 				TEXT("Shows the current recording status for the input recorder"));
 		} // Input Recorder
+
+		namespace BatchRunner
+		{
+			FAutoConsoleCommandWithWorldAndArgs CCommandRunBatch(
+				TEXT("jt.autoreplay.batchrunner.run"),
+				TEXT("Replay a whole batch of sessions, one after another, and write a summary of the results. Args:\n")
+				TEXT("[manifest json file, or directory of sessions to play]\n")
+				TEXT("[OPTIONAL: map to open for sessions that don't name their own (default: keep the current map)]\n")
+				TEXT("[OPTIONAL: path to write the summary json to (default {Project}/Saved/AutoReplay/)]\n")
+				TEXT("[OPTIONAL: [1/0] - whether to exit the process once finished, with a non-zero exit code if any session failed (default 0)]"),
+				FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InParams, UWorld* InWorld)
+					{
+						if (InParams.IsEmpty())
+						{
+							return;
+						}
+
+						if (!IsValid(InWorld))
+						{
+							return;
+						}
+
+						FJTInputBatchRequestParams BatchRequestParams;
+						for (int32 Index = 0; Index < InParams.Num(); ++Index)
+						{
+							const FString& CurrentString = InParams[Index];
+							if (Index == 0)
+							{
+								BatchRequestParams.Source = CurrentString;
+							}
+							else if (Index == 1)
+							{
+								BatchRequestParams.DefaultMap = CurrentString;
+							}
+							else if (Index == 2)
+							{
+								BatchRequestParams.SummaryFilePath = CurrentString;
+							}
+							else if (Index == 3)
+							{
+								BatchRequestParams.bExitWhenFinished = static_cast<bool>(FCString::Atoi(*CurrentString));
+							}
+						}
+
+						UGameInstance* GameInstance = InWorld->GetGameInstance();
+						if (!IsValid(GameInstance))
+						{
+							return;
+						}
+
+						UJTInputBatchRunner* BatchRunner = GameInstance->GetSubsystem<UJTInputBatchRunner>();
+						if (!IsValid(BatchRunner))
+						{
+							return;
+						}
+
+						BatchRunner->RunBatch(BatchRequestParams);
+					}));
+
+			FAutoConsoleCommandWithWorldAndArgs CCommandCancelBatch(
+				TEXT("jt.autoreplay.batchrunner.cancel"),
+				TEXT("Cancel the ongoing batch. A summary of the sessions run so far is still written"),
+				FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InParams, UWorld* InWorld)
+					{
+						if (!IsValid(InWorld))
+						{
+							return;
+						}
+
+						UGameInstance* GameInstance = InWorld->GetGameInstance();
+						if (!IsValid(GameInstance))
+						{
+							return;
+						}
+
+						UJTInputBatchRunner* BatchRunner = GameInstance->GetSubsystem<UJTInputBatchRunner>();
+						if (!IsValid(BatchRunner))
+						{
+							return;
+						}
+
+						BatchRunner->CancelBatch();
+					}));
+		} // Batch Runner
+
+		namespace Profiling
+		{
+			TAutoConsoleVariable<int32> CVarBookmarkInterval(
+				TEXT("jt.autoreplay.trace.bookmarkinterval"),
+				600,
+				TEXT("Emits a trace bookmark every N frames of recording/playback, so Insights captures line up with the input timeline (0 disables)"));
+
+			FAutoConsoleCommandWithWorldAndArgs CCommandMemReport(
+				TEXT("jt.autoreplay.memreport"),
+				TEXT("Logs a breakdown of the memory used by the input recorder, the input player and the session cache"),
+				FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InParams, UWorld* InWorld)
+					{
+						if (!IsValid(InWorld))
+						{
+							return;
+						}
+
+						SIZE_T TotalBytes = 0;
+
+						UGameInstance* GameInstance = InWorld->GetGameInstance();
+						UJTInputRecorder* InputRecorder = (IsValid(GameInstance) ? GameInstance->GetSubsystem<UJTInputRecorder>() : nullptr);
+						if (IsValid(InputRecorder))
+						{
+							FJTAutoReplayMemoryReport RecorderReport;
+							InputRecorder->GetMemoryReport(RecorderReport);
+							RecorderReport.Print(*GLog, TEXT("Input Recorder"));
+							TotalBytes += RecorderReport.GetTotal();
+						}
+
+						UJTInputPlayer* InputPlayer = InWorld->GetSubsystem<UJTInputPlayer>();
+						if (IsValid(InputPlayer))
+						{
+							FJTAutoReplayMemoryReport PlayerReport;
+							InputPlayer->GetMemoryReport(PlayerReport);
+							PlayerReport.Print(*GLog, TEXT("Input Player"));
+							TotalBytes += PlayerReport.GetTotal();
+						}
+
+						const FJTInputSessionCache& SessionCache = FJTInputSessionCache::Get();
+						FJTAutoReplayMemoryReport CacheReport;
+						CacheReport.Add(FString::Printf(TEXT("Cached Sessions (%d)"), SessionCache.Num()), static_cast<SIZE_T>(SessionCache.GetCachedBytes()));
+						CacheReport.Print(*GLog, TEXT("Session Cache"));
+						TotalBytes += CacheReport.GetTotal();
+
+						GLog->Logf(TEXT("AutoReplay Total: %.2f KB"), (TotalBytes / 1024.0));
+					}));
+		} // Profiling
+
+		namespace PerfComparator
+		{
+			FAutoConsoleCommandWithArgs CCommandCompare(
+				TEXT("jt.autoreplay.perf.compare"),
+				TEXT("Compare performance captures of the same session from two builds, and flag any regressions. Args:\n")
+				TEXT("[baseline capture csv, or directory of captures]\n")
+				TEXT("[candidate capture csv, or directory of captures]\n")
+				TEXT("[OPTIONAL: path to write the report json to]"),
+				FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& InParams)
+					{
+						if (InParams.Num() < 2)
+						{
+							return;
+						}
+
+						TArray<FJTInputPerfCapture> BaselineCaptures;
+						TArray<FJTInputPerfCapture> CandidateCaptures;
+						if (!FJTPerfComparator::LoadCaptures(InParams[0], BaselineCaptures) || !FJTPerfComparator::LoadCaptures(InParams[1], CandidateCaptures))
+						{
+							UE_LOG(LogJTPerfComparator, Error, TEXT("Cannot compare. Unable to load captures from %s and %s"), *InParams[0], *InParams[1]);
+							return;
+						}
+
+						FJTPerfComparisonReport Report;
+						if (!FJTPerfComparator::Compare(BaselineCaptures, CandidateCaptures, FJTPerfComparisonThresholds(), Report))
+						{
+							return;
+						}
+
+						FJTPerfComparator::LogReport(Report);
+
+						if (InParams.Num() > 2)
+						{
+							FJTPerfComparator::SaveReport(Report, InParams[2]);
+						}
+					}));
+		} // Perf Comparator
 	} // namespace AutoReplay
 } // namespace JT
@@ -0,0 +1,26 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "JTAutoReplayProfiling.h"
+
+UE_TRACE_CHANNEL_DEFINE(AutoReplayChannel);
+
+LLM_DEFINE_TAG(AutoReplay);
+
+DEFINE_STAT(STAT_JTInputRecorder_Tick);
+DEFINE_STAT(STAT_JTInputPlayer_Tick);
+DEFINE_STAT(STAT_JTInputBatchRunner_Tick);
+
+DEFINE_STAT(STAT_JTInputRecorder_FrameEvents);
+DEFINE_STAT(STAT_JTInputPlayer_FrameEvents);
+DEFINE_STAT(STAT_JTInputRecorder_SessionEvents);
+DEFINE_STAT(STAT_JTInputPlayer_SessionEvents);
+DEFINE_STAT(STAT_JTInputPlayer_TimelineFrame);
+
+DEFINE_STAT(STAT_JTInputRecorder_SessionMemory);
+DEFINE_STAT(STAT_JTInputPlayer_ProgramMemory);
+
+TRACE_DECLARE_INT_COUNTER(JTAutoReplay_FrameEventsRecorded, TEXT("AutoReplay/Events Recorded (Frame)"));
+TRACE_DECLARE_INT_COUNTER(JTAutoReplay_FrameEventsInjected, TEXT("AutoReplay/Events Injected (Frame)"));
+TRACE_DECLARE_INT_COUNTER(JTAutoReplay_PlaybackTimelineFrame, TEXT("AutoReplay/Playback Timeline Frame"));
+TRACE_DECLARE_MEMORY_COUNTER(JTAutoReplay_RecordingSessionMemory, TEXT("AutoReplay/Recording Session Memory"));
+TRACE_DECLARE_MEMORY_COUNTER(JTAutoReplay_PlaybackProgramMemory, TEXT("AutoReplay/Playback Program Memory"));
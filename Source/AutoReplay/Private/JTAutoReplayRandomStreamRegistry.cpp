@@ -0,0 +1,67 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "JTAutoReplayRandomStreamRegistry.h"
+
+FJTRandomStreamRegistry& FJTRandomStreamRegistry::Get()
+{
+	static FJTRandomStreamRegistry RandomStreamRegistry;
+	return RandomStreamRegistry;
+}
+
+void FJTRandomStreamRegistry::RegisterStream(FName InName, FRandomStream& InStream)
+{
+	check(IsInGameThread());
+
+	Streams.Add(InName, &InStream);
+}
+
+void FJTRandomStreamRegistry::UnregisterStream(FName InName)
+{
+	check(IsInGameThread());
+
+	Streams.Remove(InName);
+}
+
+void FJTRandomStreamRegistry::UnregisterStream(const FRandomStream& InStream)
+{
+	check(IsInGameThread());
+
+	for (auto It = Streams.CreateIterator(); It; ++It)
+	{
+		if (It.Value() == &InStream)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FJTRandomStreamRegistry::CaptureSeeds(TArray<FJTRandomStreamSeed>& OutSeeds) const
+{
+	check(IsInGameThread());
+
+	OutSeeds.Reserve(OutSeeds.Num() + Streams.Num());
+	for (const TPair<FName, FRandomStream*>& Stream : Streams)
+	{
+		FJTRandomStreamSeed& StreamSeed = OutSeeds.AddDefaulted_GetRef();
+		StreamSeed.Name = Stream.Key;
+		StreamSeed.Seed = Stream.Value->GetCurrentSeed();
+	}
+}
+
+int32 FJTRandomStreamRegistry::RestoreSeeds(TArrayView<const FJTRandomStreamSeed> InSeeds) const
+{
+	check(IsInGameThread());
+
+	int32 NumRestoredSeeds = 0;
+	for (const FJTRandomStreamSeed& StreamSeed : InSeeds)
+	{
+		if (FRandomStream* const* Stream = Streams.Find(StreamSeed.Name))
+		{
+			// A stream initialized with its current seed carries on with the exact same sequence
+			(*Stream)->Initialize(StreamSeed.Seed);
+			++NumRestoredSeeds;
+		}
+	}
+
+	return NumRestoredSeeds;
+}
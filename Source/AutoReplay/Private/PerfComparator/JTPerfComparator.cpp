@@ -0,0 +1,329 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "PerfComparator/JTPerfComparator.h"
+
+#include "InputPlayer/JTInputPerfCapture.h"
+
+#include "Algo/Sort.h"
+#include "HAL/FileManager.h"
+#include "JsonObjectConverter.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY(LogJTPerfComparator);
+
+namespace
+{
+	struct FPerfMetric
+	{
+		const TCHAR* Name;
+		float FJTInputPerfSample::* Member;
+		bool bCountsHitches;
+	};
+
+	const FPerfMetric PerfMetrics[] =
+	{
+		{ TEXT("FrameTimeMs"), &FJTInputPerfSample::FrameTimeMs, true },
+		{ TEXT("GameThreadTimeMs"), &FJTInputPerfSample::GameThreadTimeMs, false },
+		{ TEXT("RenderThreadTimeMs"), &FJTInputPerfSample::RenderThreadTimeMs, false },
+		{ TEXT("RHIThreadTimeMs"), &FJTInputPerfSample::RHIThreadTimeMs, false },
+		{ TEXT("GPUTimeMs"), &FJTInputPerfSample::GPUTimeMs, false },
+	};
+
+	/** The samples of every run, per recording frame */
+	typedef TArray<TArray<const FJTInputPerfSample*, TInlineAllocator<4>>> FFrameSamples;
+
+	void GatherFrameSamples(const TArray<FJTInputPerfCapture>& InCaptures, FFrameSamples& OutFrameSamples, int32& OutNumRuns)
+	{
+		OutNumRuns = 0;
+
+		for (const FJTInputPerfCapture& Capture : InCaptures)
+		{
+			// Every play of the recording is a run of its own
+			int32 MaxPlayIndex = INDEX_NONE;
+			for (const FJTInputPerfSample& Sample : Capture.Samples)
+			{
+				if (!OutFrameSamples.IsValidIndex(Sample.Frame))
+				{
+					OutFrameSamples.SetNum(Sample.Frame + 1);
+				}
+
+				OutFrameSamples[Sample.Frame].Emplace(&Sample);
+				MaxPlayIndex = FMath::Max(MaxPlayIndex, Sample.PlayIndex);
+			}
+
+			OutNumRuns += (MaxPlayIndex + 1);
+		}
+	}
+
+	/** Sorts the given values */
+	float Percentile(TArrayView<float> InValues, float InPercentile)
+	{
+		if (InValues.IsEmpty())
+		{
+			return 0.f;
+		}
+
+		Algo::Sort(InValues);
+
+		const float Rank = (InPercentile / 100.f) * (InValues.Num() - 1);
+		const int32 LowerIndex = FMath::FloorToInt32(Rank);
+		const int32 UpperIndex = FMath::Min(LowerIndex + 1, InValues.Num() - 1);
+
+		return FMath::Lerp(InValues[LowerIndex], InValues[UpperIndex], Rank - LowerIndex);
+	}
+
+	FJTPerfMetricStats ComputeStats(TArray<float> InValues, const FPerfMetric& InMetric, const FJTPerfComparisonThresholds& InThresholds)
+	{
+		FJTPerfMetricStats Stats;
+		if (InValues.IsEmpty())
+		{
+			return Stats;
+		}
+
+		double Sum = 0.0;
+		for (const float Value : InValues)
+		{
+			Sum += Value;
+			Stats.Max = FMath::Max(Stats.Max, Value);
+
+			if (InMetric.bCountsHitches && Value > InThresholds.HitchThresholdMs)
+			{
+				++Stats.NumHitches;
+			}
+		}
+
+		Stats.Mean = static_cast<float>(Sum / InValues.Num());
+		Stats.P50 = Percentile(InValues, 50.f);
+		Stats.P90 = Percentile(InValues, 90.f);
+		Stats.P99 = Percentile(InValues, 99.f);
+
+		return Stats;
+	}
+
+	float ChangePercent(float InBaseline, float InCandidate)
+	{
+		return (InBaseline > UE_SMALL_NUMBER) ? (((InCandidate - InBaseline) / InBaseline) * 100.f) : 0.f;
+	}
+}
+
+bool FJTPerfComparator::Compare(
+	const TArray<FJTInputPerfCapture>& InBaselineCaptures,
+	const TArray<FJTInputPerfCapture>& InCandidateCaptures,
+	const FJTPerfComparisonThresholds& InThresholds,
+	FJTPerfComparisonReport& OutReport)
+{
+	OutReport = FJTPerfComparisonReport();
+
+	FFrameSamples BaselineFrameSamples;
+	FFrameSamples CandidateFrameSamples;
+	GatherFrameSamples(InBaselineCaptures, BaselineFrameSamples, OutReport.NumBaselineRuns);
+	GatherFrameSamples(InCandidateCaptures, CandidateFrameSamples, OutReport.NumCandidateRuns);
+
+	if (!InBaselineCaptures.IsEmpty())
+	{
+		OutReport.SessionFile = InBaselineCaptures[0].SessionFilePath;
+	}
+
+	for (const FJTInputPerfCapture& Capture : InCandidateCaptures)
+	{
+		if (Capture.SessionFilePath != OutReport.SessionFile)
+		{
+			UE_LOG(LogJTPerfComparator, Warning, TEXT("Comparing captures of different sessions (%s and %s)"), *OutReport.SessionFile, *Capture.SessionFilePath);
+			break;
+		}
+	}
+
+	// Only frames played by both sides can be compared (e.g. runs may have started from different frames, or been cut short)
+	TArray<int32> AlignedFrames;
+	const int32 NumFrames = FMath::Min(BaselineFrameSamples.Num(), CandidateFrameSamples.Num());
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		if (!BaselineFrameSamples[Frame].IsEmpty() && !CandidateFrameSamples[Frame].IsEmpty())
+		{
+			AlignedFrames.Emplace(Frame);
+		}
+	}
+
+	OutReport.NumAlignedFrames = AlignedFrames.Num();
+	if (AlignedFrames.IsEmpty())
+	{
+		UE_LOG(LogJTPerfComparator, Error, TEXT("Cannot compare captures. No frames were captured by both the baseline and the candidate"));
+		return false;
+	}
+
+	const int32 WindowSizeFrames = FMath::Max(InThresholds.WindowSizeFrames, 2);
+
+	TArray<float, TInlineAllocator<16>> FrameValues;
+	auto GetFrameMedian = [&FrameValues](const FFrameSamples& InFrameSamples, int32 InFrame, const FPerfMetric& InMetric)
+		{
+			FrameValues.Reset();
+			for (const FJTInputPerfSample* Sample : InFrameSamples[InFrame])
+			{
+				FrameValues.Emplace(Sample->*InMetric.Member);
+			}
+
+			return Percentile(FrameValues, 50.f);
+		};
+
+	for (const FPerfMetric& Metric : PerfMetrics)
+	{
+		TArray<float> BaselineValues;
+		TArray<float> CandidateValues;
+		BaselineValues.Reserve(AlignedFrames.Num());
+		CandidateValues.Reserve(AlignedFrames.Num());
+
+		for (const int32 Frame : AlignedFrames)
+		{
+			BaselineValues.Emplace(GetFrameMedian(BaselineFrameSamples, Frame, Metric));
+			CandidateValues.Emplace(GetFrameMedian(CandidateFrameSamples, Frame, Metric));
+		}
+
+		FJTPerfMetricComparison& Comparison = OutReport.Metrics.AddDefaulted_GetRef();
+		Comparison.Metric = Metric.Name;
+		Comparison.Baseline = ComputeStats(BaselineValues, Metric, InThresholds);
+		Comparison.Candidate = ComputeStats(CandidateValues, Metric, InThresholds);
+		Comparison.P50ChangePercent = ChangePercent(Comparison.Baseline.P50, Comparison.Candidate.P50);
+		Comparison.P99ChangePercent = ChangePercent(Comparison.Baseline.P99, Comparison.Candidate.P99);
+
+		if (Comparison.P50ChangePercent > InThresholds.MedianRegressionPercent)
+		{
+			Comparison.bRegressed = true;
+			OutReport.Regressions.Emplace(FString::Printf(TEXT("%s median regressed by %.1f%% (%.2f -> %.2f)"),
+				Metric.Name, Comparison.P50ChangePercent, Comparison.Baseline.P50, Comparison.Candidate.P50));
+		}
+
+		if (Comparison.P99ChangePercent > InThresholds.P99RegressionPercent)
+		{
+			Comparison.bRegressed = true;
+			OutReport.Regressions.Emplace(FString::Printf(TEXT("%s 99th percentile regressed by %.1f%% (%.2f -> %.2f)"),
+				Metric.Name, Comparison.P99ChangePercent, Comparison.Baseline.P99, Comparison.Candidate.P99));
+		}
+
+		if (Metric.bCountsHitches && (Comparison.Candidate.NumHitches - Comparison.Baseline.NumHitches) > InThresholds.MaxAdditionalHitches)
+		{
+			Comparison.bRegressed = true;
+			OutReport.Regressions.Emplace(FString::Printf(TEXT("%s hitches (> %.0fms) went from %d to %d"),
+				Metric.Name, InThresholds.HitchThresholdMs, Comparison.Baseline.NumHitches, Comparison.Candidate.NumHitches));
+		}
+
+		// Windows are compared frame by frame (a paired t-test), since both sides played the same inputs on each frame
+		int32 WindowStartIndex = 0;
+		while (WindowStartIndex < AlignedFrames.Num())
+		{
+			const int32 WindowEndFrame = ((AlignedFrames[WindowStartIndex] / WindowSizeFrames) + 1) * WindowSizeFrames;
+
+			int32 WindowEndIndex = WindowStartIndex;
+			double BaselineSum = 0.0;
+			double CandidateSum = 0.0;
+			double DifferenceSum = 0.0;
+			double DifferenceSquaredSum = 0.0;
+			while (WindowEndIndex < AlignedFrames.Num() && AlignedFrames[WindowEndIndex] < WindowEndFrame)
+			{
+				const double Difference = (CandidateValues[WindowEndIndex] - BaselineValues[WindowEndIndex]);
+				BaselineSum += BaselineValues[WindowEndIndex];
+				CandidateSum += CandidateValues[WindowEndIndex];
+				DifferenceSum += Difference;
+				DifferenceSquaredSum += (Difference * Difference);
+				++WindowEndIndex;
+			}
+
+			const int32 NumWindowFrames = (WindowEndIndex - WindowStartIndex);
+			if (NumWindowFrames >= 2)
+			{
+				const double MeanDifference = (DifferenceSum / NumWindowFrames);
+				const double DifferenceVariance = FMath::Max((DifferenceSquaredSum - (DifferenceSum * MeanDifference)) / (NumWindowFrames - 1), 0.0);
+				const double StandardError = FMath::Sqrt(DifferenceVariance / NumWindowFrames);
+
+				FJTPerfWindowComparison Window;
+				Window.FirstFrame = AlignedFrames[WindowStartIndex];
+				Window.LastFrame = AlignedFrames[WindowEndIndex - 1];
+				Window.FirstTimelineFrameIndex = BaselineFrameSamples[Window.FirstFrame][0]->TimelineFrameIndex;
+				Window.LastTimelineFrameIndex = BaselineFrameSamples[Window.LastFrame][0]->TimelineFrameIndex;
+				Window.BaselineMean = static_cast<float>(BaselineSum / NumWindowFrames);
+				Window.CandidateMean = static_cast<float>(CandidateSum / NumWindowFrames);
+				Window.ChangePercent = ChangePercent(Window.BaselineMean, Window.CandidateMean);
+				Window.TStatistic = (StandardError > UE_DOUBLE_SMALL_NUMBER) ? static_cast<float>(MeanDifference / StandardError) : 0.f;
+
+				if (Window.ChangePercent > InThresholds.WindowRegressionPercent && Window.TStatistic > InThresholds.WindowMinTStatistic)
+				{
+					Comparison.bRegressed = true;
+					OutReport.Regressions.Emplace(FString::Printf(TEXT("%s regressed by %.1f%% over frames %d-%d (timeline frames %d-%d, t = %.1f)"),
+						Metric.Name, Window.ChangePercent, Window.FirstFrame, Window.LastFrame, Window.FirstTimelineFrameIndex, Window.LastTimelineFrameIndex, Window.TStatistic));
+
+					Comparison.RegressedWindows.Emplace(Window);
+				}
+			}
+
+			WindowStartIndex = WindowEndIndex;
+		}
+
+		OutReport.bHasRegression |= Comparison.bRegressed;
+	}
+
+	return true;
+}
+
+bool FJTPerfComparator::LoadCaptures(const FString& InPath, TArray<FJTInputPerfCapture>& OutCaptures)
+{
+	TArray<FString> CaptureFilePaths;
+	if (FPaths::DirectoryExists(InPath))
+	{
+		TArray<FString> CaptureFileNames;
+		IFileManager::Get().FindFiles(CaptureFileNames, *FPaths::Combine(InPath, TEXT("*.csv")), true, false);
+		CaptureFileNames.Sort();
+
+		for (const FString& CaptureFileName : CaptureFileNames)
+		{
+			CaptureFilePaths.Emplace(FPaths::Combine(InPath, CaptureFileName));
+		}
+	}
+	else
+	{
+		CaptureFilePaths.Emplace(InPath);
+	}
+
+	for (const FString& CaptureFilePath : CaptureFilePaths)
+	{
+		FJTInputPerfCapture& Capture = OutCaptures.AddDefaulted_GetRef();
+		if (!FJTInputPerfCapture::LoadFromCsv(CaptureFilePath, Capture))
+		{
+			UE_LOG(LogJTPerfComparator, Warning, TEXT("Unable to load performance capture %s"), *CaptureFilePath);
+			OutCaptures.Pop(false);
+		}
+	}
+
+	return !OutCaptures.IsEmpty();
+}
+
+bool FJTPerfComparator::SaveReport(const FJTPerfComparisonReport& InReport, const FString& InFilePath)
+{
+	FString ReportJsonString;
+	if (!FJsonObjectConverter::UStructToJsonObjectString<FJTPerfComparisonReport>(InReport, ReportJsonString))
+	{
+		return false;
+	}
+
+	return FFileHelper::SaveStringToFile(ReportJsonString, *InFilePath);
+}
+
+void FJTPerfComparator::LogReport(const FJTPerfComparisonReport& InReport)
+{
+	UE_LOG(LogJTPerfComparator, Log, TEXT("Compared %d baseline and %d candidate runs of %s over %d frames"),
+		InReport.NumBaselineRuns, InReport.NumCandidateRuns, *InReport.SessionFile, InReport.NumAlignedFrames);
+
+	for (const FJTPerfMetricComparison& Comparison : InReport.Metrics)
+	{
+		UE_LOG(LogJTPerfComparator, Log, TEXT("  %s: P50 %.2f -> %.2f (%+.1f%%), P99 %.2f -> %.2f (%+.1f%%)"),
+			*Comparison.Metric,
+			Comparison.Baseline.P50, Comparison.Candidate.P50, Comparison.P50ChangePercent,
+			Comparison.Baseline.P99, Comparison.Candidate.P99, Comparison.P99ChangePercent);
+	}
+
+	for (const FString& Regression : InReport.Regressions)
+	{
+		UE_LOG(LogJTPerfComparator, Warning, TEXT("  Regression: %s"), *Regression);
+	}
+
+	UE_LOG(LogJTPerfComparator, Log, TEXT("Verdict: %s"), (InReport.bHasRegression ? TEXT("REGRESSED") : TEXT("OK")));
+}
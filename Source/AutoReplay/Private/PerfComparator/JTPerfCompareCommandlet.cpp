@@ -0,0 +1,60 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "PerfComparator/JTPerfCompareCommandlet.h"
+
+#include "InputPlayer/JTInputPerfCapture.h"
+#include "PerfComparator/JTPerfComparator.h"
+
+#include "Misc/Parse.h"
+
+UJTPerfCompareCommandlet::UJTPerfCompareCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UJTPerfCompareCommandlet::Main(const FString& Params)
+{
+	FString BaselinePath;
+	FString CandidatePath;
+	if (!FParse::Value(*Params, TEXT("Baseline="), BaselinePath) || !FParse::Value(*Params, TEXT("Candidate="), CandidatePath))
+	{
+		UE_LOG(LogJTPerfComparator, Error, TEXT("Usage: -run=JTPerfCompare -Baseline=<capture csv or directory> -Candidate=<capture csv or directory> [-Report=<report json>]"));
+		return 1;
+	}
+
+	FJTPerfComparisonThresholds Thresholds;
+	FParse::Value(*Params, TEXT("MedianRegressionPercent="), Thresholds.MedianRegressionPercent);
+	FParse::Value(*Params, TEXT("P99RegressionPercent="), Thresholds.P99RegressionPercent);
+	FParse::Value(*Params, TEXT("HitchThresholdMs="), Thresholds.HitchThresholdMs);
+	FParse::Value(*Params, TEXT("MaxAdditionalHitches="), Thresholds.MaxAdditionalHitches);
+	FParse::Value(*Params, TEXT("WindowSizeFrames="), Thresholds.WindowSizeFrames);
+	FParse::Value(*Params, TEXT("WindowRegressionPercent="), Thresholds.WindowRegressionPercent);
+	FParse::Value(*Params, TEXT("WindowMinTStatistic="), Thresholds.WindowMinTStatistic);
+
+	TArray<FJTInputPerfCapture> BaselineCaptures;
+	TArray<FJTInputPerfCapture> CandidateCaptures;
+	if (!FJTPerfComparator::LoadCaptures(BaselinePath, BaselineCaptures) || !FJTPerfComparator::LoadCaptures(CandidatePath, CandidateCaptures))
+	{
+		UE_LOG(LogJTPerfComparator, Error, TEXT("Cannot compare. Unable to load captures from %s and %s"), *BaselinePath, *CandidatePath);
+		return 1;
+	}
+
+	FJTPerfComparisonReport Report;
+	if (!FJTPerfComparator::Compare(BaselineCaptures, CandidateCaptures, Thresholds, Report))
+	{
+		return 1;
+	}
+
+	FJTPerfComparator::LogReport(Report);
+
+	FString ReportFilePath;
+	if (FParse::Value(*Params, TEXT("Report="), ReportFilePath) && !FJTPerfComparator::SaveReport(Report, ReportFilePath))
+	{
+		UE_LOG(LogJTPerfComparator, Error, TEXT("Comparison report could not be written to %s"), *ReportFilePath);
+	}
+
+	return (Report.bHasRegression ? 1 : 0);
+}
@@ -0,0 +1,449 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "ReplayFarm/JTReplayFarm.h"
+
+#include "JTAutoReplayProfiling.h"
+
+#include "Common/TcpSocketBuilder.h"
+#include "HAL/PlatformTime.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "JsonObjectConverter.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+using namespace JT::AutoReplay::ReplayFarm;
+
+FJTReplayFarm::FJTReplayFarm(const FJTReplayFarmParams& InParams)
+	: Params(InParams)
+{
+}
+
+FJTReplayFarm::~FJTReplayFarm()
+{
+	if (!bIsFinished && ListenSocket)
+	{
+		Finish();
+	}
+
+	if (ListenSocket)
+	{
+		ListenSocket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(ListenSocket);
+	}
+}
+
+bool FJTReplayFarm::Start()
+{
+	FJTInputBatchManifest Manifest;
+	if (!UJTInputBatchRunner::LoadManifest(Params.Source, Manifest))
+	{
+		UE_LOG(LogJTInputBatchRunner, Error, TEXT("Cannot start replay farm. Unable to read any sessions from %s"), *Params.Source);
+		return false;
+	}
+
+	const FString& DefaultMap = (Params.DefaultMap.IsEmpty() ? Manifest.DefaultMap : Params.DefaultMap);
+
+	Jobs.Reserve(Manifest.Sessions.Num());
+	Summary.Results.Reserve(Manifest.Sessions.Num());
+	for (FJTInputBatchEntry& Entry : Manifest.Sessions)
+	{
+		// Workers have no manifest of their own, so the default map is resolved here
+		if (Entry.Map.IsEmpty())
+		{
+			Entry.Map = DefaultMap;
+		}
+
+		FJTInputBatchResult& Result = Summary.Results.AddDefaulted_GetRef();
+		Result.SessionFile = Entry.SessionFile;
+		Result.Map = Entry.Map;
+
+		Jobs.AddDefaulted_GetRef().Entry = MoveTemp(Entry);
+	}
+
+	ListenSocket = FTcpSocketBuilder(TEXT("JTReplayFarm"))
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToEndpoint(FIPv4Endpoint(FIPv4Address(127, 0, 0, 1), 0))
+		.Listening(16)
+		.Build();
+
+	if (!ListenSocket)
+	{
+		UE_LOG(LogJTInputBatchRunner, Error, TEXT("Cannot start replay farm. Unable to listen for workers"));
+		return false;
+	}
+
+	StartTime = FPlatformTime::Seconds();
+
+	// Every worker starts out owning a contiguous block of the corpus
+	const int32 NumWorkers = FMath::Clamp(Params.NumWorkers, 1, Jobs.Num());
+	Workers.SetNum(NumWorkers);
+	for (int32 WorkerId = 0; WorkerId < NumWorkers; ++WorkerId)
+	{
+		FWorker& Worker = Workers[WorkerId];
+		Worker.Id = WorkerId;
+
+		const int32 FirstJobIndex = ((Jobs.Num() * WorkerId) / NumWorkers);
+		const int32 EndJobIndex = ((Jobs.Num() * (WorkerId + 1)) / NumWorkers);
+		for (int32 JobIndex = FirstJobIndex; JobIndex < EndJobIndex; ++JobIndex)
+		{
+			Worker.JobQueue.Emplace(JobIndex);
+		}
+
+		if (!SpawnWorker(Worker))
+		{
+			Worker.bIsRetired = true;
+		}
+	}
+
+	UE_LOG(LogJTInputBatchRunner, Log, TEXT("Replay farm started with %d sessions across %d workers on port %d"), Jobs.Num(), NumWorkers, ListenSocket->GetPortNo());
+	return true;
+}
+
+void FJTReplayFarm::Tick()
+{
+	JT_AUTOREPLAY_LLM_SCOPE();
+
+	if (bIsFinished)
+	{
+		return;
+	}
+
+	AcceptConnections();
+
+	for (FWorker& Worker : Workers)
+	{
+		TickWorker(Worker);
+	}
+
+	if (!HasRemainingJobs())
+	{
+		Finish();
+		return;
+	}
+
+	// Jobs left only in the queues of retired workers are still stolen by the others. If no workers are left, they never run
+	const bool bHasAnyActiveWorker = Workers.ContainsByPredicate([](const FWorker& Worker) { return !Worker.bIsRetired; });
+	if (!bHasAnyActiveWorker)
+	{
+		UE_LOG(LogJTInputBatchRunner, Error, TEXT("Replay farm has no workers left"));
+
+		for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+		{
+			if (!Jobs[JobIndex].bIsDone)
+			{
+				FJTInputBatchResult Result = Summary.Results[JobIndex];
+				Result.FailureReason = TEXT("No replay farm workers were left to play the session");
+				CompleteJob(JobIndex, Result);
+			}
+		}
+
+		Finish();
+	}
+}
+
+void FJTReplayFarm::Finish()
+{
+	bIsFinished = true;
+
+	for (FWorker& Worker : Workers)
+	{
+		if (Worker.Connection.IsValid())
+		{
+			Worker.Connection->Send(ExitMessage);
+		}
+	}
+
+	// Give the workers a chance to shut down cleanly before they are killed
+	const double ExitDeadline = (FPlatformTime::Seconds() + 30.0);
+	for (FWorker& Worker : Workers)
+	{
+		if (!Worker.ProcessHandle.IsValid())
+		{
+			continue;
+		}
+
+		while (FPlatformProcess::IsProcRunning(Worker.ProcessHandle) && FPlatformTime::Seconds() < ExitDeadline)
+		{
+			FPlatformProcess::Sleep(0.1f);
+		}
+
+		if (FPlatformProcess::IsProcRunning(Worker.ProcessHandle))
+		{
+			FPlatformProcess::TerminateProc(Worker.ProcessHandle, true);
+		}
+
+		FPlatformProcess::CloseProc(Worker.ProcessHandle);
+		Worker.Connection.Reset();
+	}
+
+	UnidentifiedConnections.Reset();
+
+	Summary.TotalWallTimeSeconds = (FPlatformTime::Seconds() - StartTime);
+
+	FString SummaryFilePath = Params.SummaryFilePath;
+	if (SummaryFilePath.IsEmpty())
+	{
+		SummaryFilePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("AutoReplay"),
+			FString::Printf(TEXT("FarmSummary_%s.json"), *FDateTime::Now().ToString()));
+	}
+
+	if (UJTInputBatchRunner::SaveSummary(Summary, SummaryFilePath))
+	{
+		UE_LOG(LogJTInputBatchRunner, Log, TEXT("Replay farm summary written to %s"), *SummaryFilePath);
+	}
+	else
+	{
+		UE_LOG(LogJTInputBatchRunner, Error, TEXT("Replay farm summary could not be written to %s"), *SummaryFilePath);
+	}
+
+	UE_LOG(LogJTInputBatchRunner, Log, TEXT("Replay farm Finished in %.2fs. %d succeeded, %d failed"),
+		Summary.TotalWallTimeSeconds, Summary.NumSucceeded, Summary.NumFailed);
+}
+
+bool FJTReplayFarm::SpawnWorker(FWorker& InWorker)
+{
+	const FString WorkerCommandLine = FString::Printf(TEXT("\"%s\" -game -nullrhi -nosound -unattended -nosplash -JTReplayWorker=127.0.0.1:%d -JTReplayWorkerId=%d -abslog=\"%s\" %s"),
+		*FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()),
+		ListenSocket->GetPortNo(),
+		InWorker.Id,
+		*FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectLogDir(), FString::Printf(TEXT("JTReplayWorker_%d.log"), InWorker.Id))),
+		*Params.WorkerArgs);
+
+	InWorker.ProcessHandle = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *WorkerCommandLine, false, true, true, nullptr, 0, nullptr, nullptr);
+	InWorker.SpawnTime = FPlatformTime::Seconds();
+
+	if (!InWorker.ProcessHandle.IsValid())
+	{
+		UE_LOG(LogJTInputBatchRunner, Error, TEXT("Replay farm unable to start worker %d"), InWorker.Id);
+		return false;
+	}
+
+	return true;
+}
+
+void FJTReplayFarm::AcceptConnections()
+{
+	bool bHasPendingConnection = false;
+	while (ListenSocket->HasPendingConnection(bHasPendingConnection) && bHasPendingConnection)
+	{
+		if (FSocket* WorkerSocket = ListenSocket->Accept(TEXT("JTReplayFarmConnection")))
+		{
+			UnidentifiedConnections.Emplace(MakeUnique<FConnection>(WorkerSocket));
+		}
+	}
+
+	// Connections are matched up with their worker once it has introduced itself
+	for (int32 ConnectionIndex = UnidentifiedConnections.Num() - 1; ConnectionIndex >= 0; --ConnectionIndex)
+	{
+		TArray<FMessage> Messages;
+		if (!UnidentifiedConnections[ConnectionIndex]->Receive(Messages))
+		{
+			UnidentifiedConnections.RemoveAtSwap(ConnectionIndex);
+			continue;
+		}
+
+		if (Messages.IsEmpty())
+		{
+			continue;
+		}
+
+		const int32 WorkerId = (Messages[0].Type == HelloMessage ? FCString::Atoi(*Messages[0].Payload) : INDEX_NONE);
+		if (Workers.IsValidIndex(WorkerId) && !Workers[WorkerId].bIsRetired && !Workers[WorkerId].Connection.IsValid())
+		{
+			UE_LOG(LogJTInputBatchRunner, Log, TEXT("Replay farm worker %d connected"), WorkerId);
+			Workers[WorkerId].Connection = MoveTemp(UnidentifiedConnections[ConnectionIndex]);
+		}
+
+		UnidentifiedConnections.RemoveAtSwap(ConnectionIndex);
+	}
+}
+
+void FJTReplayFarm::TickWorker(FWorker& InWorker)
+{
+	if (InWorker.bIsRetired)
+	{
+		return;
+	}
+
+	if (!FPlatformProcess::IsProcRunning(InWorker.ProcessHandle))
+	{
+		int32 ReturnCode = 0;
+		FPlatformProcess::GetProcReturnCode(InWorker.ProcessHandle, &ReturnCode);
+		OnWorkerLost(InWorker, FString::Printf(TEXT("Worker process exited with code %d"), ReturnCode));
+		return;
+	}
+
+	if (!InWorker.Connection.IsValid())
+	{
+		if ((FPlatformTime::Seconds() - InWorker.SpawnTime) >= Params.WorkerConnectTimeoutSeconds)
+		{
+			OnWorkerLost(InWorker, TEXT("Worker never connected"));
+		}
+
+		return;
+	}
+
+	TArray<FMessage> Messages;
+	if (!InWorker.Connection->Receive(Messages))
+	{
+		OnWorkerLost(InWorker, TEXT("Worker lost its connection"));
+		return;
+	}
+
+	for (const FMessage& Message : Messages)
+	{
+		if (Message.Type != ResultMessage || InWorker.CurrentJobIndex == INDEX_NONE)
+		{
+			continue;
+		}
+
+		FJTInputBatchResult Result;
+		if (!FJsonObjectConverter::JsonObjectStringToUStruct<FJTInputBatchResult>(Message.Payload, &Result))
+		{
+			Result = Summary.Results[InWorker.CurrentJobIndex];
+			Result.FailureReason = TEXT("Worker sent an invalid result");
+		}
+
+		Result.WorkerId = InWorker.Id;
+		CompleteJob(InWorker.CurrentJobIndex, Result);
+		InWorker.CurrentJobIndex = INDEX_NONE;
+	}
+
+	if (InWorker.CurrentJobIndex != INDEX_NONE)
+	{
+		if (Params.SessionTimeoutSeconds > 0.f && (FPlatformTime::Seconds() - InWorker.JobStartTime) >= Params.SessionTimeoutSeconds)
+		{
+			OnWorkerLost(InWorker, TEXT("Worker hung while playing"));
+		}
+
+		return;
+	}
+
+	AssignJob(InWorker);
+}
+
+void FJTReplayFarm::OnWorkerLost(FWorker& InWorker, const FString& InReason)
+{
+	UE_LOG(LogJTInputBatchRunner, Warning, TEXT("Replay farm lost worker %d: %s"), InWorker.Id, *InReason);
+
+	if (FPlatformProcess::IsProcRunning(InWorker.ProcessHandle))
+	{
+		FPlatformProcess::TerminateProc(InWorker.ProcessHandle, true);
+	}
+
+	FPlatformProcess::CloseProc(InWorker.ProcessHandle);
+	InWorker.Connection.Reset();
+
+	// The session that was playing is retried (most likely by the restarted worker), unless it keeps taking workers down with it
+	if (InWorker.CurrentJobIndex != INDEX_NONE)
+	{
+		FJob& Job = Jobs[InWorker.CurrentJobIndex];
+		if (Job.NumAttempts < Params.MaxSessionAttempts)
+		{
+			InWorker.JobQueue.Insert(InWorker.CurrentJobIndex, 0);
+		}
+		else
+		{
+			FJTInputBatchResult Result = Summary.Results[InWorker.CurrentJobIndex];
+			Result.FailureReason = FString::Printf(TEXT("%s (after %d attempts)"), *InReason, Job.NumAttempts);
+			Result.WorkerId = InWorker.Id;
+			CompleteJob(InWorker.CurrentJobIndex, Result);
+		}
+
+		InWorker.CurrentJobIndex = INDEX_NONE;
+	}
+
+	if (InWorker.NumRestarts >= Params.MaxWorkerRestarts)
+	{
+		UE_LOG(LogJTInputBatchRunner, Error, TEXT("Replay farm worker %d retired after %d restarts"), InWorker.Id, InWorker.NumRestarts);
+		InWorker.bIsRetired = true;
+		return;
+	}
+
+	++InWorker.NumRestarts;
+	if (!SpawnWorker(InWorker))
+	{
+		InWorker.bIsRetired = true;
+	}
+}
+
+void FJTReplayFarm::AssignJob(FWorker& InWorker)
+{
+	const int32 JobIndex = PopJob(InWorker);
+	if (JobIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	FString EntryJsonString;
+	FJsonObjectConverter::UStructToJsonObjectString<FJTInputBatchEntry>(Jobs[JobIndex].Entry, EntryJsonString, 0, 0, 0, nullptr, false);
+
+	++Jobs[JobIndex].NumAttempts;
+	InWorker.CurrentJobIndex = JobIndex;
+	InWorker.JobStartTime = FPlatformTime::Seconds();
+
+	if (!InWorker.Connection->Send(RunMessage, EntryJsonString))
+	{
+		OnWorkerLost(InWorker, TEXT("Worker lost its connection"));
+	}
+}
+
+int32 FJTReplayFarm::PopJob(FWorker& InWorker)
+{
+	if (!InWorker.JobQueue.IsEmpty())
+	{
+		const int32 JobIndex = InWorker.JobQueue[0];
+		InWorker.JobQueue.RemoveAt(0, 1, false);
+		return JobIndex;
+	}
+
+	// Steal from the back of the longest queue, so its owner keeps working through its own block undisturbed
+	FWorker* VictimWorker = nullptr;
+	for (FWorker& Worker : Workers)
+	{
+		if (!VictimWorker || Worker.JobQueue.Num() > VictimWorker->JobQueue.Num())
+		{
+			VictimWorker = &Worker;
+		}
+	}
+
+	if (!VictimWorker || VictimWorker->JobQueue.IsEmpty())
+	{
+		return INDEX_NONE;
+	}
+
+	return VictimWorker->JobQueue.Pop(false);
+}
+
+void FJTReplayFarm::CompleteJob(int32 InJobIndex, const FJTInputBatchResult& InResult)
+{
+	FJob& Job = Jobs[InJobIndex];
+	if (Job.bIsDone)
+	{
+		return;
+	}
+
+	Job.bIsDone = true;
+	++NumDoneJobs;
+
+	Summary.Results[InJobIndex] = InResult;
+	if (InResult.bSucceeded)
+	{
+		++Summary.NumSucceeded;
+	}
+	else
+	{
+		++Summary.NumFailed;
+	}
+
+	UE_LOG(LogJTInputBatchRunner, Log, TEXT("Replay farm session %d/%d %s on worker %d: %s"), NumDoneJobs, Jobs.Num(),
+		(InResult.bSucceeded ? TEXT("succeeded") : TEXT("failed")), InResult.WorkerId, *InResult.SessionFile);
+}
+
+bool FJTReplayFarm::HasRemainingJobs() const
+{
+	return (NumDoneJobs < Jobs.Num());
+}
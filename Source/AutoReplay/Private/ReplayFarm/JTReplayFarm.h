@@ -0,0 +1,116 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BatchRunner/JTInputBatchRunner.h"
+#include "HAL/PlatformProcess.h"
+#include "ReplayFarm/JTReplayFarmConnection.h"
+
+class FSocket;
+
+/**
+ * Used to define how a replay farm should be run
+ */
+struct FJTReplayFarmParams
+{
+	/** A manifest json file or a directory of sessions (see FJTInputBatchRequestParams::Source) */
+	FString Source;
+
+	/** The map to open for sessions that don't name their own */
+	FString DefaultMap;
+
+	/** Where to write the combined summary json. Defaults to {Project}/Saved/AutoReplay/ */
+	FString SummaryFilePath;
+
+	/** Extra command line arguments passed to every worker process */
+	FString WorkerArgs;
+
+	/** The number of worker processes to run at once */
+	int32 NumWorkers = 4;
+
+	/** How many times a crashed (or hung) worker is restarted before it is given up on */
+	int32 MaxWorkerRestarts = 3;
+
+	/** How many times a session is attempted before it is counted as failed, should its worker crash while playing it */
+	int32 MaxSessionAttempts = 2;
+
+	/** If positive, a worker that has been playing a single session for this long is assumed hung and is restarted */
+	float SessionTimeoutSeconds = 0.f;
+
+	/** How long a freshly started worker has to connect back before it is assumed hung and is restarted */
+	float WorkerConnectTimeoutSeconds = 300.f;
+};
+
+/**
+ * The replay farm shards a corpus of sessions across several local game processes, all playing at once.
+ *
+ * Each worker process is the game itself, run as a replay farm worker (see UJTInputBatchRunner). Workers connect
+ * back to the farm over localhost and are handed one session at a time. Every worker starts out owning a
+ * contiguous block of the corpus, and workers that run out of their own sessions steal from the back of whichever
+ * block has the most left, so a few long sessions can't hold up the whole farm. Workers that crash or hang are
+ * restarted, and the session they were playing is retried.
+ */
+class FJTReplayFarm
+{
+public:
+	FJTReplayFarm(const FJTReplayFarmParams& InParams);
+	~FJTReplayFarm();
+
+	/** Loads the corpus, and starts listening for and spawning workers. @return false if the farm could not be started */
+	bool Start();
+
+	/** Accepts worker connections, hands out sessions and watches over the worker processes. Call until IsFinished */
+	void Tick();
+
+	/** Stops all workers and writes the combined summary */
+	void Finish();
+
+	bool IsFinished() const { return bIsFinished; }
+
+	const FJTInputBatchSummary& GetSummary() const { return Summary; }
+
+private:
+	struct FJob
+	{
+		FJTInputBatchEntry Entry;
+		int32 NumAttempts = 0;
+		bool bIsDone = false;
+	};
+
+	struct FWorker
+	{
+		int32 Id = INDEX_NONE;
+		FProcHandle ProcessHandle;
+		TUniquePtr<JT::AutoReplay::ReplayFarm::FConnection> Connection;
+
+		/** The jobs this worker owns. The worker pops from the front, others steal from the back */
+		TArray<int32> JobQueue;
+
+		int32 CurrentJobIndex = INDEX_NONE;
+		double SpawnTime = 0.0;
+		double JobStartTime = 0.0;
+		int32 NumRestarts = 0;
+		bool bIsRetired = false;
+	};
+
+	bool SpawnWorker(FWorker& InWorker);
+	void AcceptConnections();
+	void TickWorker(FWorker& InWorker);
+	void OnWorkerLost(FWorker& InWorker, const FString& InReason);
+	void AssignJob(FWorker& InWorker);
+	int32 PopJob(FWorker& InWorker);
+	void CompleteJob(int32 InJobIndex, const FJTInputBatchResult& InResult);
+	bool HasRemainingJobs() const;
+
+private:
+	FJTReplayFarmParams Params;
+	TArray<FJob> Jobs;
+	TArray<FWorker> Workers;
+	TArray<TUniquePtr<JT::AutoReplay::ReplayFarm::FConnection>> UnidentifiedConnections;
+	FJTInputBatchSummary Summary;
+	FSocket* ListenSocket = nullptr;
+	double StartTime = 0.0;
+	int32 NumDoneJobs = 0;
+	bool bIsFinished = false;
+};
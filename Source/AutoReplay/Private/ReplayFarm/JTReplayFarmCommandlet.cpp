@@ -0,0 +1,48 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "ReplayFarm/JTReplayFarmCommandlet.h"
+
+#include "ReplayFarm/JTReplayFarm.h"
+
+#include "HAL/PlatformProcess.h"
+#include "Misc/Parse.h"
+
+UJTReplayFarmCommandlet::UJTReplayFarmCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UJTReplayFarmCommandlet::Main(const FString& Params)
+{
+	FJTReplayFarmParams FarmParams;
+	if (!FParse::Value(*Params, TEXT("Source="), FarmParams.Source))
+	{
+		UE_LOG(LogJTInputBatchRunner, Error, TEXT("Usage: -run=JTReplayFarm -Source=<manifest or directory> [-Workers=N] [-Map=] [-Summary=] [-WorkerArgs=] [-MaxRestarts=N] [-MaxAttempts=N] [-SessionTimeout=seconds]"));
+		return 1;
+	}
+
+	FParse::Value(*Params, TEXT("Map="), FarmParams.DefaultMap);
+	FParse::Value(*Params, TEXT("Summary="), FarmParams.SummaryFilePath);
+	FParse::Value(*Params, TEXT("WorkerArgs="), FarmParams.WorkerArgs, false);
+	FParse::Value(*Params, TEXT("Workers="), FarmParams.NumWorkers);
+	FParse::Value(*Params, TEXT("MaxRestarts="), FarmParams.MaxWorkerRestarts);
+	FParse::Value(*Params, TEXT("MaxAttempts="), FarmParams.MaxSessionAttempts);
+	FParse::Value(*Params, TEXT("SessionTimeout="), FarmParams.SessionTimeoutSeconds);
+
+	FJTReplayFarm Farm(FarmParams);
+	if (!Farm.Start())
+	{
+		return 1;
+	}
+
+	while (!Farm.IsFinished())
+	{
+		Farm.Tick();
+		FPlatformProcess::Sleep(0.05f);
+	}
+
+	return (Farm.GetSummary().NumFailed > 0 ? 1 : 0);
+}
@@ -0,0 +1,160 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#include "ReplayFarm/JTReplayFarmConnection.h"
+
+#include "Common/TcpSocketBuilder.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Timespan.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace JT
+{
+	namespace AutoReplay
+	{
+		namespace ReplayFarm
+		{
+			FConnection::FConnection(FSocket* InSocket)
+				: Socket(InSocket)
+			{
+				check(Socket);
+				Socket->SetNonBlocking(true);
+				Socket->SetNoDelay(true);
+			}
+
+			FConnection::~FConnection()
+			{
+				Socket->Close();
+				ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+			}
+
+			TUniquePtr<FConnection> FConnection::Connect(const FString& InAddress)
+			{
+				FIPv4Endpoint Endpoint;
+				if (!FIPv4Endpoint::Parse(InAddress, Endpoint))
+				{
+					return nullptr;
+				}
+
+				FSocket* NewSocket = FTcpSocketBuilder(TEXT("JTReplayFarmWorker")).AsBlocking().Build();
+				if (!NewSocket)
+				{
+					return nullptr;
+				}
+
+				if (!NewSocket->Connect(*Endpoint.ToInternetAddr()))
+				{
+					ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(NewSocket);
+					return nullptr;
+				}
+
+				return MakeUnique<FConnection>(NewSocket);
+			}
+
+			bool FConnection::Send(const FString& InType, const FString& InPayload)
+			{
+				if (!bIsConnected)
+				{
+					return false;
+				}
+
+				const FString Line = (InPayload.IsEmpty() ? InType : (InType + TEXT(" ") + InPayload)) + TEXT("\n");
+				const FTCHARToUTF8 LineUtf8(*Line);
+
+				const uint8* Data = reinterpret_cast<const uint8*>(LineUtf8.Get());
+				int32 NumBytesRemaining = LineUtf8.Length();
+				while (NumBytesRemaining > 0)
+				{
+					int32 NumBytesSent = 0;
+					if (!Socket->Send(Data, NumBytesRemaining, NumBytesSent))
+					{
+						if (ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() != SE_EWOULDBLOCK)
+						{
+							bIsConnected = false;
+							return false;
+						}
+					}
+
+					Data += NumBytesSent;
+					NumBytesRemaining -= NumBytesSent;
+
+					if (NumBytesRemaining > 0)
+					{
+						FPlatformProcess::SleepNoStats(0.001f);
+					}
+				}
+
+				return true;
+			}
+
+			bool FConnection::Receive(TArray<FMessage>& OutMessages)
+			{
+				if (!bIsConnected)
+				{
+					return false;
+				}
+
+				if (Socket->GetConnectionState() != SCS_Connected)
+				{
+					bIsConnected = false;
+					return false;
+				}
+
+				while (true)
+				{
+					uint32 NumPendingBytes = 0;
+					if (!Socket->HasPendingData(NumPendingBytes) || NumPendingBytes == 0)
+					{
+						// A socket closed by the other side still reports itself as connected with nothing pending, yet
+						// is readable. The close only shows up as a 0 byte read, so read from it anyway to find out
+						if (!Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::Zero()))
+						{
+							break;
+						}
+
+						NumPendingBytes = 1;
+					}
+
+					const int32 PreviousNum = ReceiveBuffer.Num();
+					ReceiveBuffer.AddUninitialized(NumPendingBytes);
+
+					int32 NumBytesRead = 0;
+					if (!Socket->Recv(ReceiveBuffer.GetData() + PreviousNum, NumPendingBytes, NumBytesRead) || NumBytesRead == 0)
+					{
+						// Messages sent right before the close (e.g. a final result or exit) are still handed out below
+						ReceiveBuffer.SetNum(PreviousNum, false);
+						bIsConnected = false;
+						break;
+					}
+
+					ReceiveBuffer.SetNum(PreviousNum + NumBytesRead, false);
+				}
+
+				const int32 NumPreviousMessages = OutMessages.Num();
+
+				int32 LineStartIndex = 0;
+				for (int32 Index = 0; Index < ReceiveBuffer.Num(); ++Index)
+				{
+					if (ReceiveBuffer[Index] != '\n')
+					{
+						continue;
+					}
+
+					const FUTF8ToTCHAR LineTChar(reinterpret_cast<const ANSICHAR*>(ReceiveBuffer.GetData() + LineStartIndex), (Index - LineStartIndex));
+					const FString Line(LineTChar.Length(), LineTChar.Get());
+					LineStartIndex = (Index + 1);
+
+					FMessage& Message = OutMessages.AddDefaulted_GetRef();
+					if (!Line.Split(TEXT(" "), &Message.Type, &Message.Payload))
+					{
+						Message.Type = Line;
+					}
+				}
+
+				ReceiveBuffer.RemoveAt(0, LineStartIndex, false);
+				return (bIsConnected || (OutMessages.Num() > NumPreviousMessages));
+			}
+		} // namespace ReplayFarm
+	} // namespace AutoReplay
+} // namespace JT
@@ -0,0 +1,73 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FSocket;
+
+/**
+ * Messages between the replay farm orchestrator and its workers are single lines of utf8 text, sent over a
+ * localhost tcp connection:
+ *
+ * [Type] [Payload]\n
+ *
+ * Payloads are condensed (single line) json.
+ *
+ * Worker -> Orchestrator:
+ *   HELLO [WorkerId]				  sent once connected. The worker is then idle
+ *   RESULT [FJTInputBatchResult]	  sent once a session has finished. The worker is then idle
+ *
+ * Orchestrator -> Worker:
+ *   RUN [FJTInputBatchEntry]		  play the given session. Only ever sent to idle workers
+ *   EXIT							  exit the process
+ */
+namespace JT
+{
+	namespace AutoReplay
+	{
+		namespace ReplayFarm
+		{
+			static const FString HelloMessage = TEXT("HELLO");
+			static const FString ResultMessage = TEXT("RESULT");
+			static const FString RunMessage = TEXT("RUN");
+			static const FString ExitMessage = TEXT("EXIT");
+
+			struct FMessage
+			{
+				FString Type;
+				FString Payload;
+			};
+
+			/**
+			 * A non-blocking, line-framed message connection over a tcp socket. Not thread safe
+			 */
+			class FConnection
+			{
+			public:
+				/** Takes ownership of the given (connected) socket */
+				explicit FConnection(FSocket* InSocket);
+				~FConnection();
+
+				/** Connects to the given ip:port, blocking until connected. @return null if the connection could not be made */
+				static TUniquePtr<FConnection> Connect(const FString& InAddress);
+
+				/** Sends a single message, blocking until it has been fully sent. @return false if the connection was lost */
+				bool Send(const FString& InType, const FString& InPayload = FString());
+
+				/**
+				 * Reads all fully received messages, without blocking. A close by the other side counts as losing the connection.
+				 * @return false if the connection was lost (messages received before it was are still returned first)
+				 */
+				bool Receive(TArray<FMessage>& OutMessages);
+
+				bool IsConnected() const { return bIsConnected; }
+
+			private:
+				FSocket* Socket = nullptr;
+				TArray<uint8> ReceiveBuffer;
+				bool bIsConnected = true;
+			};
+		} // namespace ReplayFarm
+	} // namespace AutoReplay
+} // namespace JT
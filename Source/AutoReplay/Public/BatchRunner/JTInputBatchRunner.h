@@ -0,0 +1,293 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "InputPlayer/JTInputPlayer.h"
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+
+#include "JTInputBatchRunner.generated.h"
+
+AUTOREPLAY_API DECLARE_LOG_CATEGORY_EXTERN(LogJTInputBatchRunner, Log, All);
+
+namespace JT { namespace AutoReplay { namespace ReplayFarm { class FConnection; } } }
+
+/**
+ * A single session to replay as part of a batch
+ */
+USTRUCT(BlueprintType)
+struct FJTInputBatchEntry
+{
+	GENERATED_BODY()
+
+public:
+	/** The recorded session to play (absolute, or relative to the recording session export directory) */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	FString SessionFile;
+
+	/** The map to open before playing the session. If empty, the batch's default map is used (or the current map is kept) */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	FString Map;
+
+	/** The frame of the recording to start playing from */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	int32 StartFrame = 0;
+
+	/** The number of times to play the session */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	int32 NumTimesToPlay = 1;
+
+	/** If true, all players will be restored to the transforms they held at the time of recording */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	bool bRestorePlayerSpatialDataOnStart = true;
+
+	/** If positive, the session is stopped and counted as failed once it has run for this long */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	float TimeoutSeconds = 0.f;
+
+	/** If true, the per-frame performance of the session is captured (see FJTInputPlayerRequestParams::bCapturePerformance) */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	bool bCapturePerformance = false;
+
+	/**
+	 * If true, the session is stopped and counted as failed as soon as playback diverges from the recording's
+	 * spatial checkpoints (see FJTInputPlayerRequestParams::bDetectDivergence). Otherwise the divergence is
+	 * only noted in the result
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	bool bFailOnDivergence = false;
+
+	/** How far the engine steps each frame while playing (see FJTInputPlayerRequestParams::TimeStep) */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	EJTInputPlaybackTimeStep TimeStep = EJTInputPlaybackTimeStep::Variable;
+
+	/** If true, the session is played as fast as possible with world rendering off (see FJTInputPlayerRequestParams::bTurbo) */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	bool bTurbo = false;
+};
+
+/**
+ * A set of sessions to replay, one after another. Stored as json
+ */
+USTRUCT(BlueprintType)
+struct FJTInputBatchManifest
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	TArray<FJTInputBatchEntry> Sessions;
+
+	/** The map to open for sessions that don't name their own */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	FString DefaultMap;
+};
+
+/**
+ * The outcome of replaying a single session of a batch
+ */
+USTRUCT(BlueprintType)
+struct FJTInputBatchResult
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FString SessionFile;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FString Map;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	bool bSucceeded = false;
+
+	/** Why the session failed, if it did */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FString FailureReason;
+
+	/** The wall time (in seconds) from the play request until the session stopped, including loading it */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	double WallTimeSeconds = 0.0;
+
+	/** The number of frames from the start of the session until it stopped */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int64 NumFrames = 0;
+
+	/** The number of input events injected */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int64 NumEvents = 0;
+
+	/** Where the per-frame performance capture of the session was written, if it was captured */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FString PerfCaptureFile;
+
+	/** The replay farm worker that played the session, if it was played as part of a farm */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 WorkerId = INDEX_NONE;
+
+	/** Whether or not playback diverged from the recording's spatial checkpoints */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	bool bDiverged = false;
+
+	/** Where playback first diverged from the recording, if it did */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FJTInputPlaybackDivergence Divergence;
+};
+
+/**
+ * The machine readable summary of a whole batch, written as json once the batch finishes
+ */
+USTRUCT(BlueprintType)
+struct FJTInputBatchSummary
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	TArray<FJTInputBatchResult> Results;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 NumSucceeded = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 NumFailed = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	double TotalWallTimeSeconds = 0.0;
+};
+
+/**
+ * Used to define how a batch of sessions should be run
+ */
+USTRUCT(BlueprintType)
+struct FJTInputBatchRequestParams
+{
+	GENERATED_BODY()
+
+public:
+	/** A manifest json file (see FJTInputBatchManifest), or a directory whose .json/.jtirs sessions should all be played */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	FString Source;
+
+	/** The map to open for sessions that don't name their own (overrides the manifest's default map) */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	FString DefaultMap;
+
+	/** Where to write the batch summary json. Defaults to {Project}/Saved/AutoReplay/ */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	FString SummaryFilePath;
+
+	/** If true, the process exits once the batch finishes, with a non-zero exit code if any session failed */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	bool bExitWhenFinished = false;
+};
+
+/**
+ * The input batch runner subsystem replays a whole corpus of recorded sessions unattended, one after another,
+ * each in a freshly opened map. Every session is driven through the world's UJTInputPlayer, and a summary of
+ * the outcome of each is written once the batch finishes.
+ *
+ * Batches can be started from Blueprint/code, with jt.autoreplay.batchrunner.run (e.g. through -ExecCmds),
+ * or from the command line with -JTReplayBatch=<manifest or directory>, optionally along with
+ * -JTReplayMap=<default map> and -JTReplaySummary=<summary file path>. Batches started from the command line
+ * exit the process once finished.
+ *
+ * Processes started with -JTReplayWorker=<ip:port> and -JTReplayWorkerId=<id> instead run as a replay farm worker
+ * (see UJTReplayFarmCommandlet). Rather than reading a manifest, they connect to the farm orchestrator and play
+ * the sessions it hands out, one at a time, until told to exit.
+ */
+UCLASS(MinimalAPI)
+class UJTInputBatchRunner : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** UGameInstanceSubsystem Interface - BEGIN  */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	/** UGameInstanceSubsystem Interface - END */
+
+	/** FTickableGameObject Interface - BEGIN */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	/** FTickableGameObject Interface - END */
+
+	/** Call to start running a batch of sessions */
+	UFUNCTION(BlueprintCallable, Category = "Scripting")
+	AUTOREPLAY_API bool RunBatch(const FJTInputBatchRequestParams RequestParams);
+
+	/** Call to stop an ongoing batch. A summary of the sessions run so far is still written */
+	UFUNCTION(BlueprintCallable, Category = "Scripting")
+	AUTOREPLAY_API void CancelBatch();
+
+	/** @return whether or not a batch is running */
+	UFUNCTION(BlueprintPure, Category = "Scripting")
+	bool IsRunningBatch() const { return (State != EState::Idle); }
+
+	/** Reads the sessions to run out of a manifest json file, or a directory of session files */
+	AUTOREPLAY_API static bool LoadManifest(const FString& InSource, FJTInputBatchManifest& OutManifest);
+
+	/** Writes the given summary as json to the given path */
+	AUTOREPLAY_API static bool SaveSummary(const FJTInputBatchSummary& InSummary, const FString& InFilePath);
+
+private:
+	enum class EState : uint8
+	{
+		Idle,
+		LoadingMap,
+		PendingPlay,
+		Playing
+	};
+
+	void StartNextSession();
+	void StartPlayingCurrentSession();
+	void TickCurrentSession();
+	void FinishCurrentSession(bool bSucceeded, const FString& InFailureReason);
+	void FinishBatch();
+	void UnbindInputPlayer();
+	void OnPostLoadMap(UWorld* InLoadedWorld);
+	void OnTravelFailure(UWorld* InWorld, ETravelFailure::Type InFailureType, const FString& InErrorString);
+	bool IsReplayFarmWorker() const { return !ReplayFarmAddress.IsEmpty(); }
+	void TickReplayFarmWorker();
+
+	UFUNCTION()
+	void OnInputPlayerStarted();
+
+	UFUNCTION()
+	void OnInputPlayerStopped();
+
+	UFUNCTION()
+	void OnInputPlayerFailedToLoadSession(const FString& FilePath);
+
+	UFUNCTION()
+	void OnInputPlayerFailedToStart(const FString& FilePath);
+
+	UFUNCTION()
+	void OnInputPlayerDiverged(const FJTInputPlaybackDivergence& Divergence);
+
+private:
+	FJTInputBatchRequestParams CachedCurrentRequestParams;
+	FJTInputBatchManifest CurrentManifest;
+	FJTInputBatchSummary CurrentSummary;
+	TWeakObjectPtr<UJTInputPlayer> CurrentInputPlayer;
+	FJTInputBatchRequestParams PendingCommandLineRequestParams;
+	FDelegateHandle PostLoadMapHandle;
+	FDelegateHandle TravelFailureHandle;
+	TSharedPtr<JT::AutoReplay::ReplayFarm::FConnection> ReplayFarmConnection;
+	FString ReplayFarmAddress;
+	int32 ReplayFarmWorkerId = INDEX_NONE;
+	EState State = EState::Idle;
+	int32 CurrentEntryIndex = INDEX_NONE;
+	double BatchStartTime = 0.0;
+	double SessionStartTime = 0.0;
+	uint64 SessionStartFrame = 0;
+	bool bHasPendingCommandLineBatch = false;
+	bool bHasCurrentSessionStopped = false;
+	bool bHasCurrentSessionFailedToLoad = false;
+	bool bHasCurrentSessionFailedToStart = false;
+};
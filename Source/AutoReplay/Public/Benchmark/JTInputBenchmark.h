@@ -0,0 +1,199 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "JTInputBenchmark.generated.h"
+
+AUTOREPLAY_API DECLARE_LOG_CATEGORY_EXTERN(LogJTInputBenchmark, Log, All);
+
+struct FJTInputRecordingSession;
+
+/**
+ * Used to define the shape of the synthetic session a benchmark is run against
+ */
+USTRUCT(BlueprintType)
+struct FJTInputBenchmarkParams
+{
+	GENERATED_BODY()
+
+public:
+	/** The number of frames the session lasts (36000 is 10 minutes at 60fps) */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Session", meta = (ClampMin = "1"))
+	int32 DurationFrames = 36000;
+
+	/** The average number of input events recorded each frame, per player */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Session", meta = (ClampMin = "0"))
+	float EventsPerFrame = 4.f;
+
+	/** The fraction (0 to 1) of recorded events that are axis events rather than key events */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Session", meta = (ClampMin = "0", ClampMax = "1"))
+	float AxisEventRatio = 0.5f;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Session", meta = (ClampMin = "1"))
+	int32 NumPlayers = 1;
+
+	/** The seed the session is generated from, so that runs across builds measure the exact same session */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Session")
+	int32 Seed = 0;
+
+	/** The number of times each measurement is repeated. The median of the repeats is reported */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Benchmark", meta = (ClampMin = "1"))
+	int32 NumIterations = 3;
+};
+
+/**
+ * The export and import throughput of a single file format
+ */
+USTRUCT(BlueprintType)
+struct FJTInputBenchmarkFormatResult
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FString Format;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int64 FileBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	double ExportSeconds = 0.0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	double ImportSeconds = 0.0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	double ExportMegabytesPerSecond = 0.0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	double ImportMegabytesPerSecond = 0.0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	double ExportEventsPerSecond = 0.0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	double ImportEventsPerSecond = 0.0;
+
+	/** The number of bytes allocated by the imported session */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int64 ImportedSessionAllocatedBytes = 0;
+
+	/** The growth in used physical memory over importing the session, measured while the imported session is still alive */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int64 ImportUsedPhysicalBytes = 0;
+
+	/** What the first difference between the exported and imported session was, if they were not the same */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FString RoundTripMismatch;
+
+	/** Whether or not the imported session had the same content (frame by frame, and every other track) as the exported one */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	bool bRoundTripped = false;
+};
+
+/**
+ * The machine readable outcome of a benchmark run, written as json so results can be tracked across builds
+ */
+USTRUCT(BlueprintType)
+struct FJTInputBenchmarkReport
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FString Timestamp;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FString BuildVersion;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FString Platform;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FJTInputBenchmarkParams Params;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 NumFrames = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 NumEvents = 0;
+
+	/** The average cost (in nanoseconds) of recording a single event through FJTInputRecordingSession */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	double RecordNanosecondsPerEvent = 0.0;
+
+	/** The number of timeline allocations made while recording the session */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int64 RecordTimelineAllocations = 0;
+
+	/** The number of bytes allocated by the recorded session */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int64 SessionAllocatedBytes = 0;
+
+	/** The growth in used physical memory over recording the session, measured while the recorded session is still alive */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int64 RecordUsedPhysicalBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	TArray<FJTInputBenchmarkFormatResult> Formats;
+
+	/** A human readable line for every measurement that regressed against the baseline report (if one was given) */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	TArray<FString> Regressions;
+};
+
+/**
+ * Measures how recording and serialization scale with session size, against synthetic sessions of a given shape.
+ *
+ * Sessions are recorded through FJTInputRecordingSession exactly as the input recorder does, with keys pressed and
+ * released in pairs and axes moved every so often, so the timeline and key table look like those of a real capture.
+ * They also carry start data, spatial checkpoints, delta times and random seeds, so every track is serialized.
+ */
+class AUTOREPLAY_API FJTInputBenchmark
+{
+public:
+	/** Records a synthetic session of the given shape. The same params always generate the same session */
+	static void GenerateSession(const FJTInputBenchmarkParams& InParams, FJTInputRecordingSession& OutSession);
+
+	/**
+	 * Compares two sessions frame by frame (key, event type, flags, controller id and payload of every event) along
+	 * with their start data, spatial checkpoints, delta times and random seeds. Spatial data and delta times are
+	 * compared to within the precision the binary format quantizes them to
+	 *
+	 * @param OutMismatch a readable description of the first difference found
+	 *
+	 * @return whether or not the sessions are the same
+	 */
+	static bool CompareSessions(const FJTInputRecordingSession& InExpected, const FJTInputRecordingSession& InActual, FString& OutMismatch);
+
+	/** Runs the benchmark, exporting and importing the session in every file format */
+	static bool Run(const FJTInputBenchmarkParams& InParams, FJTInputBenchmarkReport& OutReport);
+
+	/**
+	 * Adds a regression to the given report for every throughput, cost or allocated size that got worse than the
+	 * baseline report by more than the given percentage
+	 *
+	 * @return whether or not any measurement regressed
+	 */
+	static bool CompareToBaseline(const FJTInputBenchmarkReport& InBaselineReport, float InMaxRegressionPercent, FJTInputBenchmarkReport& InOutReport);
+
+	static bool SaveReport(const FJTInputBenchmarkReport& InReport, const FString& InFilePath);
+	static bool LoadReport(const FString& InFilePath, FJTInputBenchmarkReport& OutReport);
+
+	/** Logs a readable summary of the given report */
+	static void LogReport(const FJTInputBenchmarkReport& InReport);
+
+	/**
+	 * Runs the benchmark, compares it against the baseline report (if given), then logs and saves the report.
+	 * Shared by the benchmark commandlet and automation tests
+	 *
+	 * @return whether or not every session round tripped without regressing against the baseline
+	 */
+	static bool RunAndReport(const FJTInputBenchmarkParams& InParams, const FString& InBaselineFilePath, float InMaxRegressionPercent,
+		const FString& InReportFilePath, FJTInputBenchmarkReport& OutReport);
+
+	/** @return a timestamped file path in {Project}/Saved/AutoReplay/Benchmarks/ */
+	static FString MakeDefaultReportFilePath();
+};
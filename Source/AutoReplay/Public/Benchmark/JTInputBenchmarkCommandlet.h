@@ -0,0 +1,32 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "JTInputBenchmarkCommandlet.generated.h"
+
+/**
+ * Benchmarks recording and serialization against a synthetic session (see FJTInputBenchmark), e.g.
+ *
+ * UnrealEditor-Cmd MyGame.uproject -run=JTInputBenchmark -Frames=216000 -EventsPerFrame=8 -Players=2 -Report=Benchmark.json
+ *
+ * Any of the FJTInputBenchmarkParams can be overridden: -Frames= -EventsPerFrame= -AxisRatio= -Players= -Seed= -Iterations=
+ * Pass -Baseline=<report json> (and optionally -MaxRegressionPercent=, 10 by default) to compare against a previous run.
+ *
+ * Returns a non-zero exit code if a session did not round trip, or if the run regressed against the baseline.
+ * The same benchmark runs under the AutoReplay.Benchmark automation tests (see JTInputBenchmarkTests.cpp).
+ */
+UCLASS()
+class UJTInputBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UJTInputBenchmarkCommandlet();
+
+	/** UCommandlet Interface - BEGIN */
+	virtual int32 Main(const FString& Params) override;
+	/** UCommandlet Interface - END */
+};
@@ -0,0 +1,67 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "JTAutoReplayCommonTypes.h"
+
+#include "Async/Future.h"
+
+/**
+ * The performance of a single frame of playback
+ */
+struct FJTInputPerfSample
+{
+	/** The frame (relative to the start of the recording) the sample was taken on */
+	FJTFrameDelta Frame = 0;
+
+	/** The index of the latest timeline frame played by this frame (its inputs were injected on Frame if their frame deltas match) */
+	int32 TimelineFrameIndex = INDEX_NONE;
+
+	/** Which time the recording was being played (0 for the first) */
+	int32 PlayIndex = 0;
+
+	/** The number of input events injected on this frame */
+	int32 NumInjectedEvents = 0;
+
+	/** The wall time of the whole frame */
+	float FrameTimeMs = 0.f;
+
+	/** Game, render and RHI thread times (excluding idle time), and the GPU time, as reported by stat unit. These trail by a frame */
+	float GameThreadTimeMs = 0.f;
+	float RenderThreadTimeMs = 0.f;
+	float RHIThreadTimeMs = 0.f;
+	float GPUTimeMs = 0.f;
+
+	/** The physical memory used by the process */
+	uint64 UsedPhysicalMemory = 0;
+};
+
+/**
+ * A per-frame performance capture of a play session, stored as csv (one row per frame of playback)
+ */
+struct AUTOREPLAY_API FJTInputPerfCapture
+{
+public:
+	/** The session that was played */
+	FString SessionFilePath;
+
+	TArray<FJTInputPerfSample> Samples;
+
+public:
+	/** Clears all samples, and reserves enough for the given number of frames so that sampling doesn't allocate */
+	void Reset(const FString& InSessionFilePath, int32 InExpectedNumFrames);
+
+	/** Takes a sample of the current frame */
+	void AddSample(FJTFrameDelta InFrame, int32 InTimelineFrameIndex, int32 InPlayIndex, int32 InNumInjectedEvents);
+
+	bool IsEmpty() const { return Samples.IsEmpty(); }
+
+	bool SaveToCsv(const FString& InFilePath) const;
+	static bool LoadFromCsv(const FString& InFilePath, FJTInputPerfCapture& OutCapture);
+
+	/** Writes the given capture to disk on a background thread */
+	static TFuture<bool> SaveToCsvAsync(const FString& InFilePath, FJTInputPerfCapture&& InCapture);
+
+	/** @return the default file path to write a capture of the given session to, {Project}/Saved/AutoReplay/PerfCaptures/ */
+	static FString MakeDefaultFilePath(const FString& InSessionFilePath);
+};
@@ -0,0 +1,133 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "JTAutoReplayCommonTypes.h"
+
+#include "Containers/ArrayView.h"
+#include "GameFramework/PlayerInput.h"
+#include "Misc/Optional.h"
+
+class FSceneViewport;
+
+/**
+ * A recording session compiled down into a flat list of ready-to-inject input operations.
+ *
+ * Compiling (which can happen on any thread) expands every timeline event into an op holding its
+ * FKey and event data, and gathers the distinct controller ids the session uses. Binding the program
+ * (on the game thread, once per play) then remaps each controller id to its input device a single time,
+ * so playing a frame is a plain loop over its ops. Ops only hold a single FKey each, and the
+ * FInputKeyEventArgs/FInputKeyParams to inject are built from them on the stack as they are played.
+ */
+class AUTOREPLAY_API FJTInputPlaybackProgram
+{
+public:
+	struct FOp
+	{
+		FKey Key;
+
+		/** Index into the program's controller table */
+		int32 ControllerSlot = INDEX_NONE;
+
+		/** Resolved when the program is bound */
+		FInputDeviceId InputDevice = INPUTDEVICEID_NONE;
+
+		/** Key op data */
+		float AmountDepressed = 0.f;
+
+		/** Axis op data */
+		float Delta = 0.f;
+		float DeltaTime = 0.f;
+		int32 NumSamples = 0;
+
+		EJTInputEventType EventType = EJTInputEventType::Invalid;
+
+		/** Key op data */
+		TEnumAsByte<EInputEvent> Event = IE_Pressed;
+		bool bIsTouchEvent = false;
+
+		/** Axis op data */
+		bool bGamepad = false;
+
+		/** @return the params to inject the op straight into a player controller, overriding its key event if given */
+		FORCEINLINE FInputKeyParams MakeInputKeyParams(TOptional<EInputEvent> InEventOverride = {}) const
+		{
+			if (EventType == EJTInputEventType::Key)
+			{
+				return FInputKeyParams(Key, InEventOverride.Get(Event), static_cast<double>(AmountDepressed), Key.IsGamepadKey(), InputDevice);
+			}
+
+			return FInputKeyParams(Key, static_cast<double>(Delta), DeltaTime, NumSamples, bGamepad, InputDevice);
+		}
+
+		/** @return the args to inject the key op through the game viewport client, overriding its key event if given */
+		FORCEINLINE FInputKeyEventArgs MakeKeyEventArgs(FViewport* InViewport, int32 InControllerId, TOptional<EInputEvent> InEventOverride = {}) const
+		{
+			return FInputKeyEventArgs(InViewport, InControllerId, Key, InEventOverride.Get(Event), AmountDepressed, bIsTouchEvent);
+		}
+	};
+
+	struct FFrame
+	{
+		FJTFrameDelta FrameDelta = 0;
+		int32 FirstOpIndex = 0;
+		int32 NumOps = 0;
+	};
+
+public:
+	/** Compiles the given session. Safe to call from any thread */
+	static TSharedRef<FJTInputPlaybackProgram> Compile(const TSharedRef<const FJTInputRecordingSession>& InSession);
+
+	/**
+	 * Resolves the program's input devices for playing into the given viewport (which can be null when
+	 * playing without one). Must be called on the game thread before the program is played
+	 */
+	void Bind(FSceneViewport* InViewport);
+
+	/** @return whether the program has been bound to the given viewport */
+	bool IsBoundTo(const FSceneViewport* InViewport) const { return bIsBound && (BoundViewport == InViewport); }
+
+	/** @return the session the program was compiled from */
+	const FJTInputRecordingSession& GetSession() const { return *Session; }
+
+	FORCEINLINE int32 Num() const { return Frames.Num(); }
+	FORCEINLINE bool IsValidIndex(int32 FrameIndex) const { return Frames.IsValidIndex(FrameIndex); }
+	FORCEINLINE const FFrame& operator[](int32 FrameIndex) const { return Frames[FrameIndex]; }
+
+	FORCEINLINE TArrayView<const FOp> GetFrameOps(int32 FrameIndex) const
+	{
+		const FFrame& Frame = Frames[FrameIndex];
+		return MakeArrayView(Ops.GetData() + Frame.FirstOpIndex, Frame.NumOps);
+	}
+
+	FORCEINLINE int32 NumControllers() const { return ControllerIds.Num(); }
+	FORCEINLINE int32 GetControllerId(int32 ControllerSlot) const { return ControllerIds[ControllerSlot]; }
+
+	/** @return the index of the first frame at or after the given frame delta (or Num() if there is none) */
+	int32 FindFrameIndex(FJTFrameDelta InFrameDelta) const;
+
+	/**
+	 * Replays the key ops of all frames before the given frame to work out which keys are still held down going into it
+	 *
+	 * @param OutHeldKeyOps the op that pressed each key that is still held, in the order they were pressed
+	 */
+	void GatherHeldKeyOps(int32 InFrameIndex, TArray<const FOp*>& OutHeldKeyOps) const;
+
+	/** @return the number of bytes allocated by the program (not including its session) */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	int32 FindOrAddControllerSlot(int32 InControllerId);
+
+private:
+	TSharedPtr<const FJTInputRecordingSession> Session;
+
+	TArray<FFrame> Frames;
+	TArray<FOp> Ops;
+
+	/** The distinct controller ids used by the session */
+	TArray<int32> ControllerIds;
+
+	const FSceneViewport* BoundViewport = nullptr;
+	bool bIsBound = false;
+};
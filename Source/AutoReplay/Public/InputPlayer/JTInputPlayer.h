@@ -3,7 +3,10 @@
 #pragma once
 
 #include "JTAutoReplayCommonTypes.h"
+#include "InputPlayer/JTInputPerfCapture.h"
+#include "InputPlayer/JTInputPlaybackProgram.h"
 
+#include "Async/Future.h"
 #include "Engine/TimerHandle.h"
 #include "Subsystems/WorldSubsystem.h"
 
@@ -11,9 +14,78 @@
 
 AUTOREPLAY_API DECLARE_LOG_CATEGORY_EXTERN(LogJTInputPlayer, Log, All);
 
+class FSceneViewport;
 class FViewport;
+class APlayerController;
+class UGameViewportClient;
+
+/**
+ * Where (and how far) playback drifted from the recording, as measured against one of its spatial checkpoints
+ */
+USTRUCT(BlueprintType)
+struct FJTInputPlaybackDivergence
+{
+	GENERATED_BODY()
+
+public:
+	/** The frame (relative to the start of the recording) of the checkpoint playback diverged from */
+	UPROPERTY(BlueprintReadOnly, Category = "Divergence")
+	int32 Frame = INDEX_NONE;
+
+	/** The index of the player that diverged, or INDEX_NONE if the number of players no longer matches the recording */
+	UPROPERTY(BlueprintReadOnly, Category = "Divergence")
+	int32 PlayerIndex = INDEX_NONE;
+
+	/** The distance between the pawn's live and recorded locations */
+	UPROPERTY(BlueprintReadOnly, Category = "Divergence")
+	float PositionError = 0.f;
+
+	/** The largest angle (in degrees) between the live and recorded pawn and control rotations */
+	UPROPERTY(BlueprintReadOnly, Category = "Divergence")
+	float RotationError = 0.f;
+};
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FJTInputPlayerDelegate);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FJTInputPlayerFailedDelegate, const FString&, FilePath);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FJTInputPlayerDivergedDelegate, const FJTInputPlaybackDivergence&, Divergence);
+
+/**
+ * Used to define how played input is fed into the game
+ */
+UENUM(BlueprintType)
+enum class EJTInputInjectionMode : uint8
+{
+	/** Inject through the game viewport when there is one, and straight into the player controllers otherwise */
+	Automatic,
+
+	/** Inject through the game viewport client, exactly as live input arrives */
+	Viewport,
+
+	/**
+	 * Inject straight into each local player's controller. Works without a viewport (e.g. with -nullrhi or in
+	 * headless builds), but skips any input handling done by the viewport client itself (e.g. Slate/UI)
+	 */
+	PlayerController
+};
+
+/**
+ * Used to define how far the engine steps each frame while input is played
+ */
+UENUM(BlueprintType)
+enum class EJTInputPlaybackTimeStep : uint8
+{
+	/** Step by however long each frame actually took, as in live play */
+	Variable,
+
+	/**
+	 * Step each frame by the delta time it had while recording, so movement and physics advance exactly as they did.
+	 * Frames the recording has no delta time for (e.g. older recordings) are stepped by FixedTimeStepSeconds
+	 */
+	Recorded,
+
+	/** Step every frame by FixedTimeStepSeconds */
+	Fixed
+};
 
 /**
  * Used to define how an input play session should be conducted
@@ -39,6 +111,81 @@ public:
 	/** The number of times to play the recording (if negative, will be looped infinitely) */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
 	int32 NumTimesToPlay = 1;
+
+	/**
+	 * The frame (relative to the start of the recording) to start playing from. Keys held down at that
+	 * point of the recording are pressed on start. Applies to every time the recording is played
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters", meta = (ClampMin = "0"))
+	int32 StartFrame = 0;
+
+	/**
+	 * If true and the recording has spatial checkpoints, seeking (including to StartFrame) snaps back to the last
+	 * checkpoint before the target frame and restores every player to it, so playback resumes from the recorded state
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	bool bRestoreSpatialCheckpointOnSeek = true;
+
+	/**
+	 * If true and the recording captured random seeds, the global random number generators and every stream registered
+	 * with FJTRandomStreamRegistry are reseeded on start, so gameplay draws the same random values it did while
+	 * recording. Only exact when playing from the start of the recording
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	bool bRestoreRandomSeeds = true;
+
+	/**
+	 * If true and the recording has spatial checkpoints, every player's pawn is compared against them as playback
+	 * runs, and OnPlaybackDiverged is called (once per play) when one drifts out of tolerance
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Divergence")
+	bool bDetectDivergence = true;
+
+	/** How far a pawn can be from its recorded location before playback counts as diverged */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Divergence", meta = (ClampMin = "0", EditCondition = "bDetectDivergence"))
+	float DivergencePositionTolerance = 50.f;
+
+	/** How far (in degrees) a pawn or its control rotation can be from its recorded rotation before playback counts as diverged */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Divergence", meta = (ClampMin = "0", EditCondition = "bDetectDivergence"))
+	float DivergenceRotationTolerance = 10.f;
+
+	/** If true, the request is stopped (including any remaining loops) as soon as playback diverges */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Divergence", meta = (EditCondition = "bDetectDivergence"))
+	bool bStopOnDivergence = false;
+
+	/** How the played input is fed into the game */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	EJTInputInjectionMode InjectionMode = EJTInputInjectionMode::Automatic;
+
+	/**
+	 * How far the engine steps each frame while playing. Anything but Variable puts the engine on a fixed time step
+	 * for the whole request, which makes replays reproducible across machines regardless of how fast they run
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Time Step")
+	EJTInputPlaybackTimeStep TimeStep = EJTInputPlaybackTimeStep::Variable;
+
+	/** The delta time (in seconds) frames are stepped by in Fixed mode (or Variable mode in turbo), and the fallback in Recorded mode */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Time Step", meta = (ClampMin = "0.0001", EditCondition = "TimeStep != EJTInputPlaybackTimeStep::Variable || bTurbo"))
+	float FixedTimeStepSeconds = (1.f / 60.f);
+
+	/**
+	 * If true, the session is simulated as fast as the CPU allows: world rendering is turned off, the frame rate is
+	 * uncapped (no smoothing, fixed frame rate, max fps or vsync) and a Variable TimeStep is played as Fixed instead.
+	 * Everything is restored once the request stops. Also turned on by jt.autoreplay.inputplayer.turbo
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Time Step")
+	bool bTurbo = false;
+
+	/**
+	 * If true, the performance of every frame of playback (frame, thread and GPU times, memory) is captured, keyed to
+	 * the frames of the recording, and written as csv once the request finishes (across all times it is played)
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Performance")
+	bool bCapturePerformance = false;
+
+	/** Where to write the performance capture. Defaults to {Project}/Saved/AutoReplay/PerfCaptures/ */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Performance")
+	FString PerfCaptureFilePath;
 };
 
 /**
@@ -67,6 +214,38 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Scripting")
 	AUTOREPLAY_API void StopPlaying();
 
+	/**
+	 * Call to jump an ongoing play session to the given frame (relative to the start of the recording), either
+	 * forwards or backwards. All held keys are released, and the keys held down at that point of the recording are pressed
+	 *
+	 * @return whether or not a session was playing to seek in
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Scripting")
+	AUTOREPLAY_API bool SeekToFrame(int32 Frame);
+
+	/** @return the frame (relative to the start of the recording) the ongoing play session is at, or INDEX_NONE if not playing */
+	UFUNCTION(BlueprintPure, Category = "Scripting")
+	AUTOREPLAY_API int32 GetCurrentFrame() const;
+
+	/** @return whether or not a session is playing, or is about to (e.g. still loading or waiting on its start delay) */
+	UFUNCTION(BlueprintPure, Category = "Scripting")
+	bool IsPlaying() const { return (bCurrentlyPlayingSession || bHasPendingPlayRequest); }
+
+	/** @return the number of input events injected since the last play request (across all loops of it) */
+	int64 GetNumInjectedEvents() const { return NumInjectedEvents; }
+
+	/** @return where the performance capture of the last (or ongoing) play request is written, or empty if it wasn't captured */
+	const FString& GetPerfCaptureFilePath() const { return CurrentPerfCaptureFilePath; }
+
+	/**
+	 * @return the number of bytes allocated by the player, i.e. its playback program and performance capture.
+	 * The recorded session being played is shared with FJTInputSessionCache, so is accounted for there
+	 */
+	AUTOREPLAY_API SIZE_T GetAllocatedSize() const;
+
+	/** Adds a breakdown of where the player's memory is going to the given report */
+	AUTOREPLAY_API void GetMemoryReport(FJTAutoReplayMemoryReport& OutReport) const;
+
 public:
 	/** Called when a new play session is started */
 	UPROPERTY(BlueprintAssignable, Category = "Events")
@@ -76,23 +255,82 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Events")
 	FJTInputPlayerDelegate OnStoppedPlaying;
 
+	/** Called when the recorded session for a play request could not be loaded */
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FJTInputPlayerFailedDelegate OnFailedToLoadSession;
+
+	/**
+	 * Called when a loaded session could not be started (e.g. there was nothing to play input into, or spatial data
+	 * could not be restored), including on later loops of a request. The request is abandoned when this is called
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FJTInputPlayerFailedDelegate OnFailedToStartPlaying;
+
+	/** Called the first time (per play, or since the last seek) live pawn state drifts out of tolerance of the recording's spatial checkpoints */
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FJTInputPlayerDivergedDelegate OnPlaybackDiverged;
+
 private:
 	void StartPlaying();
+	void TryStartPlaying();
+	void OnStartDelayElapsed();
+	void TickPendingSessionLoad();
+	void CancelPendingPlayRequest();
 	void RequestPlay_Internal(const FJTInputPlayerRequestParams& RequestParams, bool bShouldResetExistingRequest);
 	void StopPlaying_Internal(bool bShouldResetExistingRequest);
+	void ResetPlayRequest();
+	void FailPlayRequest(const FJTInputPlayerFailedDelegate& InFailureDelegate);
 	void TickCurrentSession();
-	bool TryRestorePlayerSpatialData();
+	void SeekToFrame_Internal(FJTFrameDelta InFrameDelta);
+	void TickDivergenceDetection();
+	void ApplyTimeStep();
+	void RestoreTimeStep();
+	void BeginTurbo();
+	void EndTurbo();
+	bool MeasureDivergence(int32 InCheckpointIndex, FJTInputPlaybackDivergence& OutDivergence) const;
+	bool TryBindInputTarget();
+	bool TryBindPlayerControllers();
+	void InjectKeyPress(const FJTInputPlaybackProgram::FOp& InKeyOp);
+	void BeginPerfCapture();
+	void FinishPerfCapture();
+	bool TryRestorePlayerSpatialData(TArrayView<const FJTPlayerSpatialData> InPlayersSpatialData);
 	void StopOngoingInput();
 	void ResetStartTimerHandle();
 	void DrawDebug() const;
 
 private:
 	FJTInputPlayerRequestParams CachedCurrentRequestParams;
-	FJTInputRecordingSession CurrentSession;
+	TSharedPtr<FJTInputPlaybackProgram> CurrentProgram;
+	TFuture<TSharedPtr<FJTInputPlaybackProgram>> PendingSessionLoad;
+	TWeakObjectPtr<UGameViewportClient> CachedGameViewportClient;
+	FSceneViewport* CachedGameViewport = nullptr;
+	TArray<TWeakObjectPtr<APlayerController>> ControllerSlotPlayerControllers;
 	FTimerHandle CurrentSessionStartTimerHandle;
+	FJTInputPerfCapture CurrentPerfCapture;
+	FString CurrentPerfCaptureFilePath;
+	TArray<TFuture<bool>> PendingPerfCaptureWrites;
+	TWeakObjectPtr<UGameViewportClient> TurboGameViewportClient;
 	uint64 SessionStartFrame = 0;
 	uint64 SessionStopFrame = 0;
 	int32 LastTimelineEventIndex = INDEX_NONE;
 	int32 CurrentRecordingPlayCount = 0;
+	int64 NumInjectedEvents = 0;
+	int32 NumFrameInjectedEvents = 0;
+	int32 NextDivergenceCheckpointIndex = 0;
+	double PreviousFixedDeltaTime = 0.0;
+	float PreviousMaxFPS = 0.f;
+	int32 PreviousVSync = 0;
 	bool bCurrentlyPlayingSession = false;
+	bool bHasDiverged = false;
+	bool bIsOverridingTimeStep = false;
+	bool bWasUsingFixedTimeStep = false;
+	bool bIsInTurbo = false;
+	bool bWasWorldRenderingDisabled = false;
+	bool bWasSmoothingFrameRate = false;
+	bool bWasUsingFixedFrameRate = false;
+	bool bIsCapturingPerf = false;
+	bool bIsInjectingIntoPlayerControllers = false;
+	bool bHasPendingPlayRequest = false;
+	bool bIsLoadingSession = false;
+	bool bIsStartDelayElapsed = false;
 };
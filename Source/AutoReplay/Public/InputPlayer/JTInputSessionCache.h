@@ -0,0 +1,90 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "JTAutoReplayCommonTypes.h"
+
+#include "Async/Future.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/Paths.h"
+
+/**
+ * A process-wide, least-recently-used cache of decoded recording sessions, shared by all input players
+ * across all worlds. Looped and repeated replays of the same file only pay the read and decode cost once.
+ *
+ * Entries are keyed by the session's resolved file path along with the modification time and size of every
+ * file it was read from (i.e. every linked segment of a streamed session), so re-recording over an existing
+ * file or appending segments to it invalidates its cached session. The cache is bounded by the
+ * SessionCacheBudgetMegabytes project setting.
+ *
+ * All functions are thread safe.
+ */
+class AUTOREPLAY_API FJTInputSessionCache
+{
+public:
+	static FJTInputSessionCache& Get();
+
+	/**
+	 * Loads the given recording session on a background thread, returning the cached session if it is up to date
+	 *
+	 * @param InFilePath the file path where the recording session is stored
+	 *
+	 * @return a future that is fulfilled with the loaded session, or null if it could not be loaded
+	 */
+	TFuture<TSharedPtr<const FJTInputRecordingSession>> LoadSessionAsync(const FFilePath& InFilePath);
+
+	/**
+	 * Loads the given recording session on the calling thread, returning the cached session if it is up to date
+	 *
+	 * @param InFilePath the file path where the recording session is stored
+	 *
+	 * @return the loaded session, or null if it could not be loaded
+	 */
+	TSharedPtr<const FJTInputRecordingSession> LoadSession(const FFilePath& InFilePath);
+
+	/** Removes all cached sessions. Sessions currently being played are kept alive by their players */
+	void Empty();
+
+	/** @return the number of bytes used by all cached sessions */
+	int64 GetCachedBytes() const;
+
+	/** @return the number of cached sessions */
+	int32 Num() const;
+
+private:
+	struct FFileStamp
+	{
+		FString FilePath;
+		FDateTime ModificationTime;
+		int64 FileSize = 0;
+
+		bool operator==(const FFileStamp& Other) const
+		{
+			return (FilePath == Other.FilePath) && (ModificationTime == Other.ModificationTime) && (FileSize == Other.FileSize);
+		}
+	};
+
+	struct FEntry
+	{
+		FString FilePath;
+
+		/** One stamp per file the session was read from, starting with the file at FilePath */
+		TArray<FFileStamp> FileStamps;
+
+		int64 SessionBytes = 0;
+		TSharedPtr<const FJTInputRecordingSession> Session;
+	};
+
+	/** @return whether the given file exists, filling in its current stamp if so */
+	static bool TryStampFile(const FString& InFilePath, FFileStamp& OutFileStamp);
+
+	TSharedPtr<const FJTInputRecordingSession> Find(const FString& InFilePath);
+	void Add(FEntry&& InEntry);
+	void TrimToBudget(int64 InBudgetBytes);
+
+private:
+	/** Ordered from least to most recently used */
+	TArray<FEntry> Entries;
+	int64 CachedBytes = 0;
+	mutable FCriticalSection EntriesCriticalSection;
+};
@@ -0,0 +1,110 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "JTAutoReplayCommonTypes.h"
+
+#include <atomic>
+
+/**
+ * A single input event waiting in an FJTInputCaptureQueue. Trivially copyable, so that pushing one is a plain copy
+ */
+struct FJTCapturedInputEvent
+{
+public:
+	/** The GFrameCounter the event was captured on */
+	uint64 FrameCounter = 0;
+
+	/** The event's key. Only interned into a timeline once the event is drained */
+	FName KeyName;
+
+	/** The packed event. Its KeyIndex is unused until the event is drained */
+	FJTInputTimelineEvent Event;
+};
+
+/**
+ * A bounded, lock-free, multi-producer single-consumer queue of captured input events.
+ *
+ * Producers (on any thread) claim a slot with a single compare and swap and copy their event into it, so capturing
+ * never locks or allocates. The consumer drains events in the order their slots were claimed. When the queue is
+ * full, new events are dropped (and counted) rather than blocking the producer
+ */
+class AUTOREPLAY_API FJTInputCaptureQueue
+{
+public:
+	/** @param InCapacity the number of events the queue can hold. Rounded up to a power of two */
+	explicit FJTInputCaptureQueue(int32 InCapacity);
+
+	FJTInputCaptureQueue(const FJTInputCaptureQueue&) = delete;
+	FJTInputCaptureQueue& operator=(const FJTInputCaptureQueue&) = delete;
+
+	/**
+	 * Pushes an event onto the queue. Thread safe
+	 *
+	 * @return false if the queue was full and the event was dropped
+	 */
+	bool Enqueue(const FJTCapturedInputEvent& InEvent);
+
+	/** Packs the given key event and pushes it onto the queue, stamped with the current GFrameCounter. Thread safe */
+	bool EnqueueKey(const FJTInputKeyEventArgs& InKeyEventArgs);
+
+	/** Packs the given axis event and pushes it onto the queue, stamped with the current GFrameCounter. Thread safe */
+	bool EnqueueAxis(const FJTInputAxisEventArgs& InAxisEventArgs);
+
+	/**
+	 * Pops every event that has been fully pushed, in order, handing each to the given functor. Must only ever be
+	 * called from a single thread at a time
+	 *
+	 * @return the number of events drained
+	 */
+	template<typename FunctorType>
+	int32 Drain(FunctorType&& InFunctor)
+	{
+		int32 NumDrained = 0;
+		for (;;)
+		{
+			FSlot& Slot = Slots[DequeuePosition & Mask];
+			if (Slot.Sequence.load(std::memory_order_acquire) != (DequeuePosition + 1))
+			{
+				break;
+			}
+
+			InFunctor(static_cast<const FJTCapturedInputEvent&>(Slot.Event));
+
+			// Hands the slot back to producers for the next lap around the ring
+			Slot.Sequence.store(DequeuePosition + Mask + 1, std::memory_order_release);
+			++DequeuePosition;
+			++NumDrained;
+		}
+
+		return NumDrained;
+	}
+
+	FORCEINLINE int32 GetCapacity() const { return static_cast<int32>(Mask + 1); }
+
+	/** @return the number of events dropped because the queue was full, since it was created */
+	FORCEINLINE uint64 GetNumDroppedEvents() const { return NumDroppedEvents.load(std::memory_order_relaxed); }
+
+	/** @return the number of bytes allocated by the queue */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FSlot
+	{
+		/**
+		 * Equal to the slot's position when it is free to be claimed by a producer, and to its position + 1
+		 * once an event has been pushed into it and it is ready to be drained
+		 */
+		std::atomic<uint64> Sequence = 0;
+		FJTCapturedInputEvent Event;
+	};
+
+private:
+	TUniquePtr<FSlot[]> Slots;
+	uint64 Mask = 0;
+
+	/** Producers and the consumer each get their own cache line, so that they don't contend over the positions */
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> EnqueuePosition = 0;
+	alignas(PLATFORM_CACHE_LINE_SIZE) uint64 DequeuePosition = 0;
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint64> NumDroppedEvents = 0;
+};
@@ -0,0 +1,133 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "JTAutoReplayCommonTypes.h"
+
+#include "JTInputFlightRecorder.generated.h"
+
+/**
+ * Used to define how much input the flight recorder holds on to
+ */
+USTRUCT(BlueprintType)
+struct FJTInputFlightRecorderParams
+{
+	GENERATED_BODY()
+
+public:
+	/** How much of the most recent input (in seconds) is kept */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Window", meta = (ClampMin = "1"))
+	float WindowSeconds = 60.f;
+
+	/** If positive, the window is this many frames instead of WindowSeconds */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Window", meta = (ClampMin = "0"))
+	int32 WindowFrames = 0;
+
+	/**
+	 * The number of spatial snapshots taken over the window. A dumped window starts at the oldest snapshot still
+	 * in it, so more snapshots keep the dumped window closer to its full length
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Window", meta = (ClampMin = "1"))
+	int32 NumSnapshotsPerWindow = 12;
+
+	/**
+	 * The number of events the buffer holds. The buffer is allocated up front and never grows, so once it is
+	 * full the oldest events are overwritten, even if they are still within the window
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Memory", meta = (ClampMin = "1"))
+	int32 MaxEvents = 65536;
+
+	/** Whether or not the window is dumped when the game crashes */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Dumping")
+	bool bDumpOnCrash = true;
+
+	/** Whether or not the window is dumped when an ensure fails */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Dumping")
+	bool bDumpOnEnsure = true;
+};
+
+/**
+ * Keeps a rolling window of the most recent input in a fixed size ring buffer, so that recording can be left on
+ * (e.g. in QA builds) at a flat memory cost, and the lead up to a crash or bug can be dumped as a playable session.
+ *
+ * Spatial snapshots of the players are taken at regular intervals over the window, along with the keys held down
+ * at the time. A dumped session starts at the oldest snapshot whose input is still fully in the buffer, with the
+ * keys that were held down pressed on its first frame, so it plays back from a valid starting state
+ */
+class AUTOREPLAY_API FJTInputFlightRecorder
+{
+public:
+	explicit FJTInputFlightRecorder(const FJTInputFlightRecorderParams& InParams);
+
+	/** Records an already packed event on the given frame. The event's KeyIndex is ignored, since the key is interned here */
+	void RecordEvent(uint64 InFrame, const FKey& InKey, const FJTInputTimelineEvent& InEvent);
+
+	/** @return whether or not it's time for the next spatial snapshot */
+	bool IsSnapshotDue() const;
+
+	void TakeSnapshot(const FJTPlayersSpatialDataCollection& InPlayersSpatialDataCollection);
+
+	/**
+	 * Builds a playable session out of the input in the window, from its oldest valid snapshot up to the current frame
+	 *
+	 * @return false if there is no valid snapshot to start the session from (e.g. more than MaxEvents events were
+	 *		   recorded since the last one)
+	 */
+	bool BuildSession(FJTInputRecordingSession& OutSession) const;
+
+	const FJTInputFlightRecorderParams& GetParams() const { return Params; }
+
+	/** @return the number of events currently in the buffer */
+	int32 NumBufferedEvents() const { return NumEvents; }
+
+	/** @return the number of bytes allocated by the buffer and its snapshots */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FEntry
+	{
+		uint64 Frame = 0;
+		FJTInputTimelineEvent Event;
+	};
+
+	struct FHeldKey
+	{
+		FJTInputKeyIndex KeyIndex = 0;
+		int32 ControllerId = 0;
+		int32 InputDeviceId = 0;
+	};
+
+	struct FSnapshot
+	{
+		uint64 Frame = 0;
+		double Seconds = 0.0;
+		FDateTime DateTime;
+		FJTPlayersSpatialDataCollection PlayersSpatialDataCollection;
+		TArray<FHeldKey> HeldKeys;
+	};
+
+private:
+	FEntry& AddEntry(uint64 InFrame);
+	void UpdateHeldKeys(const FJTInputTimelineEvent& InKeyEvent);
+	bool IsSnapshotValid(const FSnapshot& InSnapshot) const;
+
+private:
+	FJTInputFlightRecorderParams Params;
+
+	/** Only used to intern the keys of buffered events. Keys are never evicted, but there are only ever a handful of them */
+	FJTInputTimeline KeyTable;
+
+	TArray<FEntry> Events;
+	int32 NextEventIndex = 0;
+	int32 NumEvents = 0;
+
+	/** The frame of the newest event that was overwritten before it left the window */
+	uint64 LastOverwrittenFrame = 0;
+	bool bHasOverwrittenEvents = false;
+
+	TArray<FHeldKey> HeldKeys;
+
+	TArray<FSnapshot> Snapshots;
+	int32 NextSnapshotIndex = 0;
+	int32 NumSnapshots = 0;
+};
@@ -3,16 +3,22 @@
 #pragma once
 
 #include "JTAutoReplayCommonTypes.h"
+#include "InputRecorder/JTInputCaptureQueue.h"
+#include "InputRecorder/JTInputFlightRecorder.h"
+#include "InputSerializer/JTInputSessionStreamWriter.h"
 
 #include "Engine/TimerHandle.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "Tickable.h"
 
+#include <atomic>
+
 #include "JTInputRecorder.generated.h"
 
 AUTOREPLAY_API DECLARE_LOG_CATEGORY_EXTERN(LogJTInputRecorder, Log, All);
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FJTInputRecorderDelegate);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FJTInputRecorderExportDelegate, bool, bSuccess, const FString&, FilePath);
 
 /**
  * Used to define how an input recording session should be conducted
@@ -23,7 +29,7 @@ struct FJTInputRecorderRequestParams
 	GENERATED_BODY()
 
 public:
-	/** The file path to where the recording should be saved */
+	/** The file path to where the recording should be saved (the extension picks the format, e.g. .json or .jtirs) */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
 	FFilePath RecordingFilePath = FFilePath();
 
@@ -34,6 +40,63 @@ public:
 	/** Whether or not inputs should be recorded when the game is paused */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
 	bool bRecordInputWhenGamePaused = false;
+
+	/**
+	 * If positive, the spatial state (pawn transform, control rotation and velocity) of every player is checkpointed
+	 * every this many frames, so that playback can tell where it drifted from the recording and seek to a known state
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters", meta = (ClampMin = "0"))
+	int32 SpatialCheckpointIntervalFrames = 60;
+
+	/**
+	 * If true, the global random number generators are reseeded as recording starts, and their seed is recorded along
+	 * with the seed of every stream registered with FJTRandomStreamRegistry, so that playback can restore them
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Parameters")
+	bool bCaptureRandomSeeds = true;
+
+	/**
+	 * If true, finished timeline frames are flushed to disk in the background while recording instead of being held
+	 * in memory until recording stops. Streamed sessions are always saved in the binary (.jtirs) format
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Streaming")
+	bool bStreamToDisk = false;
+
+	/** The number of finished timeline frames to hold in memory before flushing them to disk (only used when streaming) */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Streaming", meta = (ClampMin = "1", EditCondition = "bStreamToDisk"))
+	int32 StreamChunkFrameCount = 600;
+
+	/** If positive, a streamed recording starts a new segment file every this many minutes */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Streaming", meta = (ClampMin = "0", EditCondition = "bStreamToDisk"))
+	float MaxSegmentDurationMinutes = 0.f;
+
+	/** If positive, a streamed recording starts a new segment file once the current one is this many megabytes */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Streaming", meta = (ClampMin = "0", EditCondition = "bStreamToDisk"))
+	float MaxSegmentSizeMegabytes = 0.f;
+
+	/**
+	 * If true, the recording is streamed to disk as a journal: every flushed chunk is committed with a checksum and
+	 * handed to the OS right away, so that a crash mid-recording only loses the input since the last commit. Recover
+	 * a cut off journal with jt.autoreplay.inputrecorder.recoverjournal (or FJTInputSerializer::RecoverSessionFromBinary).
+	 * Implies bStreamToDisk
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Streaming")
+	bool bJournal = false;
+
+	/** The longest (in seconds) a journaled recording goes without a commit, even if StreamChunkFrameCount hasn't been reached */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Streaming", meta = (ClampMin = "0", EditCondition = "bJournal"))
+	float JournalCommitIntervalSeconds = 1.f;
+
+	/**
+	 * The number of timeline frames to allocate up front when recording starts. Recording only allocates
+	 * once this is exceeded, so it should cover the session (or a streamed chunk) to keep the recording hot path allocation free
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Performance", meta = (ClampMin = "0"))
+	int32 TimelineFrameCapacityHint = 3600;
+
+	/** The number of timeline events to allocate up front when recording starts (see TimelineFrameCapacityHint) */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Performance", meta = (ClampMin = "0"))
+	int32 TimelineEventCapacityHint = 16384;
 };
 
 /**
@@ -65,6 +128,28 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Scripting")
 	AUTOREPLAY_API void StopRecording();
 
+	/**
+	 * Starts keeping a rolling window of the most recent input (see FJTInputFlightRecorder), independently of
+	 * any recording session. Restarts the flight recorder (dropping its window) if it was already running
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Scripting")
+	AUTOREPLAY_API void StartFlightRecorder(const FJTInputFlightRecorderParams FlightRecorderParams);
+
+	UFUNCTION(BlueprintCallable, Category = "Scripting")
+	AUTOREPLAY_API void StopFlightRecorder();
+
+	UFUNCTION(BlueprintPure, Category = "Scripting")
+	bool IsFlightRecording() const { return FlightRecorder.IsValid(); }
+
+	/**
+	 * Writes the flight recorder's window out as a playable session, in the background (see OnRecordingExported)
+	 *
+	 * @param FilePath where to write the session. A timestamped path under FlightRecorder/ is generated if empty
+	 * @return whether or not there was a window to write
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Scripting")
+	AUTOREPLAY_API bool DumpFlightRecorder(const FFilePath FilePath);
+
 public:
 	/** Called when a new recording session is started */
 	UPROPERTY(BlueprintAssignable, Category = "Events")
@@ -74,6 +159,37 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Events")
 	FJTInputRecorderDelegate OnStoppedRecording;
 
+	/**
+	 * Called once a stopped recording session has finished being written to disk in the background,
+	 * with whether or not it was written successfully and the final path it was written to
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FJTInputRecorderExportDelegate OnRecordingExported;
+
+	/**
+	 * Captures a key event into the current recording session and/or the flight recorder. Thread safe, so input can be
+	 * fed in from outside the game viewport (e.g. raw input plugins, device threads or input preprocessors).
+	 * The event is stamped with the current frame and written into the recording when the recorder next ticks
+	 *
+	 * @return false if nothing is being recorded, or the capture queue was full
+	 */
+	AUTOREPLAY_API bool CaptureKeyInput(const FJTInputKeyEventArgs& InKeyEventArgs);
+
+	/** Captures an axis event. Thread safe (see CaptureKeyInput) */
+	AUTOREPLAY_API bool CaptureAxisInput(const FJTInputAxisEventArgs& InAxisEventArgs);
+
+	/** @return the number of events recorded in the current (or last) recording session */
+	uint64 GetNumRecordedEvents() const { return NumRecordedEvents; }
+
+	/** @return the number of timeline allocations made since the current (or last) recording session started */
+	AUTOREPLAY_API uint64 GetNumTimelineAllocations() const;
+
+	/** @return the number of bytes allocated by the recorder, i.e. the current (or last) recording session and its timeline pool */
+	AUTOREPLAY_API SIZE_T GetAllocatedSize() const;
+
+	/** Adds a breakdown of where the recorder's memory is going to the given report */
+	AUTOREPLAY_API void GetMemoryReport(FJTAutoReplayMemoryReport& OutReport) const;
+
 protected:
 	void RecordKeyInput(const FInputKeyEventArgs& EventArgs);
 
@@ -89,15 +205,61 @@ protected:
 
 private:
 	void StartRecording();
+	void GatherPlayersSpatialData(FJTPlayersSpatialDataCollection& OutPlayersSpatialDataCollection) const;
+	void DrainCaptureQueue();
+	void TickFlightRecorder();
+	void TickSpatialCheckpoints();
+	void ReserveSpatialCheckpoints(int32 InNumFrames);
+	bool DumpFlightRecorder_Internal(const FFilePath& InFilePath, bool bShouldWaitForExport);
+	void OnSystemError();
+	void OnSystemEnsure();
+	void StartStreaming();
+	void FlushFramesToStream(bool bIncludeCurrentFrame);
+	void ExportCurrentSession();
+	void TickPendingExports();
+	void WaitForPendingExports();
+	void TickProfiling();
 	void UpdateEventArgsDelegates(bool bShouldBind);
 	void ResetStartTimerHandle();
 	bool DetermineIfKeyShouldBeRecorded(const FKey& Key, const TEnumAsByte<EInputEvent> InputEvent);
 	void DrawDebug() const;
 
+private:
+	/** An export of a stopped recording session that is still being written to disk in the background */
+	struct FJTPendingExport
+	{
+		TFuture<FJTInputSessionExportResult> ExportFuture;
+
+		/** Kept alive until a streamed session has finished writing */
+		TUniquePtr<FJTInputSessionStreamWriter> StreamWriter;
+	};
+
 private:
 	FJTInputRecorderRequestParams CachedCurrentRequestParams;
 	FJTInputRecordingSession CurrentRecordingSession;
+	TUniquePtr<FJTInputSessionStreamWriter> CurrentStreamWriter;
+	TSharedPtr<FJTInputTimelinePool> CurrentTimelinePool;
+	TArray<FJTPendingExport> PendingExports;
+	TUniquePtr<FJTInputCaptureQueue> CaptureQueue;
+	TUniquePtr<FJTInputFlightRecorder> FlightRecorder;
+	FJTPlayersSpatialDataCollection FlightRecorderSnapshotSpatialData;
+	FJTPlayersSpatialDataCollection SpatialCheckpointData;
+	FDelegateHandle SystemErrorDelegateHandle;
+	FDelegateHandle SystemEnsureDelegateHandle;
 	FTimerHandle CurrentSessionStartTimerHandle;
+	/** The earliest frame a drained event can be recorded on, so that events are always recorded in frame order */
+	uint64 CaptureFloorFrame = 0;
+	uint64 LastNumDroppedCaptureEvents = 0;
+	uint64 NumRecordedEvents = 0;
+	uint64 LastTickNumRecordedEvents = 0;
+	uint64 SessionStartNumTimelineAllocations = 0;
+	uint64 SessionStopNumTimelineAllocations = 0;
+	double LastStreamFlushSeconds = 0.0;
+	FJTFrameDelta NextSpatialCheckpointFrameDelta = 0;
 	bool bIsCurrentlyRecording = false;
 	bool bIsCurrentlyEscaped = false;
+	bool bHasPendingFlightRecorderStart = false;
+
+	/** Whether or not captured input is queued. Read by producers on any thread */
+	std::atomic<bool> bIsCapturingInput = false;
 };
@@ -4,14 +4,83 @@
 
 #include "JTAutoReplayCommonTypes.h"
 
+#include "Async/Future.h"
 #include "Misc/Paths.h"
 #include "UObject/SoftObjectPath.h"
 
 AUTOREPLAY_API DECLARE_LOG_CATEGORY_EXTERN(LogJTInputSerializer, Log, All);
 
+class FJTInputSessionStreamWriter;
+struct FJTInputSessionStreamParams;
+
+/**
+ * The outcome of an asynchronous session export
+ */
+struct FJTInputSessionExportResult
+{
+	/** Whether or not the session exported successfully */
+	bool bSuccess = false;
+
+	/** The final path (including export directory and extension) the session was exported to */
+	FString FilePath;
+};
+
 class FJTInputSerializer
 {
 public:
+	/**
+	 * Exports the given recording session to a file. The format is picked from the file's extension
+	 * (.json or .jtirs), falling back to the default format in the project settings
+	 *
+	 * @param InFilePath the file path where the session will be exported
+	 * @param InSession the recording session to export
+	 *
+	 * @return whether or not the session exported successfully
+	 */
+	AUTOREPLAY_API static bool ExportSession(const FFilePath& InFilePath, const FJTInputRecordingSession& InSession);
+
+	/**
+	 * Exports the given recording session at the default file path, in the default format
+	 *
+	 * @param InSession the recording session to export
+	 *
+	 * @return whether or not the session exported successfully
+	 */
+	AUTOREPLAY_API static bool ExportSessionWithDefaultPath(const FJTInputRecordingSession& InSession);
+
+	/**
+	 * Exports the given recording session to a file on a background thread. The session is moved into the
+	 * export task, so no copy of the (potentially large) timeline is made on the calling thread
+	 *
+	 * @param InFilePath the file path where the session will be exported (autogenerated if empty)
+	 * @param InSession the recording session to export
+	 *
+	 * @return a future that is fulfilled once the session has been written
+	 */
+	AUTOREPLAY_API static TFuture<FJTInputSessionExportResult> ExportSessionAsync(const FFilePath& InFilePath, FJTInputRecordingSession&& InSession);
+
+	/**
+	 * Imports the given recording session from a file. The format is picked from the file's extension
+	 * (.json or .jtirs), falling back to the default format in the project settings
+	 *
+	 * @param InFilePath the file path where the recording session is stored
+	 * @param OutSession the recording session to import
+	 * @param OutSegmentFilePaths if given, filled with the path of every linked segment file a binary session was read from
+	 *
+	 * @return whether or not the session imported successfully
+	 */
+	AUTOREPLAY_API static bool ImportSession(const FFilePath& InFilePath, FJTInputRecordingSession& OutSession, TArray<FString>* OutSegmentFilePaths = nullptr);
+
+	/**
+	 * Imports the given recording session from a file on a background thread, so that neither the file read
+	 * nor the decode stall the calling thread
+	 *
+	 * @param InFilePath the file path where the recording session is stored
+	 *
+	 * @return a future that is fulfilled with the imported session, or null if it could not be imported
+	 */
+	AUTOREPLAY_API static TFuture<TSharedPtr<FJTInputRecordingSession>> ImportSessionAsync(const FFilePath& InFilePath);
+
 	/**
 	 * Exports the given recording session to a json file
 	 *
@@ -41,6 +110,68 @@ public:
 	 */
 	AUTOREPLAY_API static bool ImportSessionFromJson(const FFilePath& InJsonFilePath, FJTInputRecordingSession& OutSession);
 
+	/**
+	 * Exports the given recording session to a compact binary file
+	 *
+	 * @param InBinaryFilePath the file path where the binary session will be exported
+	 * @param InSession the recording session to export
+	 *
+	 * @return whether or not the session exported successfully
+	 */
+	AUTOREPLAY_API static bool ExportSessionToBinary(const FFilePath& InBinaryFilePath, const FJTInputRecordingSession& InSession);
+
+	/**
+	 * Imports the given recording session from a compact binary file
+	 *
+	 * @param InBinaryFilePath the file path where the binary session is stored
+	 * @param OutSession the recording session to import
+	 * @param OutSegmentFilePaths if given, filled with the path of every linked segment file the session was read from
+	 *
+	 * @return whether or not the session imported successfully
+	 */
+	AUTOREPLAY_API static bool ImportSessionFromBinary(const FFilePath& InBinaryFilePath, FJTInputRecordingSession& OutSession, TArray<FString>* OutSegmentFilePaths = nullptr);
+
+	/**
+	 * Recovers as much as possible of a journaled binary session that was never finished (e.g. because the game
+	 * crashed while recording it), i.e. everything up to its last intact commit. Complete sessions are read as is
+	 *
+	 * @param InBinaryFilePath the file path of the (first segment of the) journaled session
+	 * @param OutSession the recovered session. Its stop data is filled in from the last recovered frame if it was lost
+	 * @param bOutWasComplete set if the session was complete, i.e. nothing had to be dropped
+	 *
+	 * @return whether or not anything could be recovered
+	 */
+	AUTOREPLAY_API static bool RecoverSessionFromBinary(const FFilePath& InBinaryFilePath, FJTInputRecordingSession& OutSession, bool& bOutWasComplete);
+
+	/**
+	 * Creates a writer that streams a recording session to a (set of) binary file(s) while it is being recorded
+	 *
+	 * @param InBinaryFilePath the file path of the first segment of the session (autogenerated if empty)
+	 * @param InStreamParams how the session should be chunked and split into segments
+	 *
+	 * @return the stream writer, or null if no valid path could be constructed
+	 */
+	AUTOREPLAY_API static TUniquePtr<FJTInputSessionStreamWriter> CreateSessionStreamWriter(
+		const FFilePath& InBinaryFilePath,
+		const FJTInputSessionStreamParams& InStreamParams);
+
+	/**
+	 * Resolves the given file path to the final path a session would be exported to or imported from
+	 * (i.e. prefixed with the export directory and suffixed with the extension of its format)
+	 *
+	 * @return whether or not a final path could be constructed
+	 */
+	AUTOREPLAY_API static bool TryResolveFilePath(const FFilePath& InFilePath, FFilePath& OutFinalPath);
+
+	/** @return the file format a session at the given path is serialized with */
+	AUTOREPLAY_API static EJTInputRecordingFileFormat GetFileFormatForPath(const FFilePath& InFilePath);
+
+	/** @return the file extension (without the leading dot) used for the given format */
+	AUTOREPLAY_API static const FString& GetFileExtensionForFormat(EJTInputRecordingFileFormat InFileFormat);
+
 private:
-	static bool TryConstructFinalPath(const FFilePath& InJsonFilePath, FFilePath& OutFinalPath);
+	static FFilePath MakeDefaultFilePath();
+	static bool TryConstructFinalPath(const FFilePath& InFilePath, const FString& InFileExtension, FFilePath& OutFinalPath);
+	static bool ReadBinarySegments(const FString& InFirstSegmentPath, bool bShouldRecover, FJTInputRecordingSession& OutSession, bool& bOutWasComplete,
+		TArray<FString>* OutSegmentFilePaths = nullptr);
 };
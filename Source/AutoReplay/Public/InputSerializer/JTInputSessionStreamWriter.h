@@ -0,0 +1,117 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "JTAutoReplayCommonTypes.h"
+#include "InputSerializer/JTInputSerializer.h"
+
+#include "Misc/Paths.h"
+#include "Tasks/Pipe.h"
+#include "Templates/UniquePtr.h"
+
+#include <atomic>
+
+class FArchive;
+
+/**
+ * Used to define how a streamed recording session is split into segment files
+ */
+struct AUTOREPLAY_API FJTInputSessionStreamParams
+{
+	/** If positive, a new segment file is started once the current one has been open for this long */
+	double MaxSegmentDurationSeconds = 0.0;
+
+	/** If positive, a new segment file is started once the current one has grown past this size */
+	int64 MaxSegmentSizeBytes = 0;
+
+	/** If set, the storage of appended frames is released back to this pool once they have been written */
+	TSharedPtr<FJTInputTimelinePool> TimelinePool;
+
+	/**
+	 * If true, every write is committed with a checksum and flushed out of the process, so that the session can be
+	 * recovered up to its last commit if the game crashes before it ends (see FJTInputSerializer::RecoverSession)
+	 */
+	bool bJournal = false;
+};
+
+/**
+ * Streams a recording session to disk as it is being recorded. Finished timeline frames are handed
+ * over in chunks and written, in order, on a background task so that the recording session never has
+ * to hold more than a chunk's worth of frames in memory.
+ *
+ * The session is written to a linked set of binary segment files (see JTInputBinaryFormat.h) which
+ * FJTInputSerializer::ImportSession reads back as a single session.
+ *
+ * When journaling, each write is staged in memory, then appended to the segment file along with a commit
+ * marker and flushed. Staging keeps the checksum cheap (no re-reading of the file), and commits only ever
+ * cover whole sections, so a crash mid-write only loses the sections since the last commit.
+ *
+ * All public functions are expected to be called from the game thread.
+ */
+class AUTOREPLAY_API FJTInputSessionStreamWriter
+{
+public:
+	FJTInputSessionStreamWriter(const FFilePath& InFilePath, const FJTInputSessionStreamParams& InStreamParams);
+	~FJTInputSessionStreamWriter();
+
+	/** Opens the first segment file and queues the session's start data to be written to it */
+	void BeginSession(const FJTInputRecordingSession& InSession);
+
+	/** Queues the given (finished) timeline frames to be written to the current segment file */
+	void AppendFrames(FJTInputTimeline&& InFrames);
+
+	/** Queues the given spatial checkpoints to be written to the current segment file */
+	void AppendSpatialCheckpoints(FJTSpatialCheckpointTrack&& InCheckpoints);
+
+	/** Queues the given frame delta times to be written to the current segment file */
+	void AppendDeltaTimes(FJTDeltaTimeTrack&& InDeltaTimes);
+
+	/**
+	 * Queues the session's stop data to be written and closes the last segment file
+	 *
+	 * @return a future that is fulfilled once all queued writes have completed. The writer must be
+	 *		   kept alive until then
+	 */
+	TFuture<FJTInputSessionExportResult> EndSession(const FJTInputRecordingSession& InSession);
+
+	/** Blocks until all queued writes have completed */
+	void Flush();
+
+	/** @return whether or not any write has failed. A failed writer drops all subsequent writes */
+	bool HasFailed() const { return bHasFailed; }
+
+	/** @return the path of the first segment file of the session */
+	const FFilePath& GetFilePath() const { return FilePath; }
+
+	/** @return the number of segment files the session has been split into so far */
+	int32 GetNumSegments() const { return (CurrentSegmentIndex + 1); }
+
+private:
+	void RotateSegmentIfNeeded();
+	FString MakeSegmentFilePath(int32 InSegmentIndex) const;
+	void OpenSegment_AnyThread(const FString& InSegmentFilePath);
+	void CloseSegment_AnyThread();
+	void UpdateSegmentState_AnyThread();
+	FArchive& GetSectionArchive_AnyThread();
+	void Commit_AnyThread();
+
+private:
+	FFilePath FilePath;
+	FJTInputSessionStreamParams StreamParams;
+
+	/** Serializes all writes, in the order they were queued */
+	UE::Tasks::FPipe WritePipe;
+	UE::Tasks::FTask LastWriteTask;
+
+	/** Only ever accessed from tasks launched in the write pipe */
+	TUniquePtr<FArchive> SegmentArchive;
+
+	/** Sections written since the last commit, when journaling. Only ever accessed from tasks launched in the write pipe */
+	TArray<uint8> UncommittedBytes;
+	TUniquePtr<FArchive> UncommittedArchive;
+
+	int32 CurrentSegmentIndex = 0;
+	double CurrentSegmentOpenTime = 0.0;
+	std::atomic<int64> CurrentSegmentSize = 0;
+	std::atomic<bool> bHasFailed = false;
+};
@@ -7,8 +7,10 @@
 #include "InputCoreTypes.h"
 #include "InputKeyEventArgs.h"
 #include "Misc/DateTime.h"
+#include "HAL/CriticalSection.h"
 #include "Misc/Paths.h"
 
+#include <atomic>
 #include <type_traits>
 
 #include "JTAutoReplayCommonTypes.generated.h"
@@ -113,52 +115,268 @@ enum class EJTInputEventType : uint8
 	Invalid = 255
 };
 
+typedef uint32 FJTFrameDelta;
+
+/** Index into the interned key table of an FJTInputTimeline */
+typedef uint16 FJTInputKeyIndex;
+
 /**
- * A single event on an input timeline
+ * A single event on an input timeline. Key and axis events share the same compact storage: the event's
+ * FKey is interned in the owning timeline's key table, and EventType decides which payload is valid
  */
-USTRUCT()
 struct AUTOREPLAY_API FJTInputTimelineEvent
 {
-	GENERATED_BODY()
+public:
+	struct FKeyPayload
+	{
+		int32 InputDeviceId;
+		float AmountDepressed;
+	};
+
+	struct FAxisPayload
+	{
+		float Delta;
+		float DeltaTime;
+		int32 NumSamples;
+	};
+
+	union FPayload
+	{
+		FKeyPayload Key;
+		FAxisPayload Axis;
+	};
+
+	/** Key event flags. The lowest 3 bits hold the EInputEvent */
+	static constexpr uint8 KeyFlag_EventMask = 0x07;
+	static constexpr uint8 KeyFlag_TouchEvent = 0x08;
+
+	/** Axis event flags */
+	static constexpr uint8 AxisFlag_Gamepad = 0x01;
 
 public:
-	FJTInputTimelineEvent() = default;
+	FORCEINLINE EInputEvent GetKeyEvent() const { return static_cast<EInputEvent>(Flags & KeyFlag_EventMask); }
+	FORCEINLINE bool IsTouchEvent() const { return ((Flags & KeyFlag_TouchEvent) != 0); }
+	FORCEINLINE bool IsGamepad() const { return ((Flags & AxisFlag_Gamepad) != 0); }
 
-	FJTInputTimelineEvent(const FJTInputKeyEventArgs& InKeyEventArgs)
-		: KeyEventArgs(InKeyEventArgs)
-		, EventType(EJTInputEventType::Key)
-	{}
+public:
+	FJTInputKeyIndex KeyIndex = 0;
+	EJTInputEventType EventType = EJTInputEventType::Invalid;
+	uint8 Flags = 0;
+	int32 ControllerId = 0;
+	FPayload Payload = {};
+};
 
-	FJTInputTimelineEvent(const FJTInputAxisEventArgs& InAxisEventArgs)
-		: AxisEventArgs(InAxisEventArgs)
-		, EventType(EJTInputEventType::Axis)
-	{}
+/**
+ * A frame on an input timeline, referencing the contiguous range of the timeline's events that occurred on it
+ */
+struct AUTOREPLAY_API FJTInputTimelineFrame
+{
+public:
+	FJTFrameDelta FrameDelta = 0;
+	int32 FirstEventIndex = 0;
+	int32 NumEvents = 0;
+};
 
+/**
+ * The runtime storage of a session's input. All events live in a single contiguous array, ordered by frame,
+ * with each frame holding an offset range into it. FKeys are interned into a per-timeline key table so that
+ * events only carry a small index
+ *
+ * Storage only ever grows in large chunks (or up front through Reserve), so adding an event is allocation free
+ * in the steady state. Every growth of any timeline's storage is counted in GetNumAllocations()
+ */
+struct AUTOREPLAY_API FJTInputTimeline
+{
 public:
-	UPROPERTY()
-	FJTInputKeyEventArgs KeyEventArgs;
+	/** The minimum number of elements storage grows by once it runs out of reserved capacity */
+	static constexpr int32 MinFrameGrowth = 1024;
+	static constexpr int32 MinEventGrowth = 4096;
+	static constexpr int32 MinKeyGrowth = 64;
 
-	UPROPERTY()
-	FJTInputAxisEventArgs AxisEventArgs;
+public:
+	/** @return the number of frames on the timeline */
+	FORCEINLINE int32 Num() const { return Frames.Num(); }
+	FORCEINLINE bool IsEmpty() const { return Frames.IsEmpty(); }
+	FORCEINLINE bool IsValidIndex(int32 FrameIndex) const { return Frames.IsValidIndex(FrameIndex); }
+	FORCEINLINE const FJTInputTimelineFrame& operator[](int32 FrameIndex) const { return Frames[FrameIndex]; }
+	FORCEINLINE const FJTInputTimelineFrame& Last() const { return Frames.Last(); }
+	FORCEINLINE const TArray<FJTInputTimelineFrame>& GetFrames() const { return Frames; }
+
+	FORCEINLINE int32 NumEvents() const { return Events.Num(); }
+	FORCEINLINE const TArray<FJTInputTimelineEvent>& GetEvents() const { return Events; }
+
+	FORCEINLINE TArrayView<const FJTInputTimelineEvent> GetFrameEvents(int32 FrameIndex) const
+	{
+		const FJTInputTimelineFrame& Frame = Frames[FrameIndex];
+		return MakeArrayView(Events.GetData() + Frame.FirstEventIndex, Frame.NumEvents);
+	}
 
-	UPROPERTY()
-	EJTInputEventType EventType = EJTInputEventType::Invalid;
+	FORCEINLINE int32 NumKeys() const { return Keys.Num(); }
+	FORCEINLINE const FKey& GetKey(FJTInputKeyIndex KeyIndex) const { return Keys[KeyIndex]; }
+
+	/** @return the index of the given key in the key table, adding it if it hasn't been seen before */
+	FJTInputKeyIndex InternKey(const FKey& InKey);
+
+	/**
+	 * Appends a new (uninitialized) event at the given frame. Events must be added in non-decreasing frame order
+	 *
+	 * @return the added event
+	 */
+	FORCEINLINE FJTInputTimelineEvent& AddEvent(FJTFrameDelta InFrameDelta)
+	{
+		if (Frames.IsEmpty() || Frames.Last().FrameDelta != InFrameDelta)
+		{
+			if (UNLIKELY(Frames.Num() == Frames.Max()))
+			{
+				GrowFrames();
+			}
+
+			FJTInputTimelineFrame& NewFrame = Frames.AddDefaulted_GetRef();
+			NewFrame.FrameDelta = InFrameDelta;
+			NewFrame.FirstEventIndex = Events.Num();
+		}
+
+		if (UNLIKELY(Events.Num() == Events.Max()))
+		{
+			GrowEvents();
+		}
+
+		++Frames.Last().NumEvents;
+		return Events.AddDefaulted_GetRef();
+	}
+
+	FORCEINLINE void AddKeyEvent(FJTFrameDelta InFrameDelta, const FJTInputKeyEventArgs& InKeyEventArgs)
+	{
+		const FJTInputKeyIndex KeyIndex = InternKey(InKeyEventArgs.Key);
+		PackKeyEvent(KeyIndex, InKeyEventArgs, AddEvent(InFrameDelta));
+	}
+
+	FORCEINLINE void AddAxisEvent(FJTFrameDelta InFrameDelta, const FJTInputAxisEventArgs& InAxisEventArgs)
+	{
+		const FJTInputKeyIndex KeyIndex = InternKey(InAxisEventArgs.Key);
+		PackAxisEvent(KeyIndex, InAxisEventArgs, AddEvent(InFrameDelta));
+	}
+
+	/** Packs the given key event args (whose key has already been interned at the given index) into a timeline event */
+	static FORCEINLINE void PackKeyEvent(FJTInputKeyIndex InKeyIndex, const FJTInputKeyEventArgs& InKeyEventArgs, FJTInputTimelineEvent& OutTimelineEvent)
+	{
+		OutTimelineEvent.KeyIndex = InKeyIndex;
+		OutTimelineEvent.EventType = EJTInputEventType::Key;
+		OutTimelineEvent.Flags = (static_cast<uint8>(InKeyEventArgs.Event.GetValue()) & FJTInputTimelineEvent::KeyFlag_EventMask)
+			| (InKeyEventArgs.bIsTouchEvent ? FJTInputTimelineEvent::KeyFlag_TouchEvent : 0);
+		OutTimelineEvent.ControllerId = InKeyEventArgs.ControllerId;
+		OutTimelineEvent.Payload.Key.InputDeviceId = InKeyEventArgs.InputDevice.GetId();
+		OutTimelineEvent.Payload.Key.AmountDepressed = InKeyEventArgs.AmountDepressed;
+	}
+
+	/** Packs the given axis event args (whose key has already been interned at the given index) into a timeline event */
+	static FORCEINLINE void PackAxisEvent(FJTInputKeyIndex InKeyIndex, const FJTInputAxisEventArgs& InAxisEventArgs, FJTInputTimelineEvent& OutTimelineEvent)
+	{
+		OutTimelineEvent.KeyIndex = InKeyIndex;
+		OutTimelineEvent.EventType = EJTInputEventType::Axis;
+		OutTimelineEvent.Flags = (InAxisEventArgs.bGamepad ? FJTInputTimelineEvent::AxisFlag_Gamepad : 0);
+		OutTimelineEvent.ControllerId = InAxisEventArgs.ControllerId;
+		OutTimelineEvent.Payload.Axis.Delta = InAxisEventArgs.Delta;
+		OutTimelineEvent.Payload.Axis.DeltaTime = InAxisEventArgs.DeltaTime;
+		OutTimelineEvent.Payload.Axis.NumSamples = InAxisEventArgs.NumSamples;
+	}
+
+	/** @return the given key event expanded back into its full event args */
+	FJTInputKeyEventArgs GetKeyEventArgs(const FJTInputTimelineEvent& InTimelineEvent) const;
+
+	/** @return the given axis event expanded back into its full event args */
+	FJTInputAxisEventArgs GetAxisEventArgs(const FJTInputTimelineEvent& InTimelineEvent) const;
+
+	/**
+	 * Moves all frames before the given frame delta out of the timeline. The key table is copied
+	 * over as well, so key indices stay valid in either timeline
+	 *
+	 * When every frame is extracted, the storage of both timelines is swapped instead of copied, so
+	 * extracting into a reserved (e.g. pooled) timeline leaves this one with that reserved capacity
+	 *
+	 * @param OutTimeline an empty timeline to receive the extracted frames
+	 */
+	void ExtractFramesBefore(FJTFrameDelta InFrameDelta, FJTInputTimeline& OutTimeline);
+
+	/** Ensures there is capacity for at least the given number of frames, events and keys */
+	void Reserve(int32 InNumFrames, int32 InNumEvents, int32 InNumKeys = 0);
+
+	/** Removes all frames, events and keys, keeping the allocated memory around for reuse */
+	void Reset();
+
+	/** @return the number of bytes allocated by the timeline's containers */
+	SIZE_T GetAllocatedSize() const;
+
+	/** @return the number of times the storage of any timeline has been (re)allocated since startup */
+	static uint64 GetNumAllocations() { return NumAllocations.load(std::memory_order_relaxed); }
+
+private:
+	FORCENOINLINE void GrowFrames();
+	FORCENOINLINE void GrowEvents();
+
+	static std::atomic<uint64> NumAllocations;
+
+private:
+	TArray<FJTInputTimelineFrame> Frames;
+	TArray<FJTInputTimelineEvent> Events;
+	TArray<FKey> Keys;
+	TMap<FName, FJTInputKeyIndex> KeyIndices;
 };
 
-typedef uint32 FJTFrameDelta;
+/**
+ * A thread safe pool of reserved timelines. Used to hand chunks of recorded frames off (e.g. to a background
+ * writer) and get their storage back once they have been consumed, instead of reallocating it for every chunk
+ */
+class AUTOREPLAY_API FJTInputTimelinePool
+{
+public:
+	FJTInputTimelinePool(int32 InNumFramesPerTimeline, int32 InNumEventsPerTimeline);
 
-USTRUCT()
-struct AUTOREPLAY_API FJTInputTimelineFrame
+	/** @return an empty timeline, reserved to the pool's capacity. Only allocates when the pool has run dry */
+	FJTInputTimeline Acquire();
+
+	/** Empties the given timeline and returns its storage to the pool */
+	void Release(FJTInputTimeline&& InTimeline);
+
+	/** Allocates timelines up front until the pool holds at least the given number of them */
+	void Prewarm(int32 InNumTimelines);
+
+	/** @return the number of bytes allocated by the timelines currently held by the pool */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	int32 NumFramesPerTimeline = 0;
+	int32 NumEventsPerTimeline = 0;
+
+	TArray<FJTInputTimeline> FreeTimelines;
+	mutable FCriticalSection FreeTimelinesCriticalSection;
+};
+
+/**
+ * A named breakdown of the memory used by AutoReplay, for reporting (e.g. with jt.autoreplay.memreport)
+ */
+struct AUTOREPLAY_API FJTAutoReplayMemoryReport
 {
-	GENERATED_BODY()
+public:
+	struct FEntry
+	{
+		FString Name;
+		SIZE_T Bytes = 0;
+	};
+
+	TArray<FEntry> Entries;
 
 public:
-	UPROPERTY()
-	uint32 FrameDelta = 0;
-	ASSERT_ON_VAR_TYPE(FrameDelta, FJTFrameDelta);
+	FORCEINLINE void Add(const FString& InName, SIZE_T InBytes)
+	{
+		Entries.Emplace(FEntry{ InName, InBytes });
+	}
 
-	UPROPERTY()
-	TArray<FJTInputTimelineEvent> FrameEvents;
+	/** @return the sum of all entries */
+	SIZE_T GetTotal() const;
+
+	/** Prints every entry, and the total, to the given output device */
+	void Print(FOutputDevice& InOutputDevice, const TCHAR* InTitle) const;
 };
 
 USTRUCT()
@@ -172,15 +390,167 @@ public:
 
 	UPROPERTY()
 	FRotator ControlRotation = FRotator::ZeroRotator;
+
+	UPROPERTY()
+	FVector Velocity = FVector::ZeroVector;
 };
 
-typedef TArray<FJTInputTimelineFrame> FJTInputTimeline;
 typedef TArray<FJTPlayerSpatialData>  FJTPlayersSpatialDataCollection;
 
+/**
+ * A checkpoint on a spatial checkpoint track, referencing the contiguous range of the track's player data captured on it
+ */
+struct AUTOREPLAY_API FJTSpatialCheckpoint
+{
+public:
+	FJTFrameDelta FrameDelta = 0;
+	int32 FirstPlayerIndex = 0;
+	int32 NumPlayers = 0;
+};
+
+/**
+ * The spatial state (pawn transform, control rotation and velocity) of every player, captured at regular intervals
+ * over a session. Stored as a separate track next to the input timeline, laid out the same way: every player's data
+ * lives in a single contiguous array, with each checkpoint holding an offset range into it
+ */
+struct AUTOREPLAY_API FJTSpatialCheckpointTrack
+{
+public:
+	FORCEINLINE int32 Num() const { return Checkpoints.Num(); }
+	FORCEINLINE bool IsEmpty() const { return Checkpoints.IsEmpty(); }
+	FORCEINLINE bool IsValidIndex(int32 CheckpointIndex) const { return Checkpoints.IsValidIndex(CheckpointIndex); }
+	FORCEINLINE const FJTSpatialCheckpoint& operator[](int32 CheckpointIndex) const { return Checkpoints[CheckpointIndex]; }
+
+	FORCEINLINE TArrayView<const FJTPlayerSpatialData> GetPlayers(int32 CheckpointIndex) const
+	{
+		const FJTSpatialCheckpoint& Checkpoint = Checkpoints[CheckpointIndex];
+		return MakeArrayView(Players.GetData() + Checkpoint.FirstPlayerIndex, Checkpoint.NumPlayers);
+	}
+
+	/**
+	 * Appends a checkpoint at the given frame. Checkpoints must be added in increasing frame order, so one at
+	 * (or before) the frame of the last checkpoint is ignored
+	 */
+	FORCEINLINE void AddCheckpoint(FJTFrameDelta InFrameDelta, TArrayView<const FJTPlayerSpatialData> InPlayers)
+	{
+		if (!Checkpoints.IsEmpty() && Checkpoints.Last().FrameDelta >= InFrameDelta)
+		{
+			return;
+		}
+
+		FJTSpatialCheckpoint& Checkpoint = Checkpoints.AddDefaulted_GetRef();
+		Checkpoint.FrameDelta = InFrameDelta;
+		Checkpoint.FirstPlayerIndex = Players.Num();
+		Checkpoint.NumPlayers = InPlayers.Num();
+
+		Players.Append(InPlayers.GetData(), InPlayers.Num());
+	}
+
+	/** @return the index of the last checkpoint at or before the given frame delta, or INDEX_NONE if there is none */
+	int32 FindCheckpointIndex(FJTFrameDelta InFrameDelta) const;
+
+	/** Ensures there is capacity for at least the given number of checkpoints and player data */
+	void Reserve(int32 InNumCheckpoints, int32 InNumPlayers);
+
+	/** Removes all checkpoints, keeping the allocated memory around for reuse */
+	void Reset();
+
+	/** @return the number of bytes allocated by the track's containers */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	TArray<FJTSpatialCheckpoint> Checkpoints;
+	TArray<FJTPlayerSpatialData> Players;
+};
+
+/**
+ * The delta time (in seconds) of every frame over a session, so that playback can step the game by the same amount
+ * of time on every frame as it was while recording. Frames are contiguous from the track's first frame, so a
+ * frame's delta time is looked up by index rather than searched for
+ */
+struct AUTOREPLAY_API FJTDeltaTimeTrack
+{
+public:
+	FORCEINLINE int32 Num() const { return DeltaSeconds.Num(); }
+	FORCEINLINE bool IsEmpty() const { return DeltaSeconds.IsEmpty(); }
+	FORCEINLINE FJTFrameDelta GetFirstFrameDelta() const { return FirstFrameDelta; }
+
+	/** @return the frame delta just past the last frame on the track */
+	FORCEINLINE FJTFrameDelta GetEndFrameDelta() const { return (FirstFrameDelta + DeltaSeconds.Num()); }
+
+	FORCEINLINE bool HasFrame(FJTFrameDelta InFrameDelta) const
+	{
+		return (InFrameDelta >= FirstFrameDelta) && (InFrameDelta < GetEndFrameDelta());
+	}
+
+	FORCEINLINE float GetDeltaSeconds(FJTFrameDelta InFrameDelta) const { return DeltaSeconds[InFrameDelta - FirstFrameDelta]; }
+
+	/**
+	 * Appends the delta time of the given frame. Frames must be added in increasing order, so one at (or before) the
+	 * last frame is ignored. Frames skipped over (e.g. ones the recorder didn't tick on) repeat the given delta time
+	 */
+	FORCEINLINE void AddFrame(FJTFrameDelta InFrameDelta, float InDeltaSeconds)
+	{
+		if (DeltaSeconds.IsEmpty())
+		{
+			FirstFrameDelta = InFrameDelta;
+		}
+		else if (InFrameDelta < GetEndFrameDelta())
+		{
+			return;
+		}
+
+		const int32 NumNewFrames = (static_cast<int32>(InFrameDelta - GetEndFrameDelta()) + 1);
+		const int32 FirstNewFrameIndex = DeltaSeconds.AddUninitialized(NumNewFrames);
+		for (int32 FrameIndex = FirstNewFrameIndex; FrameIndex < DeltaSeconds.Num(); ++FrameIndex)
+		{
+			DeltaSeconds[FrameIndex] = InDeltaSeconds;
+		}
+	}
+
+	/** Ensures there is capacity for at least the given number of frames */
+	void Reserve(int32 InNumFrames);
+
+	/** Removes all frames, keeping the allocated memory around for reuse */
+	void Reset();
+
+	/** @return the number of bytes allocated by the track */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	FJTFrameDelta FirstFrameDelta = 0;
+	TArray<float> DeltaSeconds;
+};
+
+/**
+ * The seed of a random stream registered with FJTRandomStreamRegistry, as it was when a session started
+ */
+USTRUCT(BlueprintType)
+struct AUTOREPLAY_API FJTRandomStreamSeed
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	FName Name;
+
+	UPROPERTY()
+	int32 Seed = 0;
+};
+
 enum class EJTInputRecordingFormatVersion : uint8
 {
 	Initial = 0,
 
+	/** Adds player velocity to the spatial data and the spatial checkpoint track */
+	SpatialCheckpoints = 1,
+
+	/** Adds the per-frame delta time track */
+	DeltaTimes = 2,
+
+	/** Adds the random seeds captured at the start of the session to the metadata */
+	RandomSeeds = 3,
+
 	Count,
 	Latest = Count - 1
 };
@@ -213,33 +583,127 @@ public:
 	FORCEINLINE void ClearSessionData()
 	{
 		InputTimeline.Reset();
+		SpatialCheckpoints.Reset();
+		DeltaTimes.Reset();
 		PlayersSpatialDataCollection.Reset();
+		RandomStreamSeeds.Reset();
+
+		bHasRandomSeeds = false;
+		RandomSeed = 0;
 
 		StartFrameCounter = 0;
 		StopFrameCounter = 0;
 	}
 
+	/** @return the number of bytes allocated by the session's containers */
+	FORCEINLINE SIZE_T GetAllocatedSize() const
+	{
+		SIZE_T AllocatedSize = InputTimeline.GetAllocatedSize();
+		AllocatedSize += SpatialCheckpoints.GetAllocatedSize();
+		AllocatedSize += DeltaTimes.GetAllocatedSize();
+		AllocatedSize += PlayersSpatialDataCollection.GetAllocatedSize();
+		AllocatedSize += RandomStreamSeeds.GetAllocatedSize();
+		AllocatedSize += StartTime.GetAllocatedSize();
+		AllocatedSize += StopTime.GetAllocatedSize();
+
+		return AllocatedSize;
+	}
+
+	/** Adds the memory used by each part of the session to the given report, with the given prefix */
+	void AppendMemoryReport(const FString& InPrefix, FJTAutoReplayMemoryReport& OutReport) const;
+
+	/**
+	 * Reseeds the global random number generators (FMath::Rand and FMath::SRand) with a fresh seed, and captures it
+	 * along with the current seed of every stream registered with FJTRandomStreamRegistry. Meant to be called as
+	 * the session starts, so that playback can start from the same random state (see RestoreRandomSeeds)
+	 */
+	void CaptureRandomSeeds();
+
+	/**
+	 * Reseeds the global random number generators and registered streams with the seeds captured by CaptureRandomSeeds
+	 *
+	 * @return the number of recorded stream seeds that were restored, or INDEX_NONE if the session has no random seeds
+	 */
+	int32 RestoreRandomSeeds() const;
+
 	FORCEINLINE void RecordKey(const FJTInputKeyEventArgs& InKeyEventArgs)
 	{
-		FJTInputTimelineEvent TimelineEvent(InKeyEventArgs);
-		RecordTimelineEvent(TimelineEvent);
+		InputTimeline.AddKeyEvent(GetCurrentFrameDelta(), InKeyEventArgs);
 	}
 
 	FORCEINLINE void RecordAxis(const FJTInputAxisEventArgs& InAxisEventArgs)
 	{
-		FJTInputTimelineEvent TimelineEvent(InAxisEventArgs);
-		RecordTimelineEvent(TimelineEvent);
+		InputTimeline.AddAxisEvent(GetCurrentFrameDelta(), InAxisEventArgs);
+	}
+
+	/** Records a spatial checkpoint of every player on the current frame */
+	FORCEINLINE void RecordSpatialCheckpoint(const FJTPlayersSpatialDataCollection& InPlayersSpatialDataCollection)
+	{
+		SpatialCheckpoints.AddCheckpoint(GetCurrentFrameDelta(), InPlayersSpatialDataCollection);
+	}
+
+	/** Records the delta time of the current frame */
+	FORCEINLINE void RecordDeltaTime(float InDeltaSeconds)
+	{
+		DeltaTimes.AddFrame(GetCurrentFrameDelta(), InDeltaSeconds);
+	}
+
+	/**
+	 * Records an already packed event on the frame of the given GFrameCounter (e.g. one captured on another thread).
+	 * The event's KeyIndex is ignored, since the key is interned here
+	 */
+	FORCEINLINE void RecordEvent(uint64 InFrameCounter, const FKey& InKey, const FJTInputTimelineEvent& InEvent)
+	{
+		const FJTInputKeyIndex KeyIndex = InputTimeline.InternKey(InKey);
+
+		FJTInputTimelineEvent& TimelineEvent = InputTimeline.AddEvent(static_cast<FJTFrameDelta>(InFrameCounter - StartFrameCounter));
+		TimelineEvent = InEvent;
+		TimelineEvent.KeyIndex = KeyIndex;
+	}
+
+	/**
+	 * Moves recorded frames out of the timeline (e.g. to flush them to disk)
+	 *
+	 * @param bIncludeCurrentFrame if false, the frame for the current GFrameCounter is kept in the
+	 *							   timeline since it can still receive events
+	 * @param OutFrames an empty timeline to receive the extracted frames
+	 */
+	FORCEINLINE void ExtractTimelineFrames(bool bIncludeCurrentFrame, FJTInputTimeline& OutFrames)
+	{
+		InputTimeline.ExtractFramesBefore((bIncludeCurrentFrame ? MAX_uint32 : GetCurrentFrameDelta()), OutFrames);
+	}
+
+	/** @return the frame delta (relative to the start of the session) of the current GFrameCounter */
+	FORCEINLINE FJTFrameDelta GetCurrentFrameDelta() const
+	{
+		return static_cast<FJTFrameDelta>(GFrameCounter - StartFrameCounter);
 	}
 
 public:
-	UPROPERTY()
-	TArray<FJTInputTimelineFrame> InputTimeline;
-	ASSERT_ON_VAR_TYPE(InputTimeline, FJTInputTimeline);
+	/** Not a UPROPERTY. Serialized explicitly by FJTInputSerializer */
+	FJTInputTimeline InputTimeline;
+
+	/** Not a UPROPERTY. Serialized explicitly by FJTInputSerializer */
+	FJTSpatialCheckpointTrack SpatialCheckpoints;
+
+	/** Not a UPROPERTY. Serialized explicitly by FJTInputSerializer */
+	FJTDeltaTimeTrack DeltaTimes;
 
 	UPROPERTY()
 	TArray<FJTPlayerSpatialData> PlayersSpatialDataCollection;
 	ASSERT_ON_VAR_TYPE(PlayersSpatialDataCollection, FJTPlayersSpatialDataCollection);
 
+	/** Whether or not random seeds were captured when the session started (see CaptureRandomSeeds) */
+	UPROPERTY()
+	bool bHasRandomSeeds = false;
+
+	/** The seed the global random number generators were seeded with when the session started */
+	UPROPERTY()
+	int32 RandomSeed = 0;
+
+	UPROPERTY()
+	TArray<FJTRandomStreamSeed> RandomStreamSeeds;
+
 	UPROPERTY()
 	FString StartTime;
 
@@ -254,28 +718,19 @@ public:
 
 	UPROPERTY()
 	uint8 RecordingFormatVersion = 0;
+};
 
-private:
-	FORCEINLINE void RecordTimelineEvent(const FJTInputTimelineEvent& TimelineEvent)
-	{
-		const FJTFrameDelta CurrentTimelineEventFrameDelta = (GFrameCounter - StartFrameCounter);
-
-		if (!InputTimeline.IsEmpty())
-		{
-			const FJTFrameDelta LastTimelineEventFrameDelta = InputTimeline.Last().FrameDelta;
-			if (LastTimelineEventFrameDelta == CurrentTimelineEventFrameDelta)
-			{
-				InputTimeline[InputTimeline.Num() - 1].FrameEvents.Emplace(TimelineEvent);
-				return;
-			}
-		}
-
-		FJTInputTimelineFrame NewTimelineFrame;
-		NewTimelineFrame.FrameDelta = CurrentTimelineEventFrameDelta;
-		NewTimelineFrame.FrameEvents.Emplace(TimelineEvent);
+/**
+ * The on-disk formats a recording session can be serialized to
+ */
+UENUM()
+enum class EJTInputRecordingFileFormat : uint8
+{
+	/** Human readable, reflection-based json (.json) */
+	Json,
 
-		InputTimeline.Emplace(NewTimelineFrame);
-	}
+	/** Compact, versioned binary format (.jtirs) */
+	Binary
 };
 
 UCLASS(config = Plugins, BlueprintType, defaultconfig)
@@ -296,12 +751,42 @@ public:
 	UPROPERTY(EditAnywhere, config, Category = "Input Recording")
 	FString RecordingSessionExportDirectory = FString();
 
+	/**
+	 * The file format used when a recording session is exported without an explicit
+	 * file extension (e.g. with an autogenerated file name)
+	 */
+	UPROPERTY(EditAnywhere, config, Category = "Input Recording")
+	EJTInputRecordingFileFormat DefaultRecordingFileFormat = EJTInputRecordingFileFormat::Json;
+
 	/**
 	 * Can be used to skip input recording for any sequence that
 	 * comes between a pair of this escape key presses
 	 */
 	UPROPERTY(EditAnywhere, config, Category = "Input Recording")
 	FKey RecordingEscapeKey;
+
+	/**
+	 * Whether or not the input recorder's flight recorder (see FJTInputFlightRecorder) should start with the game, so that
+	 * the last stretch of input can always be dumped (e.g. on a crash). Can also be turned on with -JTFlightRecorder
+	 */
+	UPROPERTY(EditAnywhere, config, Category = "Input Recording")
+	bool bStartFlightRecorderOnStartup = false;
+
+	/**
+	 * The number of events the input recorder's capture queue can hold between ticks. Input can be captured from any
+	 * thread, and is only written into the recording once the queue is drained on the game thread. Events are dropped
+	 * (with a warning) if more than this arrive in a single frame
+	 */
+	UPROPERTY(EditAnywhere, config, Category = "Input Recording", meta = (ClampMin = "2"))
+	int32 CaptureQueueCapacity = 4096;
+
+	/**
+	 * The amount of memory (in megabytes) that decoded sessions are allowed to use in the session cache shared by
+	 * all input players. Cached sessions are replayed (e.g. when looping) without being re-read from disk.
+	 * Set to 0 to disable the cache
+	 */
+	UPROPERTY(EditAnywhere, config, Category = "Input Playing", meta = (ClampMin = "0"))
+	float SessionCacheBudgetMegabytes = 256.f;
 };
 
 #ifdef ASSERT_ON_VAR_TYPE
@@ -12,14 +12,40 @@ namespace JT
 		{
 			extern FAutoConsoleCommandWithWorldAndArgs CCommandRequestPlay;
 			extern FAutoConsoleCommandWithWorldAndArgs CCommandStopPlaying;
+			extern FAutoConsoleCommandWithWorldAndArgs CCommandSeekToFrame;
+			extern FAutoConsoleCommand CCommandClearSessionCache;
 			extern TAutoConsoleVariable<bool> CVarShowPlayStatus;
+			extern TAutoConsoleVariable<bool> CVarCapturePerformance;
+			extern TAutoConsoleVariable<bool> CVarTurbo;
 		} // Input Player
 
 		namespace InputRecorder
 		{
 			extern FAutoConsoleCommandWithWorldAndArgs CCommandRequestRecording;
 			extern FAutoConsoleCommandWithWorldAndArgs CCommandStopRecording;
+			extern FAutoConsoleCommandWithWorldAndArgs CCommandLogAllocations;
+			extern FAutoConsoleCommandWithWorldAndArgs CCommandStartFlightRecorder;
+			extern FAutoConsoleCommandWithWorldAndArgs CCommandStopFlightRecorder;
+			extern FAutoConsoleCommandWithWorldAndArgs CCommandDumpFlightRecorder;
+			extern FAutoConsoleCommandWithArgs CCommandRecoverJournal;
 			extern TAutoConsoleVariable<bool> CVarShowRecordingStatus;
 		} // Input Recorder
+
+		namespace BatchRunner
+		{
+			extern FAutoConsoleCommandWithWorldAndArgs CCommandRunBatch;
+			extern FAutoConsoleCommandWithWorldAndArgs CCommandCancelBatch;
+		} // Batch Runner
+
+		namespace Profiling
+		{
+			extern TAutoConsoleVariable<int32> CVarBookmarkInterval;
+			extern FAutoConsoleCommandWithWorldAndArgs CCommandMemReport;
+		} // Profiling
+
+		namespace PerfComparator
+		{
+			extern FAutoConsoleCommandWithArgs CCommandCompare;
+		} // Perf Comparator
 	} // namespace AutoReplay
 } // namespace JT
@@ -0,0 +1,69 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "JTAutoReplayConsoleMenu.h"
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+/**
+ * Profiling hooks for AutoReplay, so that Insights captures (and stat AutoReplay) taken during recording and
+ * playback line up with the input timeline.
+ *
+ * - Cpu scopes are emitted on the AutoReplay trace channel (enable with -trace=cpu,autoreplay or Trace.Enable AutoReplay)
+ * - Per-frame event counts and session memory are emitted as trace counters, and as stats in STATGROUP_AutoReplay
+ * - Bookmarks are emitted when sessions start, stop and loop, and every jt.autoreplay.trace.bookmarkinterval frames
+ * - Allocations made while recording, playing and serializing are tagged AutoReplay in LLM (run with -llm, see stat LLM)
+ */
+UE_TRACE_CHANNEL_EXTERN(AutoReplayChannel, AUTOREPLAY_API);
+
+/** A cpu profiler scope on the AutoReplay trace channel. Costs a single channel check when the channel is off */
+#define JT_AUTOREPLAY_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Name, AutoReplayChannel)
+
+LLM_DECLARE_TAG_API(AutoReplay, AUTOREPLAY_API);
+
+/** Attributes allocations in the current scope to the AutoReplay LLM tag. Compiles out when LLM is disabled */
+#define JT_AUTOREPLAY_LLM_SCOPE() LLM_SCOPE_BYTAG(AutoReplay)
+
+DECLARE_STATS_GROUP(TEXT("AutoReplay"), STATGROUP_AutoReplay, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Input Recorder Tick"), STAT_JTInputRecorder_Tick, STATGROUP_AutoReplay, AUTOREPLAY_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Input Player Tick"), STAT_JTInputPlayer_Tick, STATGROUP_AutoReplay, AUTOREPLAY_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batch Runner Tick"), STAT_JTInputBatchRunner_Tick, STATGROUP_AutoReplay, AUTOREPLAY_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Events Recorded (Frame)"), STAT_JTInputRecorder_FrameEvents, STATGROUP_AutoReplay, AUTOREPLAY_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Events Injected (Frame)"), STAT_JTInputPlayer_FrameEvents, STATGROUP_AutoReplay, AUTOREPLAY_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Events Recorded (Session)"), STAT_JTInputRecorder_SessionEvents, STATGROUP_AutoReplay, AUTOREPLAY_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Events Injected (Session)"), STAT_JTInputPlayer_SessionEvents, STATGROUP_AutoReplay, AUTOREPLAY_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Playback Timeline Frame"), STAT_JTInputPlayer_TimelineFrame, STATGROUP_AutoReplay, AUTOREPLAY_API);
+
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Recording Session Memory"), STAT_JTInputRecorder_SessionMemory, STATGROUP_AutoReplay, AUTOREPLAY_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Playback Program Memory"), STAT_JTInputPlayer_ProgramMemory, STATGROUP_AutoReplay, AUTOREPLAY_API);
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(JTAutoReplay_FrameEventsRecorded);
+TRACE_DECLARE_INT_COUNTER_EXTERN(JTAutoReplay_FrameEventsInjected);
+TRACE_DECLARE_INT_COUNTER_EXTERN(JTAutoReplay_PlaybackTimelineFrame);
+TRACE_DECLARE_MEMORY_COUNTER_EXTERN(JTAutoReplay_RecordingSessionMemory);
+TRACE_DECLARE_MEMORY_COUNTER_EXTERN(JTAutoReplay_PlaybackProgramMemory);
+
+namespace JT
+{
+	namespace AutoReplay
+	{
+		namespace Profiling
+		{
+			/** @return whether or not a periodic bookmark is due on the given frame (relative to the start of a session) */
+			FORCEINLINE bool ShouldBookmarkFrame(uint64 InFrame)
+			{
+				const int32 BookmarkInterval = CVarBookmarkInterval.GetValueOnGameThread();
+				return (BookmarkInterval > 0) && (InFrame > 0) && ((InFrame % BookmarkInterval) == 0);
+			}
+		} // namespace Profiling
+	} // namespace AutoReplay
+} // namespace JT
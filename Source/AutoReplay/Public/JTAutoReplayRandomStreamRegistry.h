@@ -0,0 +1,48 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "JTAutoReplayCommonTypes.h"
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+
+/**
+ * An opt-in registry of the game's FRandomStreams, so that their seeds are recorded along with each session and
+ * restored before it is played back. Gameplay that draws from a registered stream then draws the same values on
+ * playback as it did while recording.
+ *
+ * Streams are matched up with their recorded seeds by name, so a stream should be registered under a name that is
+ * the same across runs (e.g. "Loot" or "AI.Director"). Streams must be unregistered before they are destroyed.
+ *
+ * Only to be used from the game thread.
+ */
+class AUTOREPLAY_API FJTRandomStreamRegistry
+{
+public:
+	static FJTRandomStreamRegistry& Get();
+
+	/** Registers the given stream under the given name, replacing whatever stream was registered under it before */
+	void RegisterStream(FName InName, FRandomStream& InStream);
+
+	void UnregisterStream(FName InName);
+
+	/** Unregisters the given stream, whatever name it was registered under */
+	void UnregisterStream(const FRandomStream& InStream);
+
+	/** Appends the current seed of every registered stream to the given array */
+	void CaptureSeeds(TArray<FJTRandomStreamSeed>& OutSeeds) const;
+
+	/**
+	 * Reseeds every registered stream that has a seed in the given array, so that it picks up from where it was
+	 * when the seeds were captured
+	 *
+	 * @return the number of seeds that were restored. Seeds of streams that aren't registered are skipped
+	 */
+	int32 RestoreSeeds(TArrayView<const FJTRandomStreamSeed> InSeeds) const;
+
+	int32 NumStreams() const { return Streams.Num(); }
+
+private:
+	TMap<FName, FRandomStream*> Streams;
+};
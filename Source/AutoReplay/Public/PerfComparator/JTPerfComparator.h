@@ -0,0 +1,203 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "JTPerfComparator.generated.h"
+
+AUTOREPLAY_API DECLARE_LOG_CATEGORY_EXTERN(LogJTPerfComparator, Log, All);
+
+struct FJTInputPerfCapture;
+
+/**
+ * Used to define what counts as a regression when comparing performance captures
+ */
+USTRUCT(BlueprintType)
+struct FJTPerfComparisonThresholds
+{
+	GENERATED_BODY()
+
+public:
+	/** The increase (in percent) of a metric's median over the whole run that counts as a regression */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Thresholds")
+	float MedianRegressionPercent = 5.f;
+
+	/** The increase (in percent) of a metric's 99th percentile over the whole run that counts as a regression */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Thresholds")
+	float P99RegressionPercent = 10.f;
+
+	/** Frames taking longer than this (in milliseconds) count as hitches */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Thresholds")
+	float HitchThresholdMs = 50.f;
+
+	/** The number of hitches the candidate may have over the baseline before it counts as a regression */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Thresholds")
+	int32 MaxAdditionalHitches = 0;
+
+	/** The number of recording frames in each window the runs are compared over, so regressions can be pinned to a segment of the recording */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Thresholds", meta = (ClampMin = "2"))
+	int32 WindowSizeFrames = 300;
+
+	/** The increase (in percent) of a window's mean that counts as a regression */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Thresholds")
+	float WindowRegressionPercent = 10.f;
+
+	/** How significant (as a paired t statistic over the window's frames) a window's increase must be to count as a regression, so noise isn't flagged */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Thresholds")
+	float WindowMinTStatistic = 3.f;
+};
+
+/**
+ * Summary statistics of a single metric over a whole run
+ */
+USTRUCT(BlueprintType)
+struct FJTPerfMetricStats
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	float Mean = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	float P50 = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	float P90 = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	float P99 = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	float Max = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 NumHitches = 0;
+};
+
+/**
+ * A window of the recording over which a metric regressed
+ */
+USTRUCT(BlueprintType)
+struct FJTPerfWindowComparison
+{
+	GENERATED_BODY()
+
+public:
+	/** The range of recording frames the window covers */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 FirstFrame = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 LastFrame = 0;
+
+	/** The range of timeline frames (i.e. recorded inputs) played over the window */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 FirstTimelineFrameIndex = INDEX_NONE;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 LastTimelineFrameIndex = INDEX_NONE;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	float BaselineMean = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	float CandidateMean = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	float ChangePercent = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	float TStatistic = 0.f;
+};
+
+/**
+ * The comparison of a single metric between the baseline and candidate runs
+ */
+USTRUCT(BlueprintType)
+struct FJTPerfMetricComparison
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FString Metric;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FJTPerfMetricStats Baseline;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FJTPerfMetricStats Candidate;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	float P50ChangePercent = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	float P99ChangePercent = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	bool bRegressed = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	TArray<FJTPerfWindowComparison> RegressedWindows;
+};
+
+/**
+ * The machine readable outcome of comparing captures of the same session, written as json
+ */
+USTRUCT(BlueprintType)
+struct FJTPerfComparisonReport
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	FString SessionFile;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 NumBaselineRuns = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 NumCandidateRuns = 0;
+
+	/** The number of recording frames captured by both the baseline and the candidate */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	int32 NumAlignedFrames = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	TArray<FJTPerfMetricComparison> Metrics;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	bool bHasRegression = false;
+
+	/** A human readable line for every regression found */
+	UPROPERTY(BlueprintReadOnly, Category = "Results")
+	TArray<FString> Regressions;
+};
+
+/**
+ * Compares per-frame performance captures (see FJTInputPerfCapture) of the same session across builds.
+ *
+ * Every play of the recording in a capture counts as a run. Runs are aligned by recording frame, and the
+ * runs on each side are combined by taking the median of each frame, so that a few noisy runs can't skew the
+ * result. Whole-run percentiles and hitch counts are compared, as well as consecutive windows of the recording,
+ * so that a regression confined to one segment of gameplay isn't averaged away.
+ */
+class AUTOREPLAY_API FJTPerfComparator
+{
+public:
+	static bool Compare(
+		const TArray<FJTInputPerfCapture>& InBaselineCaptures,
+		const TArray<FJTInputPerfCapture>& InCandidateCaptures,
+		const FJTPerfComparisonThresholds& InThresholds,
+		FJTPerfComparisonReport& OutReport);
+
+	/** Loads the given csv capture, or every csv capture in the given directory */
+	static bool LoadCaptures(const FString& InPath, TArray<FJTInputPerfCapture>& OutCaptures);
+
+	static bool SaveReport(const FJTPerfComparisonReport& InReport, const FString& InFilePath);
+
+	/** Logs a readable summary of the given report */
+	static void LogReport(const FJTPerfComparisonReport& InReport);
+};
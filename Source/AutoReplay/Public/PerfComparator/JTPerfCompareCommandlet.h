@@ -0,0 +1,30 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "JTPerfCompareCommandlet.generated.h"
+
+/**
+ * Compares performance captures of the same session from two builds (see FJTPerfComparator), e.g.
+ *
+ * UnrealEditor-Cmd MyGame.uproject -run=JTPerfCompare -Baseline=BuildA/ -Candidate=BuildB/ -Report=Report.json
+ *
+ * Any of the FJTPerfComparisonThresholds can be overridden by name, e.g. -MedianRegressionPercent=3 -HitchThresholdMs=33
+ *
+ * Returns a non-zero exit code if the candidate regressed (or the captures could not be compared).
+ */
+UCLASS()
+class UJTPerfCompareCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UJTPerfCompareCommandlet();
+
+	/** UCommandlet Interface - BEGIN */
+	virtual int32 Main(const FString& Params) override;
+	/** UCommandlet Interface - END */
+};
@@ -0,0 +1,35 @@
+// Copyright 2024 JukiTech. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "JTReplayFarmCommandlet.generated.h"
+
+/**
+ * Replays a corpus of sessions across several local game processes at once (see FJTReplayFarm), e.g.
+ *
+ * UnrealEditor-Cmd MyGame.uproject -run=JTReplayFarm -Source=Nightly.json -Workers=8 -Summary=Results.json
+ *
+ * Optional arguments:
+ * -Map=<default map>				  the map to open for sessions that don't name their own
+ * -WorkerArgs="<args>"			  extra command line arguments passed to every worker process
+ * -MaxRestarts=<N>				  how many times a crashed worker is restarted (default 3)
+ * -MaxAttempts=<N>				  how many times a session is attempted if its worker crashes (default 2)
+ * -SessionTimeout=<seconds>		  how long a single session may play before its worker is assumed hung
+ *
+ * Returns a non-zero exit code if any session failed.
+ */
+UCLASS()
+class UJTReplayFarmCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UJTReplayFarmCommandlet();
+
+	/** UCommandlet Interface - BEGIN */
+	virtual int32 Main(const FString& Params) override;
+	/** UCommandlet Interface - END */
+};